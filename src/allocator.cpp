@@ -0,0 +1,99 @@
+#include "allocator.h"
+#include "globals.h"
+#include <cstdlib>
+#include <sys/mman.h>
+
+static hugepage_mode & active_hugepage_mode() {
+    static hugepage_mode mode = hugepage_mode::transparent;
+    return mode;
+}
+
+void set_hugepage_mode(hugepage_mode mode) {
+    active_hugepage_mode() = mode;
+}
+
+hugepage_mode get_hugepage_mode() {
+    return active_hugepage_mode();
+}
+
+/**
+ * @brief Rounds `bytes` up to a multiple of `alignment`, a power of two.
+ */
+static size_t round_up(size_t bytes, size_t alignment) {
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+memory_block allocate_block(size_t bytes, hugepage_mode mode) {
+    memory_block block;
+    if (bytes == 0) {
+        return block;
+    }
+    bool large = bytes >= hugepage_size;
+
+#ifdef MAP_HUGETLB
+    if (large && mode == hugepage_mode::explicit_pages) {
+        size_t length = round_up(bytes, hugepage_size);
+        void * data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data != MAP_FAILED) {
+            return memory_block{data, length, memory_backing::explicit_huge};
+        }
+    }
+#endif
+
+    size_t alignment = large && mode != hugepage_mode::none ? hugepage_size : matrix_alignment;
+    size_t length = round_up(bytes, alignment);
+    void * data = std::aligned_alloc(alignment, length);
+    if (data == nullptr) {
+        return block;
+    }
+    block = memory_block{data, length, memory_backing::heap};
+#ifdef MADV_HUGEPAGE
+    if (alignment == hugepage_size && madvise(data, length, MADV_HUGEPAGE) == 0) {
+        block.backing = memory_backing::transparent_huge;
+    }
+#endif
+    return block;
+}
+
+void release_block(memory_block & block) {
+    if (block.data == nullptr) {
+        return;
+    }
+    if (block.backing == memory_backing::explicit_huge) {
+        munmap(block.data, block.bytes);
+    }
+    else {
+        std::free(block.data);
+    }
+    block = memory_block{};
+}
+
+const char * memory_backing_name(memory_backing backing) {
+    switch (backing) {
+        case memory_backing::heap:
+            return "heap";
+        case memory_backing::transparent_huge:
+            return "transparent hugepages";
+        case memory_backing::explicit_huge:
+            return "explicit hugepages";
+        default:
+            return "none";
+    }
+}
+
+template <typename T>
+T * tile_scratch(size_t count) {
+    thread_local aligned_buffer<T> scratch;
+    if (scratch.size() < count) {
+        scratch = aligned_buffer<T>(count, hugepage_mode::none);
+    }
+    return scratch.data();
+}
+
+#define INSTANTIATE_SCRATCH(T) \
+    template T * tile_scratch<T>(size_t);
+
+INSTANTIATE_SCRATCH(int32_t)
+INSTANTIATE_SCRATCH(uint16_t)
+INSTANTIATE_SCRATCH(uint8_t)
+INSTANTIATE_SCRATCH(float)
@@ -0,0 +1,189 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Alignment of every matrix and scratch allocation: one cache line, which is also the width of an AVX-512 vector.
+ */
+constexpr size_t matrix_alignment = 64;
+
+/**
+ * @brief Size of the hugepages requested for large allocations.
+ */
+constexpr size_t hugepage_size = 2 * 1024 * 1024;
+
+/**
+ * @brief How large allocations are backed, selected with `--hugepages`.
+ */
+enum class hugepage_mode {
+    none,           // 64-byte aligned heap memory with 4 KB pages
+    transparent,    // 2 MB aligned heap memory advised with MADV_HUGEPAGE (transparent hugepages)
+    explicit_pages  // MAP_HUGETLB from the hugetlbfs pool, falling back to `transparent` if the pool is empty
+};
+
+/**
+ * @brief What an allocation actually got, after fallbacks.
+ */
+enum class memory_backing {
+    none,               // Nothing allocated
+    heap,               // Aligned heap memory, normal pages
+    transparent_huge,   // Aligned heap memory advised for transparent hugepages
+    explicit_huge       // Mapping from the explicit hugepage pool
+};
+
+/**
+ * @brief A raw allocation from `allocate_block`. Release it with `release_block`.
+ */
+struct memory_block {
+    void * data = nullptr;
+    size_t bytes = 0;
+    memory_backing backing = memory_backing::none;
+};
+
+/**
+ * @brief Sets the hugepage mode used by subsequent matrix allocations. Defaults to `hugepage_mode::transparent`.
+ */
+void set_hugepage_mode(
+    hugepage_mode mode
+);
+
+/**
+ * @brief Returns the hugepage mode used by matrix allocations.
+ */
+hugepage_mode get_hugepage_mode();
+
+/**
+ * @brief Allocates `bytes` of uninitialized memory aligned to `matrix_alignment`.
+ * 
+ * @param bytes The size of the allocation.
+ * @param mode The preferred backing; allocations smaller than `hugepage_size` always use the heap.
+ * @return memory_block The allocation, or a block with `data == nullptr` if memory is exhausted.
+ * 
+ * @details
+ * - `explicit_pages` tries an anonymous `MAP_HUGETLB` mapping, rounded up to whole hugepages.
+ * - `transparent` (and the fallback of `explicit_pages`) allocates 2 MB aligned memory and calls
+ *   `madvise(MADV_HUGEPAGE)`, so the kernel can back it with hugepages when THP is in `madvise` or `always` mode.
+ * - The memory is not touched, so the pages are placed by the thread that first writes them (see numa.h).
+ */
+memory_block allocate_block(
+    size_t bytes,
+    hugepage_mode mode
+);
+
+/**
+ * @brief Frees a block from `allocate_block`. Safe on an empty block.
+ */
+void release_block(
+    memory_block & block
+);
+
+/**
+ * @brief Returns the name of a backing, for reporting.
+ */
+const char * memory_backing_name(
+    memory_backing backing
+);
+
+/**
+ * @brief Owning, move-only array of `T` on an `allocate_block` allocation, left uninitialized.
+ * 
+ * @tparam T A trivially copyable element type, such as a distance or next-hop type.
+ * 
+ * @details Used for the distance matrix, its backup and the padded copy of `blocked_floyd_warshall`.
+ *          Allocation failure throws `std::bad_alloc`, like `std::vector`.
+ */
+template <typename T>
+class aligned_buffer {
+public:
+    aligned_buffer() = default;
+
+    explicit aligned_buffer(size_t count, hugepage_mode mode = get_hugepage_mode())
+        : block_(allocate_block(count * sizeof(T), mode)), count_(count) {
+        if (count > 0 && block_.data == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+
+    aligned_buffer(aligned_buffer && other) noexcept
+        : block_(std::exchange(other.block_, memory_block{})), count_(std::exchange(other.count_, 0)) {}
+
+    aligned_buffer & operator=(aligned_buffer && other) noexcept {
+        if (this != &other) {
+            release_block(block_);
+            block_ = std::exchange(other.block_, memory_block{});
+            count_ = std::exchange(other.count_, 0);
+        }
+        return *this;
+    }
+
+    aligned_buffer(const aligned_buffer &) = delete;
+    aligned_buffer & operator=(const aligned_buffer &) = delete;
+
+    ~aligned_buffer() { release_block(block_); }
+
+    T * data() { return static_cast<T *>(block_.data); }
+    const T * data() const { return static_cast<const T *>(block_.data); }
+    size_t size() const { return count_; }
+    T & operator[](size_t i) { return data()[i]; }
+    const T & operator[](size_t i) const { return data()[i]; }
+    memory_backing backing() const { return block_.backing; }
+
+private:
+    memory_block block_;
+    size_t count_ = 0;
+};
+
+/**
+ * @brief Standard allocator returning `matrix_alignment`-aligned memory, advised for transparent hugepages
+ *        when large, so `std::vector` containers get the same guarantees as `aligned_buffer`.
+ */
+template <typename T>
+struct aligned_allocator {
+    using value_type = T;
+
+    aligned_allocator() = default;
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U> &) {}
+
+    T * allocate(size_t count) {
+        memory_block block = allocate_block(count * sizeof(T), hugepage_mode::transparent);
+        if (block.data == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(block.data);
+    }
+
+    void deallocate(T * data, size_t count) {
+        memory_block block{data, count * sizeof(T), memory_backing::heap};
+        release_block(block);
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const aligned_allocator<U> &) const { return false; }
+};
+
+/**
+ * @brief `std::vector` with `aligned_allocator`.
+ */
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+/**
+ * @brief Returns reusable per-thread scratch space for at least `count` elements of `T`, aligned to `matrix_alignment`.
+ * 
+ * @details Each thread owns one buffer per element type that only grows, so tile copies in the blocked kernel
+ *          allocate once per thread instead of once per tile. The contents are unspecified, and the pointer
+ *          stays valid until the same thread asks for more elements.
+ */
+template <typename T>
+T * tile_scratch(
+    size_t count
+);
+
+#endif
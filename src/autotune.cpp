@@ -0,0 +1,206 @@
+#include "autotune.h"
+#include "globals.h"
+#include "plf_nanotimer.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <unistd.h>
+
+/**
+ * @brief Parses a sysfs cache size such as `48K` or `2048K` into bytes.
+ */
+static long parse_cache_size(const std::string & text) {
+    long value = 0;
+    char unit = 0;
+    std::istringstream stream(text);
+    stream >> value >> unit;
+    if (unit == 'K') {
+        value *= 1024;
+    }
+    else if (unit == 'M') {
+        value *= 1024 * 1024;
+    }
+    return value;
+}
+
+/**
+ * @brief Reads the size of a data or unified cache level from sysfs, or `0` if it is not listed.
+ */
+static long read_sysfs_cache_size(int level) {
+    for (int index = 0; index < 8; index++) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_file(dir + "level");
+        std::ifstream type_file(dir + "type");
+        std::ifstream size_file(dir + "size");
+        if (!level_file || !type_file || !size_file) {
+            break;
+        }
+        int cache_level = 0;
+        std::string type, size;
+        level_file >> cache_level;
+        type_file >> type;
+        size_file >> size;
+        if (cache_level == level && type != "Instruction") {
+            return parse_cache_size(size);
+        }
+    }
+    return 0;
+}
+
+cache_sizes read_cache_sizes() {
+    cache_sizes caches{0, 0, 0};
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    caches.l1d = std::max(0L, sysconf(_SC_LEVEL1_DCACHE_SIZE));
+    caches.l2 = std::max(0L, sysconf(_SC_LEVEL2_CACHE_SIZE));
+    caches.l3 = std::max(0L, sysconf(_SC_LEVEL3_CACHE_SIZE));
+#endif
+    if (caches.l1d == 0) {
+        caches.l1d = read_sysfs_cache_size(1);
+    }
+    if (caches.l2 == 0) {
+        caches.l2 = read_sysfs_cache_size(2);
+    }
+    if (caches.l3 == 0) {
+        caches.l3 = read_sysfs_cache_size(3);
+    }
+    return caches;
+}
+
+/**
+ * @brief Returns the L2 size to plan against, assuming a common 256 KiB when it is unknown.
+ */
+static long usable_l2(const cache_sizes & caches) {
+    return caches.l2 > 0 ? caches.l2 : 256 * 1024;
+}
+
+std::vector<int> candidate_block_lengths(int vertices, const cache_sizes & caches, size_t element_size) {
+    long l2 = usable_l2(caches);
+    std::vector<int> candidates;
+    for (int b = 1; b <= vertices; b++) {
+        if (3L * b * b * static_cast<long>(element_size) > l2) {
+            break;
+        }
+        if (b % 8 == 0 || (b >= 8 && vertices % b == 0)) {
+            candidates.push_back(b);
+        }
+    }
+    // Graph smaller than one SIMD-friendly tile: solve it as a single block.
+    if (candidates.empty()) {
+        candidates.push_back(vertices);
+    }
+    return candidates;
+}
+
+int heuristic_block_length(int vertices, const cache_sizes & caches, size_t element_size) {
+    long budget = usable_l2(caches) / 2;
+    std::vector<int> candidates = candidate_block_lengths(vertices, caches, element_size);
+    int best = candidates.front();
+    for (int b : candidates) {
+        if (3L * b * b * static_cast<long>(element_size) <= budget) {
+            best = b;
+        }
+    }
+    // Prefer a divisor that is not much smaller, so there are no ragged tiles.
+    for (int b : candidates) {
+        if (b <= best && 2 * b >= best && vertices % b == 0) {
+            return b;
+        }
+    }
+    return best;
+}
+
+template <typename T>
+int calibrate_block_length(blocked_kernel<T> kernel, int vertices, int edges, const std::vector<int> & candidates) {
+    const int n = std::min(vertices, 512);
+    double density = static_cast<double>(edges) / (static_cast<double>(vertices) * vertices);
+
+    // Sample graph with the same edge density as the real one.
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> pick(0, n - 1);
+    std::vector<T> sample(n * n, distance_traits<T>::inf());
+    for (int i = 0; i < n; i++) {
+        sample[i * n + i] = T(0);
+    }
+    long sample_edges = std::max(1L, static_cast<long>(density * n * n));
+    for (long e = 0; e < sample_edges; e++) {
+        int u = pick(rng);
+        int v = pick(rng);
+        if (u != v) {
+            sample[u * n + v] = T(1);
+        }
+    }
+
+    int best = candidates.front();
+    double best_time = std::numeric_limits<double>::max();
+    for (int b : candidates) {
+        if (b > n) {
+            continue;
+        }
+        double fastest = std::numeric_limits<double>::max();
+        for (int run = 0; run < 2; run++) {
+            std::vector<T> W = sample;
+            plf::nanotimer timer;
+            timer.start();
+            kernel(W.data(), n, b);
+            fastest = std::min(fastest, timer.get_elapsed_ns());
+        }
+        if (fastest < best_time) {
+            best_time = fastest;
+            best = b;
+        }
+    }
+    return best;
+}
+
+std::string tune_cache_path() {
+    char hostname[256] = "localhost";
+    gethostname(hostname, sizeof(hostname) - 1);
+    hostname[sizeof(hostname) - 1] = '\0';
+    return std::string("fw_tune_") + hostname + ".txt";
+}
+
+int load_tuned_block_length(const std::string & key) {
+    std::ifstream file(tune_cache_path());
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string entry_key;
+        int block_length;
+        if (std::getline(stream, entry_key, '=') && stream >> block_length && entry_key == key) {
+            return block_length;
+        }
+    }
+    return -1;
+}
+
+int store_tuned_block_length(const std::string & key, int block_length) {
+    // Keep every other entry, then rewrite the file.
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(tune_cache_path());
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, key.size() + 1, key + "=") != 0) {
+                lines.push_back(line);
+            }
+        }
+    }
+    lines.push_back(key + "=" + std::to_string(block_length));
+
+    std::ofstream file(tune_cache_path(), std::ios::trunc);
+    if (!file) {
+        return -1;
+    }
+    for (const std::string & line : lines) {
+        file << line << "\n";
+    }
+    return 1;
+}
+
+template int calibrate_block_length<int32_t>(blocked_kernel<int32_t>, int, int, const std::vector<int> &);
+template int calibrate_block_length<uint16_t>(blocked_kernel<uint16_t>, int, int, const std::vector<int> &);
+template int calibrate_block_length<uint8_t>(blocked_kernel<uint8_t>, int, int, const std::vector<int> &);
+template int calibrate_block_length<float>(blocked_kernel<float>, int, int, const std::vector<int> &);
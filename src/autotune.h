@@ -0,0 +1,118 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Data cache sizes of the executing host, in bytes. A value of `0` means unknown.
+ */
+struct cache_sizes {
+    long l1d;
+    long l2;
+    long l3;
+};
+
+/**
+ * @brief Signature shared by the blocked kernels, used to calibrate the kernel that will actually run.
+ */
+template <typename T>
+using blocked_kernel = void (*)(T *, int, int);
+
+/**
+ * @brief Reads the data cache sizes of the executing host.
+ * 
+ * @return cache_sizes The L1 data, L2 and L3 cache sizes in bytes.
+ * 
+ * @details
+ * - `sysconf(_SC_LEVEL*_CACHE_SIZE)` is queried first.
+ * - Any level it does not report is read from `/sys/devices/system/cpu/cpu0/cache/index*`.
+ * - Levels that are still unknown are left at `0`.
+ */
+cache_sizes read_cache_sizes();
+
+/**
+ * @brief Lists the block lengths worth considering for a matrix of `vertices x vertices`.
+ * 
+ * @param vertices The number of vertices in the graph.
+ * @param caches The cache sizes of the host, as returned by `read_cache_sizes`.
+ * @param element_size The size of one distance, `sizeof(T)` of the kernel's distance type.
+ * @return std::vector<int> Ascending block lengths whose three-tile working set (`3 * b * b * element_size`)
+ *         fits in L2: every multiple of 8 (a whole number of SIMD vectors) plus every divisor of `vertices`
+ *         (no ragged edge tiles). Never empty; falls back to `{vertices}` for tiny graphs.
+ */
+std::vector<int> candidate_block_lengths(
+    int vertices,
+    const cache_sizes & caches,
+    size_t element_size
+);
+
+/**
+ * @brief Chooses a block length from the cache sizes alone, without running anything.
+ * 
+ * @param vertices The number of vertices in the graph.
+ * @param caches The cache sizes of the host.
+ * @param element_size The size of one distance, `sizeof(T)` of the kernel's distance type.
+ * @return int The largest candidate whose three tiles fit in half of L2, so that the
+ *         tiles stay resident while the other half holds the panels being streamed. A divisor of
+ *         `vertices` at least half that size is preferred, since it avoids ragged edge tiles.
+ */
+int heuristic_block_length(
+    int vertices,
+    const cache_sizes & caches,
+    size_t element_size
+);
+
+/**
+ * @brief Times `kernel` on a sample matrix for each candidate block length and returns the fastest.
+ * 
+ * @tparam T The distance type of the kernel (see `distance_traits`).
+ * @param kernel The blocked kernel to calibrate.
+ * @param vertices The number of vertices of the real graph, used to scale the sample density.
+ * @param edges The number of edges of the real graph, used to scale the sample density.
+ * @param candidates The block lengths to try, as returned by `candidate_block_lengths`.
+ * @return int The candidate with the lowest time.
+ * 
+ * @details
+ * - Every candidate runs on the same sample of `min(vertices, 512)` vertices, so the cost of the
+ *   ragged edge tiles each candidate produces is part of its time.
+ * - Samples are filled from a private, fixed-seed `std::mt19937`, so calibration does not depend on `--seed`.
+ * - Every candidate runs twice and the faster run is kept, to absorb first-touch effects.
+ */
+template <typename T>
+int calibrate_block_length(
+    blocked_kernel<T> kernel,
+    int vertices,
+    int edges,
+    const std::vector<int> & candidates
+);
+
+/**
+ * @brief Returns the path of the per-host tuning cache, `fw_tune_<hostname>.txt` in the working directory.
+ */
+std::string tune_cache_path();
+
+/**
+ * @brief Looks up a calibrated block length in the per-host tuning cache.
+ * 
+ * @param key Identifies the configuration (kernel, distance type, threads, vertices) the value was tuned for.
+ * @return int The cached block length, or `-1` if there is no entry for `key`.
+ */
+int load_tuned_block_length(
+    const std::string & key
+);
+
+/**
+ * @brief Records a calibrated block length in the per-host tuning cache, replacing any entry for `key`.
+ * 
+ * @param key Identifies the configuration the value was tuned for.
+ * @param block_length The block length to record.
+ * @return int Returns `1` on success, or `-1` if the cache file could not be written.
+ */
+int store_tuned_block_length(
+    const std::string & key,
+    int block_length
+);
+
+#endif
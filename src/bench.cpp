@@ -0,0 +1,194 @@
+#include <benchmark/benchmark.h>
+#include "graph.h"
+#include "kernels.h"
+#include "tile.h"
+#include "allocator.h"
+#include "globals.h"
+#include "solver.h"
+#include "scaling.h"
+#include "kernel_registry.h"
+#include <omp.h>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Bytes of matrix traffic of one solve, in a simple streaming model.
+ *
+ * @details The dense kernels follow `matrix_traffic`. The sparse kernel reads its CSR copy once per source and
+ *          writes the matrix once.
+ */
+template <typename T>
+static double bytes_moved(const registered_kernel<T> & kernel, int n, int b, long long edges)
+{
+    if (kernel.sparse) {
+        return n * (edges * (sizeof(int) + sizeof(T)) + (n + 1.0) * sizeof(long long)) + 1.0 * n * n * sizeof(T);
+    }
+    return matrix_traffic(n, kernel.tiled ? b : 0, sizeof(T));
+}
+
+/**
+ * @brief Times `kernel` on a fixed generated graph: every iteration restores the input matrix untimed, then solves it.
+ *
+ * @details Reports `minplus_ops` (`2 n^3` min-plus operations per solve, as a rate: GFLOP-equivalents with the
+ *          `G` suffix) and `bytes_per_second` from `bytes_moved`. The sparse kernel reports the same `2 n^3`, so
+ *          its rate reads as the dense-equivalent speed.
+ */
+template <typename T>
+static void bench_solve(benchmark::State & state, registered_kernel<T> kernel)
+{
+    const int n = static_cast<int>(state.range(0));
+    const int b = static_cast<int>(state.range(1));
+    const int threads = static_cast<int>(state.range(2));
+    const long long edges = 8LL * n;
+    omp_set_num_threads(threads);
+
+    const size_t cells = static_cast<size_t>(n) * n;
+    aligned_buffer<T> input(cells);
+    aligned_buffer<T> W(cells);
+    graph_options options;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 100;
+    generate_linear_graph(input.data(), n, static_cast<int>(edges), options);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::copy(input.data(), input.data() + cells, W.data());
+        state.ResumeTiming();
+        kernel.run(W.data(), n, b);
+        benchmark::DoNotOptimize(W.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["minplus_ops"] = benchmark::Counter(2.0 * n * n * n, benchmark::Counter::kIsIterationInvariantRate);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes_moved(kernel, n, b, edges)));
+}
+
+/**
+ * @brief Registers `kernel` × n × b × threads for distance type `T`, named `<kernel>/<dtype>`.
+ */
+template <typename T>
+static void register_kernels(const std::vector<int> & sizes, const std::vector<int> & block_lengths, const std::vector<int> & threads)
+{
+    for (const registered_kernel<T> & kernel : registered_kernels<T>()) {
+        std::string name = std::string(kernel.name) + "/" + distance_traits<T>::name();
+        benchmark::internal::Benchmark * bench = benchmark::RegisterBenchmark(name.c_str(), bench_solve<T>, kernel);
+        bench->ArgNames({"n", "b", "threads"})->UseRealTime()->Unit(benchmark::kMillisecond);
+        for (int n : sizes) {
+            for (int t : threads) {
+                if (!kernel.tiled) {
+                    bench->Args({n, 0, t});
+                    continue;
+                }
+                for (int b : block_lengths) {
+                    if (b <= n) {
+                        bench->Args({n, b, t});
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Times a batch of `count` independent `n x n` graphs through `floyd_warshall_solver`: with
+ *        `solve_batch` when `batched` is set, else one `solve` call per matrix with all threads each.
+ */
+template <typename T>
+static void bench_batch(benchmark::State & state, bool batched)
+{
+    const int n = static_cast<int>(state.range(0));
+    const int count = static_cast<int>(state.range(1));
+    const int threads = static_cast<int>(state.range(2));
+    const size_t cells = static_cast<size_t>(n) * n;
+    aligned_buffer<T> input(cells * count);
+    aligned_buffer<T> W(cells * count);
+    graph_options options;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 100;
+    std::vector<batch_matrix<T>> batch;
+    for (int m = 0; m < count; ++m) {
+        options.seed = m;
+        generate_linear_graph(input.data() + m * cells, n, 8 * n, options);
+        batch.push_back({W.data() + m * cells, n});
+    }
+    floyd_warshall_solver<T> solver({solver_kernel::zero_copy, 0, threads});
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::copy(input.data(), input.data() + cells * count, W.data());
+        state.ResumeTiming();
+        if (batched) {
+            solver.solve_batch(batch);
+        }
+        else {
+            for (const batch_matrix<T> & matrix : batch) {
+                solver.solve(matrix.W, matrix.n);
+            }
+        }
+        benchmark::DoNotOptimize(W.data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["minplus_ops"] = benchmark::Counter(2.0 * n * n * n * count, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/**
+ * @brief Registers the batched and the one-call-per-matrix solver for distance type `T`, named `batch/<dtype>`
+ *        and `batch-loop/<dtype>`.
+ */
+template <typename T>
+static void register_batches(const std::vector<int> & threads)
+{
+    for (bool batched : {true, false}) {
+        std::string name = std::string(batched ? "batch/" : "batch-loop/") + distance_traits<T>::name();
+        benchmark::internal::Benchmark * bench = benchmark::RegisterBenchmark(name.c_str(), bench_batch<T>, batched);
+        bench->ArgNames({"n", "count", "threads"})->UseRealTime()->Unit(benchmark::kMillisecond);
+        for (int t : threads) {
+            bench->Args({200, 1000, t});
+        }
+    }
+}
+
+/**
+ * @brief Entry point of the `benchmarks` target: every kernel × n × b × threads × dtype.
+ *
+ * Select cases with `--benchmark_filter`, e.g. `--benchmark_filter='zero-copy/int32/n:1024/.*threads:8'`, and emit
+ * JSON to diff between commits with `--benchmark_out=result.json --benchmark_out_format=json` (compare two runs
+ * with `tools/compare.py` from Google Benchmark).
+ *
+ * @details
+ * - `n` is 256, 512, 1024 and 2048; `b` is 32, 64 and 128 for the tiled kernels; threads double from 1 up to
+ *   `omp_get_max_threads()`, plus the maximum itself.
+ * - Graphs are uniform-weight G(n, 8n) from seed 0, identical across runs and commits.
+ * - `batch` and `batch-loop` solve 1000 graphs of 200 vertices (seeds 0 to 999) per iteration.
+ * - The SIMD tile kernel in use and the OpenMP thread maximum are recorded in the benchmark context.
+ */
+int main(int argc, char ** argv)
+{
+    std::vector<int> sizes{256, 512, 1024, 2048};
+    std::vector<int> block_lengths{32, 64, 128};
+    std::vector<int> threads;
+    int max_threads = omp_get_max_threads();
+    for (int t = 1; t < max_threads; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(max_threads);
+
+    register_kernels<int32_t>(sizes, block_lengths, threads);
+    register_kernels<uint16_t>(sizes, block_lengths, threads);
+    register_kernels<uint8_t>(sizes, block_lengths, threads);
+    register_kernels<float>(sizes, block_lengths, threads);
+    register_batches<int32_t>(threads);
+    register_batches<float>(threads);
+
+    benchmark::AddCustomContext("tile_isa", tile_isa_name(get_tile_isa()));
+    benchmark::AddCustomContext("omp_max_threads", std::to_string(max_threads));
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "closure.h"
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+int bit_matrix_words(int n) {
+    int words = (n + 63) / 64;
+    return (words + 7) / 8 * 8;
+}
+
+bit_matrix::bit_matrix(int n)
+    : n(n), words(bit_matrix_words(n)), bits(static_cast<size_t>(n) * bit_matrix_words(n)) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i) {
+        std::fill(row(i), row(i) + words, uint64_t{0});
+    }
+}
+
+template <typename T>
+void pack_reachability(const T * rows, int first, int count, bit_matrix & R) {
+    const T inf = distance_traits<T>::inf();
+    const int n = R.n;
+    #pragma omp parallel for schedule(static)
+    for (int r = 0; r < count; ++r) {
+        const T * distances = rows + static_cast<size_t>(r) * n;
+        uint64_t * bits = R.row(first + r);
+        std::fill(bits, bits + R.words, uint64_t{0});
+        for (int j = 0; j < n; ++j) {
+            bits[j / 64] |= static_cast<uint64_t>(distances[j] != inf) << (j % 64);
+        }
+    }
+}
+
+int generate_reachability(bit_matrix & R, int edges, const graph_options & options, int strip_rows) {
+    const int n = R.n;
+    strip_rows = std::max(1, std::min(strip_rows, n));
+    std::vector<uint8_t> strip(static_cast<size_t>(strip_rows) * n);
+    for (int first = 0; first < n; first += strip_rows) {
+        int count = std::min(strip_rows, n - first);
+        if (generate_graph_rows(strip.data(), n, edges, first, count, options) == -1) {
+            return -1;
+        }
+        pack_reachability(strip.data(), first, count, R);
+    }
+    return 1;
+}
+
+/**
+ * @brief `row |= source` over `words` words.
+ */
+static void or_row(uint64_t * __restrict row, const uint64_t * __restrict source, int words) {
+    #pragma omp simd
+    for (int w = 0; w < words; ++w) {
+        row[w] |= source[w];
+    }
+}
+
+void transitive_closure(bit_matrix & R) {
+    const int n = R.n;
+    const int words = R.words;
+    for (int k0 = 0; k0 < n; k0 += 64) {
+        const int kw = k0 / 64;
+        const int k1 = std::min(n, k0 + 64);
+
+        // Diagonal Phase: Warshall rounds k0 to k1 - 1 on the rows of the block
+        for (int k = k0; k < k1; ++k) {
+            const uint64_t * row_k = R.row(k);
+            for (int i = k0; i < k1; ++i) {
+                uint64_t * row_i = R.row(i);
+                if (i != k && ((row_i[kw] >> (k - k0)) & 1)) {
+                    or_row(row_i, row_k, words);
+                }
+            }
+        }
+
+        // Row Phase: every other row takes the finished block rows it reaches
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            if (i >= k0 && i < k1) {
+                continue;
+            }
+            uint64_t * row_i = R.row(i);
+            for (uint64_t pending = row_i[kw]; pending != 0; pending &= pending - 1) {
+                or_row(row_i, R.row(k0 + __builtin_ctzll(pending)), words);
+            }
+        }
+    }
+}
+
+void copy_bit_matrix(const bit_matrix & source, bit_matrix & destination) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < source.n; ++i) {
+        std::copy(source.row(i), source.row(i) + source.words, destination.row(i));
+    }
+}
+
+long long count_reachable_pairs(const bit_matrix & R) {
+    long long pairs = 0;
+    #pragma omp parallel for schedule(static) reduction(+ : pairs)
+    for (int i = 0; i < R.n; ++i) {
+        const uint64_t * row = R.row(i);
+        for (int w = 0; w < R.words; ++w) {
+            pairs += __builtin_popcountll(row[w]);
+        }
+    }
+    return pairs;
+}
+
+#define INSTANTIATE_CLOSURE(T) \
+    template void pack_reachability<T>(const T *, int, int, bit_matrix &);
+
+INSTANTIATE_CLOSURE(int32_t)
+INSTANTIATE_CLOSURE(uint16_t)
+INSTANTIATE_CLOSURE(uint8_t)
+INSTANTIATE_CLOSURE(float)
@@ -0,0 +1,113 @@
+#ifndef CLOSURE_H
+#define CLOSURE_H
+
+#include "globals.h"
+#include "graph.h"
+#include "allocator.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Returns the number of 64-bit words per row of an `n x n` `bit_matrix`: `ceil(n / 64)`, rounded up to
+ *        a multiple of 8 so that every row starts on a 64-byte boundary.
+ */
+int bit_matrix_words(int n);
+
+/**
+ * @brief A square Boolean matrix packed 64 columns per word: entry `(i, j)` is bit `j % 64` of word `j / 64`
+ *        of row `i`. At `n = 50000` it takes 300 MB, against 10 GB for `int32_t` distances.
+ *
+ * Rows are `bit_matrix_words(n)` words apart; the bits past column `n - 1` are always `0`.
+ */
+struct bit_matrix {
+    int n = 0;
+    int words = 0;
+    aligned_buffer<uint64_t> bits;
+
+    bit_matrix() = default;
+
+    /**
+     * @brief Allocates an all-zero `n x n` matrix. Rows are zeroed in parallel with `schedule(static)`, so each
+     *        page is first touched by the thread that owns the row in `transitive_closure`.
+     */
+    explicit bit_matrix(int n);
+
+    uint64_t * row(int i) { return bits.data() + static_cast<size_t>(i) * words; }
+    const uint64_t * row(int i) const { return bits.data() + static_cast<size_t>(i) * words; }
+    bool test(int i, int j) const { return (row(i)[j / 64] >> (j % 64)) & 1; }
+    void set(int i, int j) { row(i)[j / 64] |= uint64_t{1} << (j % 64); }
+};
+
+/**
+ * @brief Packs rows `[first, first + count)` of a distance matrix into a `bit_matrix`: bit `(i, j)` is set
+ *        where the distance is not `distance_traits<T>::inf()`, so the diagonal is set and every edge is a bit.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param rows A pointer to `count x R.n` distances in flattened form, row `first` first.
+ * @param first The first row to pack.
+ * @param count The number of rows to pack; `first + count` must not exceed `R.n`.
+ * @param R The matrix to write. The packed rows are overwritten completely; other rows are left alone.
+ */
+template <typename T>
+void pack_reachability(
+    const T * rows,
+    int first,
+    int count,
+    bit_matrix & R
+);
+
+/**
+ * @brief Generates the graph `generate_linear_graph` would produce directly as a `bit_matrix`, one strip of rows
+ *        at a time, so the distance matrix never exists in whole.
+ *
+ * @param R The matrix to write; its `n` is the number of vertices.
+ * @param edges The number of directed edges in the graph.
+ * @param options Topology and seed (see `graph_options`); weights do not matter for reachability.
+ * @param strip_rows Rows generated per strip; memory use is `strip_rows * R.n` bytes on top of `R`.
+ * @return int Returns `1` on success, or `-1` if `edges` exceeds the maximum for `R.n`.
+ */
+int generate_reachability(
+    bit_matrix & R,
+    int edges,
+    const graph_options & options,
+    int strip_rows
+);
+
+/**
+ * @brief Computes the reflexive transitive closure of `R` in place with a blocked, bit-parallel Warshall
+ *        algorithm: afterwards bit `(i, j)` is set exactly when `j` is reachable from `i`.
+ *
+ * Round `k` of Warshall's algorithm is `row_i |= row_k` for every `i` with bit `(i, k)` set, so one word operation
+ * handles 64 columns. Rounds are processed 64 at a time, one word column of `k`:
+ * - **Diagonal Phase**: Rounds `k0` to `k0 + 63` on the 64 rows of the block, serially.
+ * - **Row Phase**: Every other row ORs in the finished block row of each bit it has in word `k0 / 64`, in one
+ *   `#pragma omp parallel for` per block. A finished block row `k` already contains the row of every block
+ *   vertex it reaches, so the bits set in the word by these ORs need no rounds of their own.
+ *
+ * @param R The matrix to close, e.g. from `pack_reachability` or `generate_reachability`. Updated in-place.
+ *
+ * @details The OR loops are `#pragma omp simd` over whole 64-byte aligned rows, and the 64 block rows stay in
+ *          cache for the whole row phase. There is one parallel region per 64 rounds.
+ */
+void transitive_closure(
+    bit_matrix & R
+);
+
+/**
+ * @brief Copies `source` into `destination`, which must have the same `n`. Rows are copied in parallel with
+ *        `schedule(static)`, so they stay on the node of the thread that owns them.
+ */
+void copy_bit_matrix(
+    const bit_matrix & source,
+    bit_matrix & destination
+);
+
+/**
+ * @brief Returns the number of set bits of `R`: reachable ordered pairs, including every `(i, i)`, after
+ *        `transitive_closure`.
+ */
+long long count_reachable_pairs(
+    const bit_matrix & R
+);
+
+#endif
@@ -0,0 +1,270 @@
+#include "distributed.h"
+#include "globals.h"
+#include "tile.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <omp.h>
+
+process_grid make_process_grid(MPI_Comm comm, int rows) {
+    process_grid grid;
+    MPI_Comm_size(comm, &grid.size);
+    MPI_Comm_rank(comm, &grid.rank);
+    int dims[2] = {rows, 0};
+    if (rows > 0 && grid.size % rows != 0) {
+        return grid;
+    }
+    MPI_Dims_create(grid.size, 2, dims);
+    grid.rows = dims[0];
+    grid.cols = dims[1];
+    grid.row = grid.rank / grid.cols;
+    grid.col = grid.rank % grid.cols;
+    MPI_Comm_dup(comm, &grid.comm);
+    MPI_Comm_split(grid.comm, grid.row, grid.col, &grid.row_comm);
+    MPI_Comm_split(grid.comm, grid.col, grid.row, &grid.col_comm);
+    return grid;
+}
+
+void free_process_grid(process_grid & grid) {
+    for (MPI_Comm * comm : {&grid.row_comm, &grid.col_comm, &grid.comm}) {
+        if (*comm != MPI_COMM_NULL) {
+            MPI_Comm_free(comm);
+        }
+    }
+}
+
+/**
+ * @brief Counts the tiles `t` in `[0, tiles)` with `t % parts == part`: the local tiles of one grid coordinate.
+ */
+static int local_tiles(int tiles, int part, int parts) {
+    return (tiles - part + parts - 1) / parts;
+}
+
+template <typename T>
+block_cyclic_matrix<T> make_block_cyclic_matrix(const process_grid & grid, int n, int b) {
+    block_cyclic_matrix<T> W;
+    W.n = n;
+    W.b = b;
+    W.tiles = (n + b - 1) / b;
+    W.tile_rows = local_tiles(W.tiles, grid.row, grid.rows);
+    W.tile_cols = local_tiles(W.tiles, grid.col, grid.cols);
+    W.data = aligned_buffer<T>(static_cast<size_t>(W.tile_rows) * W.tile_cols * b * b);
+    return W;
+}
+
+template <typename T>
+int generate_block_cyclic(block_cyclic_matrix<T> & W, const process_grid & grid, int edges, const graph_options & options) {
+    const int n = W.n;
+    const int b = W.b;
+    const T inf = distance_traits<T>::inf();
+    std::vector<T> rows(static_cast<size_t>(b) * n);
+
+    for (int li = 0; li < W.tile_rows; ++li) {
+        const int r0 = (grid.row + li * grid.rows) * b;
+        if (generate_graph_rows(rows.data(), n, edges, r0, std::min(b, n - r0), options) == -1) {
+            return -1;
+        }
+        // Keep the columns of this process's tiles; cells past n become padding.
+        #pragma omp parallel for
+        for (int lj = 0; lj < W.tile_cols; ++lj) {
+            const int c0 = (grid.col + lj * grid.cols) * b;
+            T * tile = W.tile(li, lj);
+            for (int i = 0; i < b; ++i) {
+                for (int j = 0; j < b; ++j) {
+                    const int gi = r0 + i;
+                    const int gj = c0 + j;
+                    tile[i * b + j] = (gi < n && gj < n) ? rows[static_cast<size_t>(i) * n + gj] : (gi == gj ? T(0) : inf);
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Buffers of one round: the diagonal tile, and the row and column panels as this process sees them.
+ */
+template <typename T>
+struct round_buffers {
+    std::vector<T> diagonal;
+    std::vector<T> row_storage;
+    std::vector<T> col_storage;
+    const T *row_panel = nullptr;   // Local tiles of W[k][*], in local column order
+    const T *col_panel = nullptr;   // Local tiles of W[*][k], in local row order
+    MPI_Request requests[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+};
+
+/**
+ * @brief Runs the dependent and partially dependent phases of round `k`, then starts the panel broadcasts.
+ *        The panels may be read once `requests` have completed.
+ */
+template <typename T>
+static void factor_round(block_cyclic_matrix<T> & W, const process_grid & grid, int k, round_buffers<T> & round) {
+    const int b = W.b;
+    const int bb = b * b;
+    const int bytes = static_cast<int>(sizeof(T));
+    const int kr = k % grid.rows;
+    const int kc = k % grid.cols;
+    const bool in_row = grid.row == kr;
+    const bool in_col = grid.col == kc;
+    T *Wkk = round.diagonal.data();
+
+    // Dependent Phase: the owner solves W[k][k] and shares it with its process row and column.
+    if (in_row && in_col) {
+        T *tile = W.tile(k / grid.rows, k / grid.cols);
+        minplus_tile(tile, tile, tile, b, b);
+        std::copy(tile, tile + bb, Wkk);
+    }
+    if (in_row) {
+        MPI_Bcast(Wkk, bb * bytes, MPI_BYTE, kc, grid.row_comm);
+    }
+    if (in_col) {
+        MPI_Bcast(Wkk, bb * bytes, MPI_BYTE, kr, grid.col_comm);
+    }
+
+    // Partially Dependent Phase: local tiles of W[k][*] and W[*][k].
+    const int row_tiles = in_row ? W.tile_cols : 0;
+    const int col_tiles = in_col ? W.tile_rows : 0;
+    #pragma omp parallel for
+    for (int x = 0; x < row_tiles + col_tiles; ++x) {
+        if (x < row_tiles) {
+            if (grid.col + x * grid.cols != k) {
+                T *Wkj = W.tile(k / grid.rows, x);
+                minplus_tile(Wkj, Wkk, Wkj, b, b);
+            }
+        }
+        else {
+            int li = x - row_tiles;
+            if (grid.row + li * grid.rows != k) {
+                T *Wik = W.tile(li, k / grid.cols);
+                minplus_tile(Wik, Wik, Wkk, b, b);
+            }
+        }
+    }
+
+    // Row panel: contiguous in the owners' storage, so they broadcast it in place.
+    if (in_row) {
+        round.row_panel = W.tile(k / grid.rows, 0);
+    }
+    else {
+        round.row_storage.resize(static_cast<size_t>(W.tile_cols) * bb);
+        round.row_panel = round.row_storage.data();
+    }
+    MPI_Ibcast(const_cast<T *>(round.row_panel), W.tile_cols * bb * bytes, MPI_BYTE, kr, grid.col_comm, &round.requests[0]);
+
+    // Column panel: strided over tile rows, so the owners pack it first.
+    round.col_storage.resize(static_cast<size_t>(W.tile_rows) * bb);
+    if (in_col) {
+        for (int li = 0; li < W.tile_rows; ++li) {
+            const T *Wik = W.tile(li, k / grid.cols);
+            std::copy(Wik, Wik + bb, round.col_storage.data() + static_cast<size_t>(li) * bb);
+        }
+    }
+    round.col_panel = round.col_storage.data();
+    MPI_Ibcast(round.col_storage.data(), W.tile_rows * bb * bytes, MPI_BYTE, kc, grid.row_comm, &round.requests[1]);
+}
+
+/**
+ * @brief Independent Phase of round `k` for local tiles outside block row and column `k`.
+ *
+ * @param lookahead If `true`, only the tiles in block row or column `next` are updated; otherwise all others.
+ * @param pending Broadcasts of the next round, tested between tiles by the master thread so they progress.
+ */
+template <typename T>
+static void update_round(block_cyclic_matrix<T> & W, const process_grid & grid, int k, const round_buffers<T> & round,
+                         int next, bool lookahead, MPI_Request *pending) {
+    const int b = W.b;
+    const int bb = b * b;
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int li = 0; li < W.tile_rows; ++li) {
+        for (int lj = 0; lj < W.tile_cols; ++lj) {
+            const int I = grid.row + li * grid.rows;
+            const int J = grid.col + lj * grid.cols;
+            if (I == k || J == k || ((I == next || J == next) != lookahead)) {
+                continue;
+            }
+            minplus_tile(W.tile(li, lj), round.col_panel + static_cast<size_t>(li) * bb, round.row_panel + static_cast<size_t>(lj) * bb, b, b);
+            if (pending != nullptr && omp_get_thread_num() == 0) {
+                int done;
+                MPI_Testall(2, pending, &done, MPI_STATUSES_IGNORE);
+            }
+        }
+    }
+}
+
+template <typename T>
+void distributed_floyd_warshall(block_cyclic_matrix<T> & W, const process_grid & grid) {
+    round_buffers<T> rounds[2];
+    for (round_buffers<T> & round : rounds) {
+        round.diagonal.resize(static_cast<size_t>(W.b) * W.b);
+    }
+    if (W.tiles == 0) {
+        return;
+    }
+
+    factor_round(W, grid, 0, rounds[0]);
+    MPI_Waitall(2, rounds[0].requests, MPI_STATUSES_IGNORE);
+    for (int k = 0; k < W.tiles; ++k) {
+        round_buffers<T> & current = rounds[k % 2];
+        if (k + 1 == W.tiles) {
+            update_round(W, grid, k, current, -1, false, nullptr);
+            break;
+        }
+        // Lookahead: finish what round k + 1 depends on, start its broadcasts, then overlap them with the rest.
+        round_buffers<T> & next = rounds[(k + 1) % 2];
+        update_round(W, grid, k, current, k + 1, true, nullptr);
+        factor_round(W, grid, k + 1, next);
+        update_round(W, grid, k, current, k + 1, false, next.requests);
+        MPI_Waitall(2, next.requests, MPI_STATUSES_IGNORE);
+    }
+}
+
+template <typename T>
+void gather_matrix(const block_cyclic_matrix<T> & W, const process_grid & grid, T * full) {
+    const int bytes = static_cast<int>(W.data.size() * sizeof(T));
+    std::vector<int> counts(grid.rank == 0 ? grid.size : 0);
+    MPI_Gather(&bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, grid.comm);
+
+    std::vector<int> offsets(counts.size(), 0);
+    for (size_t p = 1; p < counts.size(); ++p) {
+        offsets[p] = offsets[p - 1] + counts[p - 1];
+    }
+    std::vector<T> all(grid.rank == 0 ? (offsets.back() + counts.back()) / sizeof(T) : 0);
+    MPI_Gatherv(W.data.data(), bytes, MPI_BYTE, all.data(), counts.data(), offsets.data(), MPI_BYTE, 0, grid.comm);
+    if (grid.rank != 0) {
+        return;
+    }
+
+    const int b = W.b;
+    for (int p = 0; p < grid.size; ++p) {
+        const int row = p / grid.cols;
+        const int col = p % grid.cols;
+        const int tile_rows = local_tiles(W.tiles, row, grid.rows);
+        const int tile_cols = local_tiles(W.tiles, col, grid.cols);
+        const T *tiles = all.data() + offsets[p] / sizeof(T);
+        for (int li = 0; li < tile_rows; ++li) {
+            for (int lj = 0; lj < tile_cols; ++lj) {
+                const T *tile = tiles + (static_cast<size_t>(li) * tile_cols + lj) * b * b;
+                const int r0 = (row + li * grid.rows) * b;
+                const int c0 = (col + lj * grid.cols) * b;
+                for (int i = 0; i < b && r0 + i < W.n; ++i) {
+                    for (int j = 0; j < b && c0 + j < W.n; ++j) {
+                        full[static_cast<size_t>(r0 + i) * W.n + c0 + j] = tile[i * b + j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+#define INSTANTIATE_DISTRIBUTED(T) \
+    template block_cyclic_matrix<T> make_block_cyclic_matrix<T>(const process_grid &, int, int); \
+    template int generate_block_cyclic<T>(block_cyclic_matrix<T> &, const process_grid &, int, const graph_options &); \
+    template void distributed_floyd_warshall<T>(block_cyclic_matrix<T> &, const process_grid &); \
+    template void gather_matrix<T>(const block_cyclic_matrix<T> &, const process_grid &, T *);
+
+INSTANTIATE_DISTRIBUTED(int32_t)
+INSTANTIATE_DISTRIBUTED(uint16_t)
+INSTANTIATE_DISTRIBUTED(uint8_t)
+INSTANTIATE_DISTRIBUTED(float)
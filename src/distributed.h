@@ -0,0 +1,145 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "allocator.h"
+#include "graph.h"
+#include <mpi.h>
+
+/**
+ * @brief A 2D grid of MPI processes, with one communicator per process row and per process column.
+ *
+ * Process `(row, col)` has rank `row * cols + col` in `comm`. Its rank in `row_comm` is `col`, and in
+ * `col_comm` it is `row`, so a broadcast rooted at the owner of a tile uses the owner's column (or row) index.
+ */
+struct process_grid {
+    MPI_Comm comm = MPI_COMM_NULL;
+    MPI_Comm row_comm = MPI_COMM_NULL;     // Processes with the same `row`
+    MPI_Comm col_comm = MPI_COMM_NULL;     // Processes with the same `col`
+    int rank = 0;
+    int size = 1;
+    int rows = 1;
+    int cols = 1;
+    int row = 0;
+    int col = 0;
+};
+
+/**
+ * @brief Arranges the processes of `comm` into a `rows x cols` grid.
+ *
+ * @param comm The communicator to split; it is duplicated, so the grid does not interfere with other traffic.
+ * @param rows The number of process rows, which must divide the size of `comm`; `0` picks the most
+ *             square grid (`MPI_Dims_create`).
+ * @return process_grid The grid, or a grid with `comm == MPI_COMM_NULL` if `rows` does not divide the size.
+ *         Release it with `free_process_grid`.
+ */
+process_grid make_process_grid(
+    MPI_Comm comm,
+    int rows = 0
+);
+
+/**
+ * @brief Frees the communicators of a grid from `make_process_grid`.
+ */
+void free_process_grid(
+    process_grid & grid
+);
+
+/**
+ * @brief The part of an `n x n` matrix held by one process, in a 2D block-cyclic distribution.
+ *
+ * The matrix is divided into `tiles x tiles` tiles of `b x b`, with `tiles = ceil(n / b)`. Tile `(I, J)` is held by
+ * process `(I % grid.rows, J % grid.cols)` as its local tile `(I / grid.rows, J / grid.cols)`. Cyclic placement
+ * keeps every process busy in every round, as rounds move down the diagonal.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ *
+ * @details Local tiles are stored tile-major, one contiguous `b x b` tile after another, row of tiles by row of
+ *          tiles. A row panel is then one contiguous range, and every tile has leading dimension `b`. Cells past
+ *          `n` are padding: `INF`, with `0` on the diagonal, so they never shorten a path.
+ */
+template <typename T>
+struct block_cyclic_matrix {
+    int n = 0;
+    int b = 0;
+    int tiles = 0;          // Tiles along one dimension of the whole matrix
+    int tile_rows = 0;      // Local tiles along a column
+    int tile_cols = 0;      // Local tiles along a row
+    aligned_buffer<T> data;
+
+    T * tile(int li, int lj) { return data.data() + (static_cast<size_t>(li) * tile_cols + lj) * b * b; }
+    const T * tile(int li, int lj) const { return data.data() + (static_cast<size_t>(li) * tile_cols + lj) * b * b; }
+};
+
+/**
+ * @brief Allocates the local part of an `n x n` matrix with tiles of `b x b` (uninitialized).
+ */
+template <typename T>
+block_cyclic_matrix<T> make_block_cyclic_matrix(
+    const process_grid & grid,
+    int n,
+    int b
+);
+
+/**
+ * @brief Generates the local tiles of the graph `generate_linear_graph` would produce, without any process
+ *        holding the whole matrix.
+ *
+ * @param W The local part of the matrix, from `make_block_cyclic_matrix`.
+ * @param grid The process grid `W` is distributed over.
+ * @param edges The number of directed edges in the whole graph.
+ * @param options Topology, weight distribution and seed (see `graph_options`).
+ * @return int Returns `1` on success, or `-1` if `edges` exceeds the maximum for `W.n`.
+ *
+ * @details Each process generates the `b` rows of each of its tile rows with `generate_graph_rows` and keeps the
+ *          columns of its own tiles, so it needs `b * n` elements of scratch on top of its tiles.
+ */
+template <typename T>
+int generate_block_cyclic(
+    block_cyclic_matrix<T> & W,
+    const process_grid & grid,
+    int edges,
+    const graph_options & options = graph_options{}
+);
+
+/**
+ * @brief Performs the blocked Floyd-Warshall algorithm on a matrix distributed over a process grid.
+ *
+ * Each round `k` follows the phases of `blocked_floyd_warshall`:
+ * - **Dependent Phase**: The owner of `W[k][k]` solves it and broadcasts it along its process row and column.
+ * - **Partially Dependent Phase**: The process row of `k` updates its tiles of `W[k][*]`, and the process column
+ *   of `k` its tiles of `W[*][k]`. The row panel is broadcast down the process columns, and the column panel
+ *   across the process rows.
+ * - **Independent Phase**: Every process updates all its other tiles from the two panels.
+ *
+ * @param W The local part of the matrix, updated in place. Every process must call this function.
+ * @param grid The process grid `W` is distributed over.
+ *
+ * @details
+ * - Communication overlaps computation with a one-round lookahead: the tiles of row and column `k + 1` are
+ *   updated first, round `k + 1`'s first two phases run, and its panel broadcasts (`MPI_Ibcast`) are in flight
+ *   while the remaining tiles of round `k` are updated.
+ * - On each process, the tile updates are spread over OpenMP threads and run the SIMD kernel `minplus_tile`.
+ * - Each process sends and receives O(n^2 / sqrt(P)) elements in total, against O(n^3 / P) operations.
+ */
+template <typename T>
+void distributed_floyd_warshall(
+    block_cyclic_matrix<T> & W,
+    const process_grid & grid
+);
+
+/**
+ * @brief Collects a distributed matrix on rank `0` of the grid, for checking or printing small graphs.
+ *
+ * @param W The local part of the matrix.
+ * @param grid The process grid `W` is distributed over. Every process must call this function.
+ * @param full On rank `0`, a pointer to `W.n x W.n` elements that receives the matrix in flattened form.
+ *             Ignored on other ranks.
+ */
+template <typename T>
+void gather_matrix(
+    const block_cyclic_matrix<T> & W,
+    const process_grid & grid,
+    T * full
+);
+
+#endif
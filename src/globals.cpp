@@ -1,6 +0,0 @@
-#include "globals.h"
-
-/**
- * int INF = 1e9;
- */
-int INF = 1e9;
\ No newline at end of file
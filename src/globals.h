@@ -1,6 +1,64 @@
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
-extern int INF;
+#include <cstdint>
+#include <limits>
 
-#endif
\ No newline at end of file
+/**
+ * @brief The `int32_t` sentinel for "no path": large, yet `INF + INF` still fits in 32 bits.
+ */
+inline constexpr int INF = 1000000000;
+
+/**
+ * @brief Per-type constants and arithmetic for the distance types the kernels are instantiated for.
+ * 
+ * Every specialization provides:
+ * - `inf()`: The sentinel for "no path". Sums involving it never compare below it, so kernels need no
+ *   per-element `INF` branch (see `minplus_tile`).
+ * - `add(a, b)`: Path concatenation. Saturates at `inf()` for the narrow unsigned types.
+ * - `name()`: The name used by the `--dtype` CLI option.
+ * 
+ * Supported types:
+ * - `int32_t`: `INF` (1e9). `INF + INF` still fits, so plain addition is used.
+ * - `uint16_t`: 65535, with saturating addition. Paths longer than 65534 read as unreachable.
+ * - `uint8_t`: 255, with saturating addition. Paths longer than 254 read as unreachable.
+ * - `float`: `+infinity`, which is absorbing under IEEE addition.
+ */
+template <typename T>
+struct distance_traits;
+
+template <>
+struct distance_traits<int32_t> {
+    static constexpr int32_t inf() { return INF; }
+    static int32_t add(int32_t a, int32_t b) { return a + b; }
+    static const char * name() { return "int32"; }
+};
+
+template <>
+struct distance_traits<uint16_t> {
+    static constexpr uint16_t inf() { return std::numeric_limits<uint16_t>::max(); }
+    static uint16_t add(uint16_t a, uint16_t b) {
+        unsigned sum = static_cast<unsigned>(a) + b;
+        return static_cast<uint16_t>(sum > inf() ? inf() : sum);
+    }
+    static const char * name() { return "uint16"; }
+};
+
+template <>
+struct distance_traits<uint8_t> {
+    static constexpr uint8_t inf() { return std::numeric_limits<uint8_t>::max(); }
+    static uint8_t add(uint8_t a, uint8_t b) {
+        unsigned sum = static_cast<unsigned>(a) + b;
+        return static_cast<uint8_t>(sum > inf() ? inf() : sum);
+    }
+    static const char * name() { return "uint8"; }
+};
+
+template <>
+struct distance_traits<float> {
+    static constexpr float inf() { return std::numeric_limits<float>::infinity(); }
+    static float add(float a, float b) { return a + b; }
+    static const char * name() { return "float"; }
+};
+
+#endif
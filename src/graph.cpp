@@ -5,23 +5,121 @@
 #include "globals.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
 
-int generate_linear_graph(std::vector<int> & graph, int vertices, int edges)
+/**
+ * @brief SplitMix64 finalizer, used to derive independent stream seeds from `--seed`.
+ */
+static uint64_t mix_seed(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Random stream owned by row `row`, so rows can be filled in any order on any thread.
+ */
+static std::mt19937_64 row_stream(uint64_t seed, int row) {
+    return std::mt19937_64(mix_seed(mix_seed(seed) ^ static_cast<uint64_t>(row)));
+}
+
+/**
+ * @brief Draws one edge weight in `[1, cap]` from `distribution`.
+ */
+static int draw_weight(std::mt19937_64 & rng, weight_distribution distribution, int cap) {
+    switch (distribution) {
+    case weight_distribution::uniform:
+        return std::uniform_int_distribution<int>(1, cap)(rng);
+    case weight_distribution::exponential: {
+        double x = std::exponential_distribution<double>(4.0 / cap)(rng);
+        return static_cast<int>(std::min<double>(cap, 1.0 + std::floor(x)));
+    }
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Splits `edges` over the rows in proportion to `weight`, with no row above `vertices - 1`.
+ * 
+ * Each row takes a binomial share of the edges still unassigned, with probability equal to its share of
+ * the remaining weight, clamped so the rows after it can still hold the rest. The total is exactly `edges`.
+ */
+static std::vector<int> split_degrees(const std::vector<double> & weight, int vertices, long long edges, uint64_t seed) {
+    std::mt19937_64 rng(mix_seed(seed ^ 0x5eedULL));
+    std::vector<int> degree(vertices, 0);
+    double remaining_weight = 0;
+    for (double w : weight) {
+        remaining_weight += w;
+    }
+    long long remaining = edges;
+    for (int i = 0; i < vertices && remaining > 0; i++) {
+        long long capacity_after = static_cast<long long>(vertices - 1 - i) * (vertices - 1);
+        double p = remaining_weight > 0 ? std::min(1.0, weight[i] / remaining_weight) : 1.0;
+        long long k = std::binomial_distribution<long long>(remaining, p)(rng);
+        k = std::max(k, remaining - capacity_after);
+        k = std::min<long long>(k, vertices - 1);
+        degree[i] = static_cast<int>(k);
+        remaining -= k;
+        remaining_weight -= weight[i];
+    }
+    return degree;
+}
+
+template <typename T>
+int generate_linear_graph(T * graph, int vertices, int edges, const graph_options & options)
 {
-    // Initialize memory
-    for (int i = 0; i < vertices; i++) {
-        for (int j = 0; j < vertices; j++) {
-            int position = i * vertices + j;
-            if (position == i * vertices + i) {
-                graph[position] = 0;
+    return generate_graph_rows(graph, vertices, edges, 0, vertices, options);
+}
+
+template <typename T>
+int generate_graph_rows(T * rows, int vertices, int edges, int first, int count, const graph_options & options)
+{
+    const T inf = distance_traits<T>::inf();
+    const int cap = static_cast<int>(std::max(1.0, std::min<double>(
+        std::max(1, options.max_weight),
+        static_cast<double>(inf) - 1
+    )));
+
+    const int last = first + count;
+
+    // Initialize memory, each row by the thread that fills it.
+    #pragma omp parallel for schedule(static)
+    for (int i = first; i < last; i++) {
+        T * row = rows + static_cast<size_t>(i - first) * vertices;
+        std::fill(row, row + vertices, inf);
+        row[i] = 0;
+    }
+
+    if (options.topology == graph_topology::grid) {
+        const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(vertices))));
+
+        #pragma omp parallel for schedule(static)
+        for (int v = first; v < last; v++) {
+            std::mt19937_64 rng = row_stream(options.seed, v);
+            T * row = rows + static_cast<size_t>(v - first) * vertices;
+            int column = v % side;
+            if (column > 0) {
+                row[v - 1] = draw_weight(rng, options.weights, cap);
             }
-            else {
-                graph[position] = INF;
+            if (column < side - 1 && v + 1 < vertices) {
+                row[v + 1] = draw_weight(rng, options.weights, cap);
+            }
+            if (v >= side) {
+                row[v - side] = draw_weight(rng, options.weights, cap);
+            }
+            if (v + side < vertices) {
+                row[v + side] = draw_weight(rng, options.weights, cap);
             }
         }
+        return 1;
     }
 
-    if (edges > vertices * (vertices - 1)) {
+    if (edges > static_cast<long long>(vertices) * (vertices - 1)) {
         spdlog::error(
             "Number of edges {} exceeds what is possible given number of vertices {}",
             edges,
@@ -29,50 +127,96 @@ int generate_linear_graph(std::vector<int> & graph, int vertices, int edges)
         );
         return -1;
     }
-    
-    std::vector<std::vector<int>> edge(edges, std::vector<int>(2));
-    int i = 0;
-
-    // Generate directed graph.
-    while (i < edges) {
-        edge[i][0] = rand() % vertices;
-        edge[i][1] = rand() % vertices;
-        
-        // Discard loop.
-        if (edge[i][0] == edge[i][1]) {
+
+    // Per-vertex weights: flat for Erdős–Rényi, Zipf for power law. Out-degrees and targets both follow them.
+    const bool power_law = options.topology == graph_topology::power_law;
+    std::vector<double> weight(vertices, 1.0);
+    std::vector<double> cumulative;
+    if (power_law) {
+        double exponent = -1.0 / std::max(1.01, options.gamma - 1.0);
+        cumulative.resize(vertices);
+        double total = 0;
+        for (int v = 0; v < vertices; v++) {
+            weight[v] = std::pow(v + 1.0, exponent);
+            total += weight[v];
+            cumulative[v] = total;
+        }
+    }
+    std::vector<int> degree = split_degrees(weight, vertices, edges, options.seed);
+
+    // Generate directed graph, one independent stream per row.
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (int i = first; i < last; i++) {
+        if (degree[i] == 0) {
             continue;
         }
-        // Discard duplicate edge.
+        std::mt19937_64 rng = row_stream(options.seed, i);
+        std::uniform_int_distribution<int> uniform_target(0, vertices - 1);
+        std::uniform_real_distribution<double> mass(0.0, power_law ? cumulative.back() : 1.0);
+        T * row = rows + static_cast<size_t>(i - first) * vertices;
+
+        if (2 * degree[i] <= vertices - 1) {
+            int placed = 0;
+            while (placed < degree[i]) {
+                int j = power_law
+                    ? static_cast<int>(std::upper_bound(cumulative.begin(), cumulative.end(), mass(rng)) - cumulative.begin())
+                    : uniform_target(rng);
+                // Discard loop and duplicate edge; the matrix cell records what is taken.
+                if (j >= vertices || j == i || row[j] != inf) {
+                    continue;
+                }
+                row[j] = draw_weight(rng, options.weights, cap);
+                placed++;
+            }
+        }
         else {
-            for (int j = 0; j < i; j++) {
-                if ((
-                    edge[i][0] == edge[j][0] &&
-                    edge[i][1] == edge[j][1]
-                    ))
-                {
-                    i--;
+            // Dense row: take every edge, then drop the surplus uniformly.
+            for (int j = 0; j < vertices; j++) {
+                if (j != i) {
+                    row[j] = draw_weight(rng, options.weights, cap);
+                }
+            }
+            int surplus = vertices - 1 - degree[i];
+            while (surplus > 0) {
+                int j = uniform_target(rng);
+                if (j == i || row[j] == inf) {
+                    continue;
                 }
+                row[j] = inf;
+                surplus--;
             }
         }
-        i++;
-    }
-    
-    // Mark edges in graph.
-    int vertex_one, vertex_two;
-    for (int j = 0; j < edges; j++) {
-        vertex_one = edge[j][0];
-        vertex_two = edge[j][1];
-        graph[vertex_one * vertices + vertex_two] = 1;
     }
     
     return 1;
 }
 
-void print_graph(std::vector<int> & graph, int vertices)
+template <typename T>
+long long count_edges(const T * graph, int vertices)
 {
+    const T inf = distance_traits<T>::inf();
+    long long count = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+ : count)
     for (int i = 0; i < vertices; i++) {
+        const T * row = graph + static_cast<size_t>(i) * vertices;
         for (int j = 0; j < vertices; j++) {
-            if (graph[i * vertices + j] == INF)
+            if (j != i && row[j] != inf) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+template <typename T>
+void print_graph(const T * graph, int vertices)
+{
+    const T inf = distance_traits<T>::inf();
+
+    for (int i = 0; i < vertices; i++) {
+        for (int j = 0; j < vertices; j++) {
+            if (graph[i * vertices + j] == inf)
             {
                 fmt::print("N ");
             }
@@ -83,4 +227,15 @@ void print_graph(std::vector<int> & graph, int vertices)
         }
         fmt::print("\n");
     }
-}
\ No newline at end of file
+}
+
+#define INSTANTIATE_GRAPH(T) \
+    template int generate_linear_graph<T>(T *, int, int, const graph_options &); \
+    template int generate_graph_rows<T>(T *, int, int, int, int, const graph_options &); \
+    template long long count_edges<T>(const T *, int); \
+    template void print_graph<T>(const T *, int);
+
+INSTANTIATE_GRAPH(int32_t)
+INSTANTIATE_GRAPH(uint16_t)
+INSTANTIATE_GRAPH(uint8_t)
+INSTANTIATE_GRAPH(float)
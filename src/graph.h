@@ -1,50 +1,127 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#include <vector>
+#include "globals.h"
+
+/**
+ * @brief Edge structure produced by `generate_linear_graph`.
+ */
+enum class graph_topology {
+    erdos_renyi,    // `edges` distinct edges drawn uniformly from all ordered pairs, G(n, m)
+    grid,           // 4-neighbour lattice in both directions, `ceil(sqrt(vertices))` vertices per row
+    power_law       // Chung-Lu style: out-degrees and targets follow a Zipf weight `(v + 1)^(-1 / (gamma - 1))`
+};
+
+/**
+ * @brief Distribution of the edge weights written by `generate_linear_graph`.
+ */
+enum class weight_distribution {
+    unit,           // Every edge weighs `1`
+    uniform,        // Integers uniform in `[1, max_weight]`
+    exponential     // `1 + floor(X)`, X exponential with mean `max_weight / 4`, capped at `max_weight`
+};
+
+/**
+ * @brief Settings of the random graph generator. The defaults reproduce an unweighted G(n, m) graph.
+ */
+struct graph_options {
+    graph_topology topology = graph_topology::erdos_renyi;
+    weight_distribution weights = weight_distribution::unit;
+    int max_weight = 1;
+    uint64_t seed = 0;
+    double gamma = 2.5;     // Power-law exponent, used by `graph_topology::power_law` only
+};
 
 /**
  * @brief Generates a random directed graph represented as an adjacency matrix in flattened form.
  * 
  * This function populates a flattened adjacency matrix with a randomly generated directed graph. 
  * The graph includes a specified number of vertices and edges, ensuring no self-loops or duplicate 
- * edges. The diagonal entries represent the distance from a vertex to itself (set to `0`), valid edges 
- * are assigned a weight of `1`, and disconnected vertices are represented as `INF`.
+ * edges. The diagonal entries represent the distance from a vertex to itself (set to `0`), edges 
+ * are assigned a weight drawn from `options.weights`, and disconnected vertices are represented as `INF`.
  * 
- * @param graph A reference to a vector representing the adjacency matrix in flattened form. 
- *              The function modifies this vector to represent the generated graph.
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix in flattened form. 
+ *              The function modifies this matrix to represent the generated graph.
  * @param vertices The number of vertices in the graph. The adjacency matrix is assumed to be 
  *                 of size `vertices x vertices`.
- * @param edges The number of directed edges to generate in the graph.
+ * @param edges The number of directed edges to generate in the graph. Ignored by `graph_topology::grid`,
+ *              whose edge count is fixed by the lattice.
+ * @param options Topology, weight distribution and seed (see `graph_options`).
  * @return int Returns `1` on successful generation, or `-1` if the requested number of edges 
  *             exceeds the maximum possible for the given number of vertices.
  * 
  * @details
  * - **Memory Initializer**: All diagonal entries are set to `0`, representing the distance 
- *   from a vertex to itself. All other entries are set to `INF`, representing no connection.
- * - **Edge Generation**: Randomly generates unique directed edges, discarding self-loops and 
- *   duplicate edges. The edges are assigned a weight of `1` in the adjacency matrix.
+ *   from a vertex to itself. All other entries are set to `distance_traits<T>::inf()`, representing no connection.
+ *   Rows are initialized by the threads that later fill them.
+ * - **Edge Counts**: The out-degree of every row is drawn up front by sequential conditional binomial
+ *   splitting of `edges`, with every row weighted equally (Erdős–Rényi) or by its Zipf weight (power law),
+ *   so the total is exactly `edges` and no row exceeds `vertices - 1`.
+ * - **Edge Generation**: Rows are then filled in parallel, each with its own `std::mt19937_64` stream
+ *   derived from `options.seed` and the row index. Duplicates are rejected by reading the matrix cell
+ *   itself, so generation is O(vertices^2 + edges). Rows asked for more than half of their cells are
+ *   filled completely and thinned instead, so rejection never dominates.
+ * - **Reproducibility**: The result depends only on `vertices`, `edges` and `options`, never on the
+ *   number of threads or on the global `rand()` state.
  * - **Edge Constraints**: Ensures that the number of requested edges does not exceed the maximum 
  *   possible edges for the given number of vertices (`vertices * (vertices - 1)` for a directed graph).
  * - **Error Handling**: Logs an error message using `spdlog` and returns `-1` if the edge count 
  *   exceeds the maximum possible.
  * 
  * @note 
- * - `INF` should be predefined in the program to represent no connection between vertices.
- * - The function does not currently handle edge weights greater than `1`. If weighted edges are 
- *   needed, the function must be modified.
- * 
- * @limitations
- * - The function currently uses `rand()` for randomness, which may not provide sufficient randomness 
- *   for all use cases. Consider replacing with `std::random_device` or `std::mt19937` for better 
- *   randomness if required.
- * - The adjacency matrix assumes a fixed weight of `1` for valid edges. Modify the weight logic 
- *   if varying weights are required.
+ * - `options.max_weight` is capped below `distance_traits<T>::inf()`, so an edge never reads as unreachable.
+ *   Long paths in `uint8_t` or `uint16_t` still saturate to unreachable.
  */
+template <typename T>
 int generate_linear_graph(
-    std::vector<int> & graph,
+    T * graph,
+    int vertices,
+    int edges,
+    const graph_options & options = graph_options{}
+);
+
+/**
+ * @brief Generates rows `[first, first + count)` of the graph `generate_linear_graph` would produce.
+ * 
+ * Used by the distributed engine, where no process holds the whole matrix: every process generates
+ * only the rows of its own tiles, and the union is exactly the graph of `generate_linear_graph`.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param rows A pointer to `count x vertices` elements, written in flattened form; row `i` of the graph
+ *             is stored at `rows + (i - first) * vertices`.
+ * @param vertices The number of vertices in the graph.
+ * @param edges The number of directed edges in the whole graph (see `generate_linear_graph`).
+ * @param first The first row to generate.
+ * @param count The number of rows to generate; `first + count` must not exceed `vertices`.
+ * @param options Topology, weight distribution and seed (see `graph_options`).
+ * @return int Returns `1` on success, or `-1` if `edges` exceeds the maximum for `vertices`.
+ * 
+ * @note The out-degrees of all rows are still drawn (O(vertices)), so that every row gets the same degree
+ *       as in the full graph.
+ */
+template <typename T>
+int generate_graph_rows(
+    T * rows,
     int vertices,
-    int edges
+    int edges,
+    int first,
+    int count,
+    const graph_options & options = graph_options{}
+);
+
+/**
+ * @brief Counts the directed edges of a graph: off-diagonal entries that are not `distance_traits<T>::inf()`.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix in flattened form.
+ * @param vertices The number of vertices in the graph.
+ * @return long long The number of edges, counted in parallel over rows.
+ */
+template <typename T>
+long long count_edges(
+    const T * graph,
+    int vertices
 );
 
 /**
@@ -54,7 +131,8 @@ int generate_linear_graph(
  * Each element is displayed row by row, separated by a space, with rows printed on new lines. 
  * Infinite values (`INF`) are represented by the symbol `N` for improved readability.
  * 
- * @param graph A reference to a vector representing the adjacency matrix of the graph 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix of the graph 
  *              in flattened form. Each element `graph[i * vertices + j]` represents 
  *              the weight of the edge from vertex `i` to vertex `j`.
  * @param vertices The number of vertices in the graph. The adjacency matrix is assumed 
@@ -71,8 +149,9 @@ int generate_linear_graph(
  * - The graph values should be properly initialized before calling this function.
  * - Ensure that `INF` is consistently defined in the program to avoid misinterpretation.
  */
+template <typename T>
 void print_graph(
-    std::vector<int> & graph,
+    const T * graph,
     int vertices
 );
 
@@ -0,0 +1,137 @@
+#include "incremental.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstddef>
+#include <spdlog/spdlog.h>
+
+/**
+ * @brief Checks that `u` and `v` are vertices, logging an error otherwise.
+ */
+static bool valid_edge(int n, int u, int v) {
+    if (u < 0 || u >= n || v < 0 || v >= n) {
+        spdlog::error("Edge {} -> {} is outside the {} vertices of the graph", u, v, n);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Relaxes row `i` of `W` through the edge `u -> v` of weight `w`: `W[i][j] = min(W[i][j], W[i][u] + w + W[v][j])`.
+ *
+ * @details Only improved elements are stored. Row `v` never improves for non-negative weights, so it is never
+ *          written while other threads read it.
+ */
+template <typename T>
+static void relax_row(T * W, int n, int i, int u, int v, T w) {
+    const T inf = distance_traits<T>::inf();
+    T d_iu = W[static_cast<size_t>(i) * n + u];
+    if (d_iu == inf) {
+        return;
+    }
+    T through = distance_traits<T>::add(d_iu, w);
+    T * row_i = W + static_cast<size_t>(i) * n;
+    const T * row_v = W + static_cast<size_t>(v) * n;
+    for (int j = 0; j < n; j++) {
+        T candidate = distance_traits<T>::add(through, row_v[j]);
+        if (candidate < row_i[j]) {
+            row_i[j] = candidate;
+        }
+    }
+}
+
+template <typename T>
+int apply_edge_decrease(T * W, int n, int u, int v, T w)
+{
+    if (!valid_edge(n, u, v)) {
+        return -1;
+    }
+    if (!(w < W[static_cast<size_t>(u) * n + v])) {
+        return 0;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        relax_row(W, n, i, u, v, w);
+    }
+    return 1;
+}
+
+template <typename T, typename I>
+int apply_edge_decrease(T * W, I * next, int n, int u, int v, T w)
+{
+    const T inf = distance_traits<T>::inf();
+    if (!valid_edge(n, u, v)) {
+        return -1;
+    }
+    if (!(w < W[static_cast<size_t>(u) * n + v])) {
+        return 0;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++) {
+        T d_iu = W[static_cast<size_t>(i) * n + u];
+        if (d_iu == inf) {
+            continue;
+        }
+        T through = distance_traits<T>::add(d_iu, w);
+        I hop = i == u ? static_cast<I>(v) : next[static_cast<size_t>(i) * n + u];
+        T * row_i = W + static_cast<size_t>(i) * n;
+        I * next_i = next + static_cast<size_t>(i) * n;
+        const T * row_v = W + static_cast<size_t>(v) * n;
+        for (int j = 0; j < n; j++) {
+            T candidate = distance_traits<T>::add(through, row_v[j]);
+            if (candidate < row_i[j]) {
+                row_i[j] = candidate;
+                next_i[j] = hop;
+            }
+        }
+    }
+    return 1;
+}
+
+template <typename T>
+int apply_edge_decreases(T * W, int n, const std::vector<edge_update<T>> & updates)
+{
+    for (const edge_update<T> & update : updates) {
+        if (!valid_edge(n, update.u, update.v)) {
+            return -1;
+        }
+    }
+
+    int changed = 0;
+    #pragma omp parallel
+    {
+        for (const edge_update<T> & update : updates) {
+            // One thread decides, after the previous update's rows are done, and copyprivate hands every thread
+            // its own copy of the decision, so a thread already deciding the next update cannot overwrite it.
+            bool improves;
+            #pragma omp single copyprivate(improves)
+            {
+                improves = update.w < W[static_cast<size_t>(update.u) * n + update.v];
+                changed += improves;
+            }
+            if (improves) {
+                #pragma omp for schedule(static)
+                for (int i = 0; i < n; i++) {
+                    relax_row(W, n, i, update.u, update.v, update.w);
+                }
+            }
+        }
+    }
+    return changed;
+}
+
+#define INSTANTIATE_INCREMENTAL_NEXT(T, I) \
+    template int apply_edge_decrease<T, I>(T *, I *, int, int, int, T);
+
+#define INSTANTIATE_INCREMENTAL(T) \
+    template int apply_edge_decrease<T>(T *, int, int, int, T); \
+    template int apply_edge_decreases<T>(T *, int, const std::vector<edge_update<T>> &); \
+    INSTANTIATE_INCREMENTAL_NEXT(T, uint8_t) \
+    INSTANTIATE_INCREMENTAL_NEXT(T, uint16_t) \
+    INSTANTIATE_INCREMENTAL_NEXT(T, uint32_t)
+
+INSTANTIATE_INCREMENTAL(int32_t)
+INSTANTIATE_INCREMENTAL(uint16_t)
+INSTANTIATE_INCREMENTAL(uint8_t)
+INSTANTIATE_INCREMENTAL(float)
@@ -0,0 +1,94 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "globals.h"
+#include <vector>
+
+/**
+ * @brief One edge insertion or weight decrease: the edge `u -> v` now weighs `w`.
+ * 
+ * @tparam T The distance type of the matrix the update is applied to.
+ */
+template <typename T>
+struct edge_update {
+    int u;
+    int v;
+    T w;
+};
+
+/**
+ * @brief Updates a solved all-pairs distance matrix after the edge `u -> v` is inserted or its weight decreased to `w`.
+ * 
+ * Every shortest path that gets shorter must use the new edge, so each pair only has to consider
+ * `W[i][u] + w + W[v][j]`. This costs O(n^2) instead of the O(n^3) of solving again.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param W A pointer to a solved distance matrix in flattened form (the output of any kernel). Updated in-place.
+ * @param n The number of vertices.
+ * @param u The tail of the edge.
+ * @param v The head of the edge.
+ * @param w The new weight of the edge. Must be non-negative.
+ * @return int Returns `1` if distances changed, `0` if `w` does not improve `W[u][v]` (nothing to do),
+ *             or `-1` if `u` or `v` is not a vertex.
+ * 
+ * @details
+ * - Rows are updated in parallel with OpenMP. Row `i` is skipped when `u` is unreachable from `i`, and the
+ *   inner loop is a plain `min(W[i][j], d + W[v][j])` over row `v`, which the compiler vectorizes.
+ * - Updating in place is safe: with non-negative weights, row `v` and column `u` cannot improve through
+ *   the new edge, so every row reads values no other thread writes.
+ * - Sums go through `distance_traits<T>::add`, so narrow types saturate exactly as in the kernels.
+ * 
+ * @note Only decreases and insertions are supported. Increasing or deleting an edge can lengthen paths
+ *       that the matrix no longer knows the alternatives of, and needs a full solve.
+ */
+template <typename T>
+int apply_edge_decrease(
+    T * W,
+    int n,
+    int u,
+    int v,
+    T w
+);
+
+/**
+ * @brief Path-tracking variant of `apply_edge_decrease` that also keeps a next-hop matrix current.
+ * 
+ * @tparam I The next-hop index type (see paths.h).
+ * @param next The next-hop matrix produced alongside `W` by a path-tracking kernel. Updated in-place:
+ *             improved pairs route through `u`, so they take `next[i][u]`, or `v` itself when `i == u`.
+ */
+template <typename T, typename I>
+int apply_edge_decrease(
+    T * W,
+    I * next,
+    int n,
+    int u,
+    int v,
+    T w
+);
+
+/**
+ * @brief Applies a batch of edge insertions and weight decreases, in order, to a solved distance matrix.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param W A pointer to a solved distance matrix in flattened form. Updated in-place.
+ * @param n The number of vertices.
+ * @param updates The edge changes, applied as if by one `apply_edge_decrease` call each.
+ * @return int The number of updates that changed distances, or `-1` if any update names a vertex
+ *             outside `[0, n)` (the matrix is then left untouched).
+ * 
+ * @details
+ * - The whole batch runs in one OpenMP parallel region: threads split the rows of each update and meet at a
+ *   barrier before the next one, since the next update reads rows the previous one may have shortened.
+ *   Updates that do not improve their edge cost one barrier and no row work.
+ * - Cost is O(k n^2) for `k` updates. When `k` approaches `n / 8` or so, setting the new edge weights and
+ *   running a blocked kernel on the matrix again is cheaper.
+ */
+template <typename T>
+int apply_edge_decreases(
+    T * W,
+    int n,
+    const std::vector<edge_update<T>> & updates
+);
+
+#endif
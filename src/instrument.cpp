@@ -0,0 +1,316 @@
+#include "instrument.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <omp.h>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+const char * instrument_phase_name(instrument_phase phase) {
+    switch (phase) {
+    case instrument_phase::dependent:
+        return "dependent";
+    case instrument_phase::row_panel:
+        return "row panel";
+    case instrument_phase::column_panel:
+        return "column panel";
+    case instrument_phase::panels:
+        return "panels";
+    case instrument_phase::independent:
+        return "independent";
+    }
+    return "unknown";
+}
+
+bool instrument_enabled() {
+#ifdef FW_INSTRUMENT
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef FW_INSTRUMENT
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief One recorded event. Times are ns since `instrument_start`; counters are deltas over the event.
+ */
+struct instrument_event {
+    instrument_phase phase;
+    int k;
+    int thread;
+    bool region;
+    long long begin;
+    long long end;
+    long long counters[3];
+};
+
+/**
+ * @brief Events and counter file descriptors of one thread. Logs live until exit, so threads keep a plain pointer.
+ */
+struct thread_log {
+    std::vector<instrument_event> events;
+    int fds[3] = {-1, -1, -1};
+    bool counters_tried = false;
+};
+
+static const char * const counter_names[3] = {"instructions", "l1d_read_misses", "llc_misses"};
+
+static std::mutex logs_mutex;
+static std::vector<std::unique_ptr<thread_log>> logs;
+static std::atomic<bool> recording{false};
+static bool counters_requested = false;
+static std::chrono::steady_clock::time_point epoch;
+static thread_local thread_log * local_log = nullptr;
+
+static long long now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ * @brief Opens one user-space counter of the calling thread, on any CPU. Returns `-1` if it is not available.
+ */
+static int open_counter(uint32_t type, uint64_t config) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static thread_log & this_thread_log() {
+    if (local_log == nullptr) {
+        std::lock_guard<std::mutex> lock(logs_mutex);
+        logs.push_back(std::make_unique<thread_log>());
+        local_log = logs.back().get();
+    }
+    thread_log & log = *local_log;
+    if (counters_requested && !log.counters_tried) {
+        log.counters_tried = true;
+        log.fds[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        log.fds[1] = open_counter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        log.fds[2] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        static std::once_flag warned;
+        if (log.fds[0] == -1 || log.fds[1] == -1 || log.fds[2] == -1) {
+            std::call_once(warned, [] { spdlog::warn("perf_event_open failed for some hardware counters; they read as 0"); });
+        }
+    }
+    return log;
+}
+
+static void read_counters(const thread_log & log, long long * values) {
+    for (int c = 0; c < 3; ++c) {
+        values[c] = 0;
+        if (counters_requested && log.fds[c] != -1 && read(log.fds[c], &values[c], sizeof(values[c])) != sizeof(values[c])) {
+            values[c] = 0;
+        }
+    }
+}
+
+instrument_scope::instrument_scope(instrument_phase phase, int k, bool region)
+    : phase(phase), k(k), region(region), active(recording.load(std::memory_order_relaxed)) {
+    if (active) {
+        read_counters(this_thread_log(), counters);
+        begin = now_ns();
+    }
+}
+
+instrument_scope::~instrument_scope() {
+    if (!active) {
+        return;
+    }
+    long long end = now_ns();
+    thread_log & log = *local_log;
+    instrument_event event{phase, k, omp_get_thread_num(), region, begin, end, {}};
+    read_counters(log, event.counters);
+    for (int c = 0; c < 3; ++c) {
+        event.counters[c] -= counters[c];
+    }
+    log.events.push_back(event);
+}
+
+int instrument_start(bool hardware_counters) {
+    std::lock_guard<std::mutex> lock(logs_mutex);
+    for (std::unique_ptr<thread_log> & log : logs) {
+        log->events.clear();
+    }
+    counters_requested = hardware_counters;
+    epoch = std::chrono::steady_clock::now();
+    recording = true;
+    return 1;
+}
+
+void instrument_stop() {
+    recording = false;
+}
+
+/**
+ * @brief Returns the events of all threads, ordered by start time.
+ */
+static std::vector<instrument_event> collect_events() {
+    std::lock_guard<std::mutex> lock(logs_mutex);
+    std::vector<instrument_event> events;
+    for (const std::unique_ptr<thread_log> & log : logs) {
+        events.insert(events.end(), log->events.begin(), log->events.end());
+    }
+    std::sort(events.begin(), events.end(), [](const instrument_event & a, const instrument_event & b) { return a.begin < b.begin; });
+    return events;
+}
+
+void print_instrument_summary() {
+    // One round per region event: it gives the wall time and the end of the closing barrier. The thread events
+    // inside it give the busy time of each thread and, against that end, the time the thread waited.
+    struct round_times {
+        const instrument_event * region;
+        std::vector<const instrument_event *> threads;
+    };
+    std::vector<instrument_event> events = collect_events();
+    std::vector<round_times> rounds;
+    std::map<std::pair<instrument_phase, int>, std::vector<size_t>> rounds_of;
+    for (const instrument_event & event : events) {
+        if (event.region) {
+            rounds_of[{event.phase, event.k}].push_back(rounds.size());
+            rounds.push_back({&event, {}});
+        }
+    }
+    for (const instrument_event & event : events) {
+        if (event.region) {
+            continue;
+        }
+        for (size_t r : rounds_of[{event.phase, event.k}]) {
+            if (rounds[r].region->begin <= event.begin && event.end <= rounds[r].region->end) {
+                rounds[r].threads.push_back(&event);
+                break;
+            }
+        }
+    }
+
+    struct phase_totals {
+        int rounds = 0;
+        double wall = 0;
+        double busy_max = 0;
+        double busy_mean = 0;
+        double wait_mean = 0;
+        long long counters[3] = {0, 0, 0};
+    };
+    std::map<instrument_phase, phase_totals> totals;
+    for (const round_times & round : rounds) {
+        phase_totals & total = totals[round.region->phase];
+        double wall = static_cast<double>(round.region->end - round.region->begin);
+        total.rounds++;
+        total.wall += wall;
+        if (round.threads.empty()) {
+            // A serial phase: the region is the only thread busy.
+            total.busy_max += wall;
+            total.busy_mean += wall;
+            for (int c = 0; c < 3; ++c) {
+                total.counters[c] += round.region->counters[c];
+            }
+            continue;
+        }
+        double busy_max = 0;
+        double busy_sum = 0;
+        double wait_sum = 0;
+        for (const instrument_event * event : round.threads) {
+            double busy = static_cast<double>(event->end - event->begin);
+            busy_max = std::max(busy_max, busy);
+            busy_sum += busy;
+            wait_sum += static_cast<double>(round.region->end - event->end);
+            for (int c = 0; c < 3; ++c) {
+                total.counters[c] += event->counters[c];
+            }
+        }
+        total.busy_max += busy_max;
+        total.busy_mean += busy_sum / round.threads.size();
+        total.wait_mean += wait_sum / round.threads.size();
+    }
+
+    fmt::print("Instrumented phases (times summed over rounds):\n");
+    for (const auto & [phase, total] : totals) {
+        fmt::print(
+            "{} over {} rounds: wall {:.0f} ns, busiest thread {:.0f} ns, mean thread {:.0f} ns, imbalance {:.3f}, barrier wait {:.0f} ns per thread",
+            instrument_phase_name(phase),
+            total.rounds,
+            total.wall,
+            total.busy_max,
+            total.busy_mean,
+            total.busy_mean > 0 ? total.busy_max / total.busy_mean : 1.0,
+            total.wait_mean
+        );
+        if (counters_requested) {
+            fmt::print(", {} {}, {} {}, {} {}", counter_names[0], total.counters[0], counter_names[1], total.counters[1], counter_names[2], total.counters[2]);
+        }
+        fmt::print("\n");
+    }
+}
+
+int write_chrome_trace(const std::string & path) {
+    std::vector<instrument_event> events = collect_events();
+    std::FILE * file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        spdlog::error("Cannot write trace to {}", path);
+        return -1;
+    }
+
+    // Thread events on the track of their OpenMP thread; phase wall times on one extra "region" track after them.
+    int region_track = 0;
+    for (const instrument_event & event : events) {
+        region_track = std::max(region_track, event.thread + 1);
+    }
+    fmt::print(file, "{{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fmt::print(file, "  {{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": {}, \"args\": {{\"name\": \"region\"}}}}", region_track);
+    for (int t = 0; t < region_track; ++t) {
+        fmt::print(file, ",\n  {{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": {}, \"args\": {{\"name\": \"thread {}\"}}}}", t, t);
+    }
+    for (const instrument_event & event : events) {
+        fmt::print(
+            file,
+            ",\n  {{\"name\": \"{}\", \"cat\": \"{}\", \"ph\": \"X\", \"pid\": 0, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{\"k\": {}",
+            instrument_phase_name(event.phase),
+            event.region ? "region" : "thread",
+            event.region ? region_track : event.thread,
+            event.begin / 1e3,
+            (event.end - event.begin) / 1e3,
+            event.k
+        );
+        if (counters_requested) {
+            for (int c = 0; c < 3; ++c) {
+                fmt::print(file, ", \"{}\": {}", counter_names[c], event.counters[c]);
+            }
+        }
+        fmt::print(file, "}}}}");
+    }
+    fmt::print(file, "\n]}}\n");
+    int status = std::fclose(file) == 0 ? 1 : -1;
+    if (status == -1) {
+        spdlog::error("Cannot write trace to {}", path);
+    }
+    return status;
+}
+
+#else
+
+int instrument_start(bool) {
+    return -1;
+}
+
+void instrument_stop() {}
+
+void print_instrument_summary() {}
+
+int write_chrome_trace(const std::string &) {
+    return -1;
+}
+
+#endif
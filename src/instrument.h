@@ -0,0 +1,110 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <string>
+
+/**
+ * @brief Phases of one k-round of the blocked kernels, as recorded by `FW_INSTRUMENT_SCOPE`.
+ */
+enum class instrument_phase {
+    dependent,          // W[k][k], on the calling thread
+    row_panel,          // W[k][*]
+    column_panel,       // W[*][k]
+    panels,             // W[k][*] and W[*][k] in one loop (zero-copy kernel)
+    independent,        // All other tiles
+};
+
+/**
+ * @brief Returns the name of `phase` used in the summary and the trace, e.g. `"independent"`.
+ */
+const char * instrument_phase_name(instrument_phase phase);
+
+/**
+ * @brief Returns whether the instrumentation was compiled in (CMake option `FW_INSTRUMENT`).
+ */
+bool instrument_enabled();
+
+/**
+ * @brief Clears all recorded events and starts recording.
+ *
+ * @param hardware_counters If `true`, every thread also reads instructions, L1D read misses and LLC misses
+ *        with `perf_event_open` at the start and end of each event. Counters that cannot be opened (no
+ *        permission, e.g. `perf_event_paranoid > 2`, or no PMU in a VM) are reported once and read as `0`.
+ * @return int `1` on success, `-1` if the instrumentation was not compiled in.
+ */
+int instrument_start(bool hardware_counters);
+
+/**
+ * @brief Stops recording. The events recorded so far are kept for `print_instrument_summary` and
+ *        `write_chrome_trace`.
+ */
+void instrument_stop();
+
+/**
+ * @brief Prints, per phase, the wall time summed over all rounds, the busy time of the busiest and of the
+ *        average thread, the load imbalance (`max / mean` busy time), the time threads spent waiting in the
+ *        barrier closing the phase, and the hardware counter totals if they were read.
+ */
+void print_instrument_summary();
+
+/**
+ * @brief Writes the recorded events as Chrome trace JSON, for `chrome://tracing` or https://ui.perfetto.dev.
+ *
+ * @param path The file to create; an existing file is replaced.
+ * @return int `1` on success, or `-1` if the file cannot be written or nothing was compiled in.
+ *
+ * @details One complete (`"ph": "X"`) event per phase, round and thread, on the track of its OpenMP thread.
+ *          The phase wall time is the event on the `"region"` track; the round `k` and the counters are the
+ *          event arguments.
+ */
+int write_chrome_trace(const std::string & path);
+
+#ifdef FW_INSTRUMENT
+
+/**
+ * @brief Records one event from construction to destruction: the thread's share of `phase` in round `k`.
+ *
+ * @param region If `true`, the event is the whole phase as seen by the thread that opens and joins the
+ *        parallel region; its end is the end of the barrier that closes the phase.
+ */
+class instrument_scope {
+public:
+    instrument_scope(instrument_phase phase, int k, bool region = false);
+    ~instrument_scope();
+    instrument_scope(const instrument_scope &) = delete;
+    instrument_scope & operator=(const instrument_scope &) = delete;
+
+private:
+    instrument_phase phase;
+    int k;
+    bool region;
+    bool active;
+    long long begin;
+    long long counters[3];
+};
+
+#define FW_INSTRUMENT_CONCAT_(a, b) a##b
+#define FW_INSTRUMENT_CONCAT(a, b) FW_INSTRUMENT_CONCAT_(a, b)
+
+/**
+ * @brief Times the rest of the enclosing block as the calling thread's share of `phase` in round `k`.
+ *        Expands to nothing without `FW_INSTRUMENT`.
+ */
+#define FW_INSTRUMENT_SCOPE(phase, k) \
+    instrument_scope FW_INSTRUMENT_CONCAT(fw_instrument_, __LINE__)(instrument_phase::phase, k)
+
+/**
+ * @brief Times the rest of the enclosing block as the wall time of `phase` in round `k`, barrier included.
+ *        Expands to nothing without `FW_INSTRUMENT`.
+ */
+#define FW_INSTRUMENT_REGION(phase, k) \
+    instrument_scope FW_INSTRUMENT_CONCAT(fw_instrument_, __LINE__)(instrument_phase::phase, k, true)
+
+#else
+
+#define FW_INSTRUMENT_SCOPE(phase, k)
+#define FW_INSTRUMENT_REGION(phase, k)
+
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#include "kernel_registry.h"
+#include "kernels.h"
+#include <cstdint>
+
+template <typename T>
+static void run_serial(T * W, int n, int) { serial_floyd_warshall(W, n); }
+
+template <typename T>
+static void run_naive(T * W, int n, int) { naive_floyd_warshall(W, n); }
+
+template <typename T>
+static void run_persistent_naive(T * W, int n, int) { persistent_naive_floyd_warshall(W, n); }
+
+template <typename T>
+static void run_sparse(T * W, int n, int) { sparse_shortest_paths(W, n); }
+
+template <typename T>
+std::vector<registered_kernel<T>> registered_kernels()
+{
+    return {
+        {"serial", run_serial<T>, false, false},
+        {"naive", run_naive<T>, false, false},
+        {"persistent-naive", run_persistent_naive<T>, false, false},
+        {"blocked", blocked_floyd_warshall<T>, true, false},
+        {"persistent-blocked", persistent_blocked_floyd_warshall<T>, true, false},
+        {"zero-copy", inplace_blocked_floyd_warshall<T>, true, false},
+        {"task", task_blocked_floyd_warshall<T>, true, false},
+        {"recursive", recursive_floyd_warshall<T>, true, false},
+        {"sparse", run_sparse<T>, false, true},
+    };
+}
+
+std::vector<std::string> registered_kernel_names(bool dense_only)
+{
+    std::vector<std::string> names;
+    for (const registered_kernel<int32_t> & kernel : registered_kernels<int32_t>()) {
+        if (!dense_only || !kernel.sparse) {
+            names.push_back(kernel.name);
+        }
+    }
+    return names;
+}
+
+template std::vector<registered_kernel<int32_t>> registered_kernels<int32_t>();
+template std::vector<registered_kernel<uint16_t>> registered_kernels<uint16_t>();
+template std::vector<registered_kernel<uint8_t>> registered_kernels<uint8_t>();
+template std::vector<registered_kernel<float>> registered_kernels<float>();
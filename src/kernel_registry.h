@@ -0,0 +1,35 @@
+#ifndef KERNEL_REGISTRY_H
+#define KERNEL_REGISTRY_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief One kernel of the `benchmarks` and `scaling` targets: its name, how to call it, and the shape of its work.
+ */
+template <typename T>
+struct registered_kernel {
+    const char * name;
+    void (*run)(T *, int, int);     // Called with the matrix, `n` and the block length
+    bool tiled;                     // Takes a block length; otherwise it runs once per `n` with `b = 0`
+    bool sparse;                    // Single-source searches: O(n E) work, no k-rounds
+};
+
+/**
+ * @brief Returns every kernel that runs on a whole `n x n` matrix, under the names the `benchmarks` and
+ *        `scaling` targets accept: `serial`, `naive`, `persistent-naive`, `blocked`, `persistent-blocked`,
+ *        `zero-copy`, `task`, `recursive` and `sparse`.
+ *
+ * @tparam T The distance type (see `distance_traits`).
+ */
+template <typename T>
+std::vector<registered_kernel<T>> registered_kernels();
+
+/**
+ * @brief Returns the names of `registered_kernels`, in the same order; with `dense_only`, without `sparse`.
+ */
+std::vector<std::string> registered_kernel_names(
+    bool dense_only
+);
+
+#endif
@@ -1,5 +1,15 @@
 #include "kernels.h"
 #include "globals.h"
+#include "semiring.h"
+#include "tile.h"
+#include "paths.h"
+#include "allocator.h"
+#include "instrument.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
 #include <omp.h>
 
 /**
@@ -21,124 +31,736 @@ static int block_idx(int i, int j, int b) {
 }
 
 /**
- * @brief Performs the Floyd-Warshall algorithm on a single block of a matrix.
+ * @brief Computes the number of rows (or columns) of block `t` when `n` is divided into blocks of `b`.
  * 
- * This function computes the shortest paths within a single block of a graph's 
- * adjacency matrix, represented in a flattened format. It updates the block matrix `C` 
- * with the minimum distances using the input blocks `A` and `B`.
- * 
- * @param C A reference to a vector representing the output block (distance matrix) in flattened format.
- * @param A A reference to a vector representing the first input block (distance matrix) in flattened format.
- * @param B A reference to a vector representing the second input block (distance matrix) in flattened format.
- * @param b The size (dimensions) of the block.
+ * @param t The block index along one dimension.
+ * @param b The block size.
+ * @param n The dimension of the full matrix.
+ * @return int `b` for interior blocks, and the remainder `n - t * b` for a ragged last block.
+ */
+static int block_extent(int t, int b, int n) {
+    return std::min(b, n - t * b);
+}
+
+/**
+ * @brief Returns the distance between consecutive tiles in scratch space: `b * b` elements rounded up to a
+ *        whole number of cache lines, so every scratch tile starts `matrix_alignment`-aligned.
+ */
+template <typename T>
+static int tile_stride(int b) {
+    int line = static_cast<int>(matrix_alignment / sizeof(T));
+    return (b * b + line - 1) / line * line;
+}
+
+/**
+ * @brief Updates the packed `b x b` block `C` with `A (x) B` in the semiring `S`, via `semiring_tile` with a
+ *        leading dimension of `b`.
+ */
+template <typename S, typename T>
+static void floyd(T *C, const T *A, const T *B, int b) {
+    semiring_tile<S>(C, A, B, b, b, b, b);
+}
+
+/**
+ * @brief Returns whether every element of the `rows x cols` tile at `W` (leading dimension `ld`) is `INF`, or
+ *        `S::zero()` for another semiring.
+ */
+template <typename S, typename T>
+static bool tile_all_inf(const T *W, int rows, int cols, int ld) {
+    const T inf = S::template zero<T>();
+    for (int i = 0; i < rows; ++i) {
+        const T *row = W + static_cast<size_t>(i) * ld;
+        if (std::any_of(row, row + cols, [inf](T x) { return x != inf; })) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the tile occupancy map of the blocked kernels: one byte per tile of an `n x n` matrix in
+ *        blocks of `b`, row-major over the `B x B` tiles, `0` if the tile is all `INF` and `1` otherwise.
  * 
- * The algorithm iterates over the elements of the blocks to compute the minimum distances 
- * based on the formula: `C[i][j] = min(C[i][j], A[i][k] + B[k][j])`. It assumes all matrices 
- * are flattened and indexed using `block_idx`.
+ * A byte rather than a bit per tile, so the threads of the independent phase update their own tiles without
+ * sharing words. A min-plus product with an all-`INF` operand is all `INF`, so a `0` tile does not change the
+ * tiles it would update, and a panel tile that is `0` stays `0` for its round. The same holds for `S::zero()`
+ * of every semiring, which annihilates `⊗`.
  */
-static void floyd(std::vector<int> &C, const std::vector<int> &A, const std::vector<int> &B, int b) {
-    for (int k = 0; k < b; ++k) {
-        for (int j = 0; j < b; ++j) {
-            for (int i = 0; i < b; ++i) {
-                int c_idx = block_idx(i, j, b);
-                int a_idx = block_idx(i, k, b);
-                int b_idx = block_idx(k, j, b);
+template <typename S, typename T>
+static std::vector<uint8_t> tile_occupancy(const T *W, int n, int b) {
+    int B = (n + b - 1) / b;
+    std::vector<uint8_t> occupied(static_cast<size_t>(B) * B);
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < B; ++i) {
+        for (int j = 0; j < B; ++j) {
+            const T *Wij = W + static_cast<size_t>(i) * b * n + static_cast<size_t>(j) * b;
+            occupied[i * B + j] = !tile_all_inf<S>(Wij, block_extent(i, b, n), block_extent(j, b, n), n);
+        }
+    }
+    return occupied;
+}
 
-                // Check if paths exist before performing adition
-                if
-                (
-                    A[a_idx] != INF &&
-                    B[b_idx] != INF
-                )
-                {
-                    C[c_idx] = std::min(C[c_idx], A[a_idx] + B[b_idx]);
-                }
+template <typename T, typename S>
+void blocked_floyd_warshall(T *W, int n, int b) {
+    // Pad up to the next multiple of b. Padded vertices have no edges (INF rows and columns,
+    // 0 on the diagonal), so they never shorten a path between original vertices.
+    if (n % b != 0) {
+        int N = ((n + b - 1) / b) * b;
+        aligned_buffer<T> P(static_cast<size_t>(N) * N);
+        std::fill(P.data(), P.data() + P.size(), S::template zero<T>());
+        for (int i = 0; i < N; ++i) {
+            if (i < n) {
+                std::copy(W + i * n, W + (i + 1) * n, P.data() + i * N);
+            }
+            else {
+                P[block_idx(i, i, N)] = S::template one<T>();
             }
         }
+        blocked_floyd_warshall<T, S>(P.data(), N, b);
+        for (int i = 0; i < n; ++i) {
+            std::copy(P.data() + i * N, P.data() + i * N + n, W + i * n);
+        }
+        return;
     }
-}
 
-void blocked_floyd_warshall(std::vector<int> &W, int n, int b) {
     // Number of blocks along one dimension
     int B = n / b;
+    int stride = tile_stride<T>(b);
+    std::vector<uint8_t> occupied = tile_occupancy<S>(W, n, b);
 
     // Iterate over all block rows and columns
     for (int k = 0; k < B; ++k) {
         // Dependent Phase: Process block W[k][k]
-        std::vector<int> Wkk(b * b);
-        for (int i = 0; i < b; ++i) {
-            for (int j = 0; j < b; ++j) {
-                Wkk[block_idx(i, j, b)] = W[block_idx(k * b + i, k * b + j, n)];
+        // Tile copies live in per-thread scratch, so no tile allocates. Wkk is the first tile of the
+        // calling thread's scratch, sized up front for everything that thread also takes as a worker
+        // later, so the scratch never grows (and moves) while Wkk is in use.
+        T *Wkk = tile_scratch<T>(4 * stride);
+        {
+            FW_INSTRUMENT_REGION(dependent, k);
+            for (int i = 0; i < b; ++i) {
+                for (int j = 0; j < b; ++j) {
+                    Wkk[block_idx(i, j, b)] = W[block_idx(k * b + i, k * b + j, n)];
+                }
             }
-        }
-        floyd(Wkk, Wkk, Wkk, b);
+            floyd<S>(Wkk, Wkk, Wkk, b);
 
-        // Write back W[k][k]
-        for (int i = 0; i < b; ++i) {
-            for (int j = 0; j < b; ++j) {
-                W[block_idx(k * b + i, k * b + j, n)] = Wkk[block_idx(i, j, b)];
+            // Write back W[k][k]
+            for (int i = 0; i < b; ++i) {
+                for (int j = 0; j < b; ++j) {
+                    W[block_idx(k * b + i, k * b + j, n)] = Wkk[block_idx(i, j, b)];
+                }
             }
         }
 
         // Partially Dependent Phase: Update rows and columns around W[k][k]
-        #pragma omp parallel for
-        for (int j = 0; j < B; ++j) {
-            if (j != k) {
-                std::vector<int> Wkj(b * b), Wkj_tmp(b * b);
-                for (int i = 0; i < b; ++i) {
-                    for (int l = 0; l < b; ++l) {
-                        Wkj[block_idx(i, l, b)] = W[block_idx(k * b + i, j * b + l, n)];
-                        Wkj_tmp[block_idx(i, l, b)] = Wkj[block_idx(i, l, b)];
+        {
+            FW_INSTRUMENT_REGION(row_panel, k);
+            #pragma omp parallel
+            {
+                FW_INSTRUMENT_SCOPE(row_panel, k);
+                #pragma omp for nowait
+                for (int j = 0; j < B; ++j) {
+                    if (j != k && occupied[k * B + j]) {
+                        T *Wkj = tile_scratch<T>(3 * stride) + stride;
+                        T *Wkj_tmp = Wkj + stride;
+                        for (int i = 0; i < b; ++i) {
+                            for (int l = 0; l < b; ++l) {
+                                Wkj[block_idx(i, l, b)] = W[block_idx(k * b + i, j * b + l, n)];
+                                Wkj_tmp[block_idx(i, l, b)] = Wkj[block_idx(i, l, b)];
+                            }
+                        }
+                        floyd<S>(Wkj_tmp, Wkk, Wkj, b);
+                        for (int i = 0; i < b; ++i) {
+                            for (int l = 0; l < b; ++l) {
+                                W[block_idx(k * b + i, j * b + l, n)] = Wkj_tmp[block_idx(i, l, b)];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        {
+            FW_INSTRUMENT_REGION(column_panel, k);
+            #pragma omp parallel
+            {
+                FW_INSTRUMENT_SCOPE(column_panel, k);
+                #pragma omp for nowait
+                for (int i = 0; i < B; ++i) {
+                    if (i != k && occupied[i * B + k]) {
+                        T *Wik = tile_scratch<T>(3 * stride) + stride;
+                        T *Wik_tmp = Wik + stride;
+                        for (int j = 0; j < b; ++j) {
+                            for (int l = 0; l < b; ++l) {
+                                Wik[block_idx(j, l, b)] = W[block_idx(i * b + j, k * b + l, n)];
+                                Wik_tmp[block_idx(j, l, b)] = Wik[block_idx(j, l, b)];
+                            }
+                        }
+                        floyd<S>(Wik_tmp, Wik, Wkk, b);
+                        for (int j = 0; j < b; ++j) {
+                            for (int l = 0; l < b; ++l) {
+                                W[block_idx(i * b + j, k * b + l, n)] = Wik_tmp[block_idx(j, l, b)];
+                            }
+                        }
                     }
                 }
-                floyd(Wkj_tmp, Wkk, Wkj, b);
-                for (int i = 0; i < b; ++i) {
-                    for (int l = 0; l < b; ++l) {
-                        W[block_idx(k * b + i, j * b + l, n)] = Wkj_tmp[block_idx(i, l, b)];
+            }
+        }
+
+        // Independent Phase: Update all other blocks
+        {
+            FW_INSTRUMENT_REGION(independent, k);
+            #pragma omp parallel
+            {
+                FW_INSTRUMENT_SCOPE(independent, k);
+                #pragma omp for nowait
+                for (int i = 0; i < B; ++i) {
+                    if (i != k && occupied[i * B + k]) {
+                        for (int j = 0; j < B; ++j) {
+                            if (j != k && occupied[k * B + j]) {
+                                T *Wij = tile_scratch<T>(4 * stride) + stride;
+                                T *Wik = Wij + stride;
+                                T *Wkj = Wik + stride;
+                                for (int x = 0; x < b; ++x) {
+                                    for (int y = 0; y < b; ++y) {
+                                        Wij[block_idx(x, y, b)] = W[block_idx(i * b + x, j * b + y, n)];
+                                        Wik[block_idx(x, y, b)] = W[block_idx(i * b + x, k * b + y, n)];
+                                        Wkj[block_idx(x, y, b)] = W[block_idx(k * b + x, j * b + y, n)];
+                                    }
+                                }
+                                floyd<S>(Wij, Wik, Wkj, b);
+                                for (int x = 0; x < b; ++x) {
+                                    for (int y = 0; y < b; ++y) {
+                                        W[block_idx(i * b + x, j * b + y, n)] = Wij[block_idx(x, y, b)];
+                                    }
+                                }
+                                if (!occupied[i * B + j]) {
+                                    occupied[i * B + j] = !tile_all_inf<S>(Wij, b, b, b);
+                                }
+                            }
+                        }
                     }
                 }
             }
         }
+    }
+}
 
-        #pragma omp parallel for
+template <typename T, typename S>
+void inplace_blocked_floyd_warshall(T *W, int n, int b) {
+    // Number of blocks along one dimension, the last one may be ragged
+    int B = (n + b - 1) / b;
+    T *w = W;
+    std::vector<uint8_t> occupied = tile_occupancy<S>(W, n, b);
+
+    for (int k = 0; k < B; ++k) {
+        int bk = block_extent(k, b, n);
+
+        // Dependent Phase: Process block W[k][k] in place
+        T *Wkk = w + block_idx(k * b, k * b, n);
+        {
+            FW_INSTRUMENT_REGION(dependent, k);
+            semiring_tile<S>(Wkk, Wkk, Wkk, bk, bk, bk, n);
+        }
+
+        // Partially Dependent Phase: Row panel W[k][*] and column panel W[*][k] only read W[k][k],
+        // so both are processed in a single parallel loop.
+        {
+            FW_INSTRUMENT_REGION(panels, k);
+            #pragma omp parallel
+            {
+                FW_INSTRUMENT_SCOPE(panels, k);
+                #pragma omp for nowait
+                for (int x = 0; x < 2 * B; ++x) {
+                    int l = x % B;
+                    if (l == k || !occupied[x < B ? k * B + l : l * B + k]) {
+                        continue;
+                    }
+                    int bl = block_extent(l, b, n);
+                    if (x < B) {
+                        T *Wkj = w + block_idx(k * b, l * b, n);
+                        semiring_tile<S>(Wkj, Wkk, Wkj, bk, bl, bk, n);
+                    }
+                    else {
+                        T *Wik = w + block_idx(l * b, k * b, n);
+                        semiring_tile<S>(Wik, Wik, Wkk, bl, bk, bk, n);
+                    }
+                }
+            }
+        }
+
+        // Independent Phase: Update all other blocks
+        {
+            FW_INSTRUMENT_REGION(independent, k);
+            #pragma omp parallel
+            {
+                FW_INSTRUMENT_SCOPE(independent, k);
+                #pragma omp for nowait
+                for (int i = 0; i < B; ++i) {
+                    if (i != k && occupied[i * B + k]) {
+                        int bi = block_extent(i, b, n);
+                        const T *Wik = w + block_idx(i * b, k * b, n);
+                        for (int j = 0; j < B; ++j) {
+                            if (j != k && occupied[k * B + j]) {
+                                int bj = block_extent(j, b, n);
+                                T *Wij = w + block_idx(i * b, j * b, n);
+                                const T *Wkj = w + block_idx(k * b, j * b, n);
+                                semiring_tile<S>(Wij, Wik, Wkj, bi, bj, bk, n);
+                                if (!occupied[i * B + j]) {
+                                    occupied[i * B + j] = !tile_all_inf<S>(Wij, bi, bj, n);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief A centralized sense-reversing barrier for the threads of one persistent parallel region.
+ * 
+ * The last thread to arrive resets the count and flips the shared sense; the others spin on it, and yield after
+ * a short spin so an oversubscribed team still makes progress. Each thread keeps its own sense, starting `false`.
+ */
+class sense_barrier {
+public:
+    /**
+     * @brief Sets the team size. Call once, from one thread, before any `wait`.
+     */
+    void reset(int threads) {
+        team = threads;
+        waiting.store(threads, std::memory_order_relaxed);
+        sense.store(false, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Blocks until all `team` threads have called `wait` with their own `local_sense`. Writes before the
+     *        barrier are visible to every thread after it.
+     */
+    void wait(bool & local_sense) {
+        local_sense = !local_sense;
+        if (waiting.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            waiting.store(team, std::memory_order_relaxed);
+            sense.store(local_sense, std::memory_order_release);
+            return;
+        }
+        for (int spins = 0; sense.load(std::memory_order_acquire) != local_sense; ++spins) {
+            if (spins >= 1024) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    alignas(64) std::atomic<int> waiting{0};
+    alignas(64) std::atomic<bool> sense{false};
+    int team = 0;
+};
+
+template <typename T>
+void persistent_blocked_floyd_warshall(T *W, int n, int b) {
+    // Number of blocks along one dimension, the last one may be ragged
+    int B = (n + b - 1) / b;
+    sense_barrier barrier;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        barrier.reset(omp_get_num_threads());
+        bool sense = false;
+        const bool leader = omp_get_thread_num() == 0;
+        aligned_buffer<T> panel(static_cast<size_t>(b) * n);
+
+        for (int k = 0; k < B; ++k) {
+            int bk = block_extent(k, b, n);
+
+            // Dependent Phase: Process block W[k][k] in place
+            T *Wkk = W + block_idx(k * b, k * b, n);
+            if (leader) {
+                minplus_tile(Wkk, Wkk, Wkk, bk, bk, bk, n);
+            }
+            barrier.wait(sense);
+
+            // Partially Dependent Phase: Row and column panels in one loop
+            #pragma omp for schedule(static) nowait
+            for (int x = 0; x < 2 * B; ++x) {
+                int l = x % B;
+                if (l == k) {
+                    continue;
+                }
+                int bl = block_extent(l, b, n);
+                if (x < B) {
+                    T *Wkj = W + block_idx(k * b, l * b, n);
+                    minplus_tile(Wkj, Wkk, Wkj, bk, bl, bk, n);
+                }
+                else {
+                    T *Wik = W + block_idx(l * b, k * b, n);
+                    minplus_tile(Wik, Wik, Wkk, bl, bk, bk, n);
+                }
+            }
+            barrier.wait(sense);
+
+            // Broadcast: the row panel is final for this round and not written again until the next one
+            std::copy(W + block_idx(k * b, 0, n), W + block_idx(k * b + bk, 0, n), panel.data());
+
+            // Independent Phase: Update all other blocks, reading W[k][*] from the private copy
+            #pragma omp for schedule(static) nowait
+            for (int i = 0; i < B; ++i) {
+                if (i != k) {
+                    int bi = block_extent(i, b, n);
+                    const T *Wik = W + block_idx(i * b, k * b, n);
+                    for (int j = 0; j < B; ++j) {
+                        if (j != k) {
+                            T *Wij = W + block_idx(i * b, j * b, n);
+                            minplus_tile(Wij, Wik, panel.data() + j * b, bi, block_extent(j, b, n), bk, n);
+                        }
+                    }
+                }
+            }
+            barrier.wait(sense);
+        }
+    }
+}
+
+template <typename T, typename S>
+void task_blocked_floyd_warshall(T *W, int n, int b) {
+    // Number of blocks along one dimension, the last one may be ragged
+    int B = (n + b - 1) / b;
+    T *w = W;
+
+    // One dependency token per tile. Tasks depend on tokens, so the runtime sees the tile DAG
+    // without the clauses having to describe strided matrix memory.
+    std::vector<char> tokens(B * B);
+    char *t = tokens.data();
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        for (int k = 0; k < B; ++k) {
+            int bk = block_extent(k, b, n);
+            T *Wkk = w + block_idx(k * b, k * b, n);
+
+            // Dependent Phase: W[k][k] waits only for its own update from round k - 1
+            #pragma omp task depend(inout: t[k * B + k])
+            semiring_tile<S>(Wkk, Wkk, Wkk, bk, bk, bk, n);
+
+            // Partially Dependent Phase: each panel tile waits for W[k][k] and its own previous update
+            for (int l = 0; l < B; ++l) {
+                if (l == k) {
+                    continue;
+                }
+                int bl = block_extent(l, b, n);
+                T *Wkj = w + block_idx(k * b, l * b, n);
+                T *Wik = w + block_idx(l * b, k * b, n);
+
+                #pragma omp task depend(in: t[k * B + k]) depend(inout: t[k * B + l])
+                semiring_tile<S>(Wkj, Wkk, Wkj, bk, bl, bk, n);
+
+                #pragma omp task depend(in: t[k * B + k]) depend(inout: t[l * B + k])
+                semiring_tile<S>(Wik, Wik, Wkk, bl, bk, bk, n);
+            }
+
+            // Independent Phase: W[i][j] waits for W[i][k] and W[k][j] of this round only, so it can
+            // overlap with tiles of other rounds whose inputs are already final.
+            for (int i = 0; i < B; ++i) {
+                if (i == k) {
+                    continue;
+                }
+                int bi = block_extent(i, b, n);
+                for (int j = 0; j < B; ++j) {
+                    if (j == k) {
+                        continue;
+                    }
+                    int bj = block_extent(j, b, n);
+                    T *Wij = w + block_idx(i * b, j * b, n);
+                    const T *Wik = w + block_idx(i * b, k * b, n);
+                    const T *Wkj = w + block_idx(k * b, j * b, n);
+
+                    #pragma omp task depend(in: t[i * B + k], t[k * B + j]) depend(inout: t[i * B + j])
+                    semiring_tile<S>(Wij, Wik, Wkj, bi, bj, bk, n);
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void interleave_matrices(const T * const * matrices, int count, int n, T * W) {
+    constexpr int L = interleave_lanes<T>();
+    const size_t cells = static_cast<size_t>(n) * n;
+    for (size_t c = 0; c < cells; ++c) {
+        for (int g = 0; g < L; ++g) {
+            W[c * L + g] = g < count ? matrices[g][c] : T(0);
+        }
+    }
+}
+
+template <typename T>
+void deinterleave_matrices(const T * W, int count, int n, T * const * matrices) {
+    constexpr int L = interleave_lanes<T>();
+    const size_t cells = static_cast<size_t>(n) * n;
+    for (size_t c = 0; c < cells; ++c) {
+        for (int g = 0; g < count; ++g) {
+            matrices[g][c] = W[c * L + g];
+        }
+    }
+}
+
+template <typename T>
+void interleaved_floyd_warshall(T *W, int n, int b) {
+    constexpr int L = interleave_lanes<T>();
+    int B = (n + b - 1) / b;
+    auto tile = [&](int I, int J) { return W + (static_cast<size_t>(I) * b * n + static_cast<size_t>(J) * b) * L; };
+
+    for (int k = 0; k < B; ++k) {
+        int bk = block_extent(k, b, n);
+        T *Wkk = tile(k, k);
+        minplus_interleaved_tile(Wkk, Wkk, Wkk, bk, bk, bk, n);
+        for (int l = 0; l < B; ++l) {
+            if (l != k) {
+                int bl = block_extent(l, b, n);
+                minplus_interleaved_tile(tile(k, l), Wkk, tile(k, l), bk, bl, bk, n);
+                minplus_interleaved_tile(tile(l, k), tile(l, k), Wkk, bl, bk, bk, n);
+            }
+        }
         for (int i = 0; i < B; ++i) {
-            if (i != k) {
-                std::vector<int> Wik(b * b), Wik_tmp(b * b);
-                for (int j = 0; j < b; ++j) {
-                    for (int l = 0; l < b; ++l) {
-                        Wik[block_idx(j, l, b)] = W[block_idx(i * b + j, k * b + l, n)];
-                        Wik_tmp[block_idx(j, l, b)] = Wik[block_idx(j, l, b)];
+            if (i == k) {
+                continue;
+            }
+            for (int j = 0; j < B; ++j) {
+                if (j != k) {
+                    minplus_interleaved_tile(tile(i, j), tile(i, k), tile(k, j), block_extent(i, b, n), block_extent(j, b, n), bk, n);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns where to split a dimension of extent `x` in the recursive kernel: about half, rounded up to a
+ *        multiple of the leaf size `leaf`, or `x` itself when it is already a leaf.
+ */
+static int split_extent(int x, int leaf) {
+    if (x <= leaf) {
+        return x;
+    }
+    return (x / 2 + leaf - 1) / leaf * leaf;
+}
+
+/**
+ * @brief Computes `A = min(A, B (x) C)` in Floyd-Warshall order, where `A` is `rows x cols`, `B` is
+ *        `rows x depth` and `C` is `depth x cols`, all with leading dimension `ld`. `B` and `C` may alias `A`.
+ */
+template <typename T>
+static void kleene(T *A, const T *B, const T *C, int rows, int cols, int depth, int ld, int leaf) {
+    if (rows <= leaf && cols <= leaf && depth <= leaf) {
+        minplus_tile(A, B, C, rows, cols, depth, ld);
+        return;
+    }
+
+    const int r[2] = {split_extent(rows, leaf), rows - split_extent(rows, leaf)};
+    const int c[2] = {split_extent(cols, leaf), cols - split_extent(cols, leaf)};
+    const int d[2] = {split_extent(depth, leaf), depth - split_extent(depth, leaf)};
+    const bool product = A != B && A != C;
+    const bool spawn = std::max(rows, std::max(cols, depth)) >= 4 * leaf;
+
+    auto quadrant = [&](int i, int j, int k) {
+        if (r[i] == 0 || c[j] == 0 || d[k] == 0) {
+            return;
+        }
+        kleene(
+            A + block_idx(i * r[0], j * c[0], ld),
+            B + block_idx(i * r[0], k * d[0], ld),
+            C + block_idx(k * d[0], j * c[0], ld),
+            r[i], c[j], d[k], ld, leaf
+        );
+    };
+
+    for (int k = 0; k < 2; ++k) {
+        // First half of k: 11, {12, 21}, 22. Second half: 22, {21, 12}, 11.
+        int first = k == 0 ? 0 : 1;
+        int last = 1 - first;
+        if (!spawn) {
+            quadrant(first, first, k);
+            quadrant(first, last, k);
+            quadrant(last, first, k);
+            quadrant(last, last, k);
+            continue;
+        }
+        if (product) {
+            // A aliases neither input: the four quadrants of this half are independent.
+            #pragma omp task
+            quadrant(first, first, k);
+            #pragma omp task
+            quadrant(last, last, k);
+        }
+        else {
+            quadrant(first, first, k);
+        }
+        #pragma omp task
+        quadrant(first, last, k);
+        #pragma omp task
+        quadrant(last, first, k);
+        #pragma omp taskwait
+        if (!product) {
+            quadrant(last, last, k);
+        }
+    }
+}
+
+template <typename T>
+void recursive_floyd_warshall(T *W, int n, int b) {
+    #pragma omp parallel
+    #pragma omp single
+    kleene(W, W, W, n, n, n, n, b);
+}
+
+template <typename T>
+void naive_floyd_warshall(T *graph, int vertices)
+{
+    const T inf = distance_traits<T>::inf();
+    for (int k = 0; k < vertices; k++) {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < vertices; i++) {
+            for (int j = 0; j < vertices; j++) {
+                if
+                (
+                    graph[i * vertices + j] > (graph[i * vertices + k] + graph[k * vertices + j]) &&
+                    graph[k * vertices + j] != inf &&
+                    graph[i * vertices + k] != inf
+                )
+                {
+                    graph[i * vertices + j] = graph[i * vertices + k] + graph[k * vertices + j];
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void persistent_naive_floyd_warshall(T *graph, int vertices)
+{
+    const T inf = distance_traits<T>::inf();
+    sense_barrier barrier;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        barrier.reset(omp_get_num_threads());
+        bool sense = false;
+        aligned_buffer<T> row(vertices);
+
+        for (int k = 0; k < vertices; k++) {
+            // Row k is not written in round k, so it can be copied while other threads update their rows.
+            std::copy(graph + k * vertices, graph + (k + 1) * vertices, row.data());
+            #pragma omp for schedule(static) nowait
+            for (int i = 0; i < vertices; i++) {
+                T *graph_i = graph + i * vertices;
+                const T graph_ik = graph_i[k];
+                if (i == k || graph_ik == inf) {
+                    continue;
+                }
+                for (int j = 0; j < vertices; j++) {
+                    if (graph_i[j] > (graph_ik + row[j]) && row[j] != inf) {
+                        graph_i[j] = graph_ik + row[j];
                     }
                 }
-                floyd(Wik_tmp, Wik, Wkk, b);
-                for (int j = 0; j < b; ++j) {
-                    for (int l = 0; l < b; ++l) {
-                        W[block_idx(i * b + j, k * b + l, n)] = Wik_tmp[block_idx(j, l, b)];
+            }
+            barrier.wait(sense);
+        }
+    }
+}
+
+template <typename T, typename S>
+void serial_floyd_warshall(T *graph, int vertices)
+{
+    if constexpr (std::is_same_v<S, min_plus>) {
+        const T inf = distance_traits<T>::inf();
+        for (int k = 0; k < vertices; k++) {
+            for (int i = 0; i < vertices; i++) {
+                for (int j = 0; j < vertices; j++) {
+                    if
+                    (
+                        graph[i * vertices + j] > (graph[i * vertices + k] + graph[k * vertices + j]) &&
+                        graph[k * vertices + j] != inf &&
+                        graph[i * vertices + k] != inf
+                    )
+                    {
+                        graph[i * vertices + j] = graph[i * vertices + k] + graph[k * vertices + j];
                     }
                 }
             }
         }
+    }
+    else {
+        const T zero = S::template zero<T>();
+        for (int k = 0; k < vertices; k++) {
+            for (int i = 0; i < vertices; i++) {
+                T through = graph[i * vertices + k];
+                if (through == zero) {
+                    continue;
+                }
+                for (int j = 0; j < vertices; j++) {
+                    graph[i * vertices + j] = semiring_apply<S::plus>(
+                        graph[i * vertices + j],
+                        semiring_apply<S::times>(through, graph[k * vertices + j])
+                    );
+                }
+            }
+        }
+    }
+}
+
+template <typename T, typename I>
+void blocked_floyd_warshall(T *W, I *next, int n, int b) {
+    init_next_hop(W, next, n);
+
+    // Number of blocks along one dimension, the last one may be ragged
+    int B = (n + b - 1) / b;
+
+    for (int k = 0; k < B; ++k) {
+        int bk = block_extent(k, b, n);
+
+        // Dependent Phase: Process block W[k][k] in place
+        T *Wkk = W + block_idx(k * b, k * b, n);
+        I *Nkk = next + block_idx(k * b, k * b, n);
+        minplus_tile_next(Wkk, Nkk, Wkk, Nkk, Wkk, bk, bk, bk, n);
+
+        // Partially Dependent Phase: Row panel W[k][*] takes its hops from W[k][k], column panel W[*][k] from itself.
+        #pragma omp parallel for
+        for (int x = 0; x < 2 * B; ++x) {
+            int l = x % B;
+            if (l == k) {
+                continue;
+            }
+            int bl = block_extent(l, b, n);
+            if (x < B) {
+                T *Wkj = W + block_idx(k * b, l * b, n);
+                I *Nkj = next + block_idx(k * b, l * b, n);
+                minplus_tile_next(Wkj, Nkj, Wkk, Nkk, Wkj, bk, bl, bk, n);
+            }
+            else {
+                T *Wik = W + block_idx(l * b, k * b, n);
+                I *Nik = next + block_idx(l * b, k * b, n);
+                minplus_tile_next(Wik, Nik, Wik, Nik, Wkk, bl, bk, bk, n);
+            }
+        }
 
         // Independent Phase: Update all other blocks
         #pragma omp parallel for
         for (int i = 0; i < B; ++i) {
             if (i != k) {
+                int bi = block_extent(i, b, n);
+                const T *Wik = W + block_idx(i * b, k * b, n);
+                const I *Nik = next + block_idx(i * b, k * b, n);
                 for (int j = 0; j < B; ++j) {
                     if (j != k) {
-                        std::vector<int> Wij(b * b), Wik(b * b), Wkj(b * b);
-                        for (int x = 0; x < b; ++x) {
-                            for (int y = 0; y < b; ++y) {
-                                Wij[block_idx(x, y, b)] = W[block_idx(i * b + x, j * b + y, n)];
-                                Wik[block_idx(x, y, b)] = W[block_idx(i * b + x, k * b + y, n)];
-                                Wkj[block_idx(x, y, b)] = W[block_idx(k * b + x, j * b + y, n)];
-                            }
-                        }
-                        floyd(Wij, Wik, Wkj, b);
-                        for (int x = 0; x < b; ++x) {
-                            for (int y = 0; y < b; ++y) {
-                                W[block_idx(i * b + x, j * b + y, n)] = Wij[block_idx(x, y, b)];
-                            }
-                        }
+                        T *Wij = W + block_idx(i * b, j * b, n);
+                        I *Nij = next + block_idx(i * b, j * b, n);
+                        const T *Wkj = W + block_idx(k * b, j * b, n);
+                        minplus_tile_next(Wij, Nij, Wik, Nik, Wkj, bi, block_extent(j, b, n), bk, n);
                     }
                 }
             }
@@ -146,8 +768,11 @@ void blocked_floyd_warshall(std::vector<int> &W, int n, int b) {
     }
 }
 
-void naive_floyd_warshall(std::vector<int> &graph, int vertices)
+template <typename T, typename I>
+void naive_floyd_warshall(T *graph, I *next, int vertices)
 {
+    const T inf = distance_traits<T>::inf();
+    init_next_hop(graph, next, vertices);
     for (int k = 0; k < vertices; k++) {
         #pragma omp parallel for schedule(static)
         for (int i = 0; i < vertices; i++) {
@@ -155,32 +780,207 @@ void naive_floyd_warshall(std::vector<int> &graph, int vertices)
                 if
                 (
                     graph[i * vertices + j] > (graph[i * vertices + k] + graph[k * vertices + j]) &&
-                    graph[k * vertices + j] != INF &&
-                    graph[i * vertices + k] != INF
+                    graph[k * vertices + j] != inf &&
+                    graph[i * vertices + k] != inf
                 )
                 {
                     graph[i * vertices + j] = graph[i * vertices + k] + graph[k * vertices + j];
+                    next[i * vertices + j] = next[i * vertices + k];
                 }
             }
         }
     }
 }
 
-void serial_floyd_warshall(std::vector<int> &graph, int vertices)
+template <typename T, typename I>
+void serial_floyd_warshall(T *graph, I *next, int vertices)
 {
+    const T inf = distance_traits<T>::inf();
+    init_next_hop(graph, next, vertices);
     for (int k = 0; k < vertices; k++) {
         for (int i = 0; i < vertices; i++) {
             for (int j = 0; j < vertices; j++) {
                 if
                 (
                     graph[i * vertices + j] > (graph[i * vertices + k] + graph[k * vertices + j]) &&
-                    graph[k * vertices + j] != INF &&
-                    graph[i * vertices + k] != INF
+                    graph[k * vertices + j] != inf &&
+                    graph[i * vertices + k] != inf
                 )
                 {
                     graph[i * vertices + j] = graph[i * vertices + k] + graph[k * vertices + j];
+                    next[i * vertices + j] = next[i * vertices + k];
                 }
             }
         }
     }
-}
\ No newline at end of file
+}
+
+template <typename T>
+csr_graph<T> build_csr(const T * graph, int vertices)
+{
+    const T inf = distance_traits<T>::inf();
+    csr_graph<T> csr;
+    csr.vertices = vertices;
+    csr.offsets.assign(vertices + 1, 0);
+
+    // Count the out-edges of every row, then turn the counts into offsets.
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < vertices; i++) {
+        const T * row = graph + static_cast<size_t>(i) * vertices;
+        long long count = 0;
+        for (int j = 0; j < vertices; j++) {
+            if (j != i && row[j] != inf) {
+                count++;
+            }
+        }
+        csr.offsets[i + 1] = count;
+    }
+    for (int i = 0; i < vertices; i++) {
+        csr.offsets[i + 1] += csr.offsets[i];
+    }
+
+    csr.targets.resize(csr.offsets[vertices]);
+    csr.weights.resize(csr.offsets[vertices]);
+    bool unit = true;
+    #pragma omp parallel for schedule(static) reduction(&& : unit)
+    for (int i = 0; i < vertices; i++) {
+        const T * row = graph + static_cast<size_t>(i) * vertices;
+        long long e = csr.offsets[i];
+        for (int j = 0; j < vertices; j++) {
+            if (j != i && row[j] != inf) {
+                csr.targets[e] = j;
+                csr.weights[e] = row[j];
+                unit = unit && row[j] == 1;
+                e++;
+            }
+        }
+    }
+    csr.unit_weights = unit;
+    return csr;
+}
+
+/**
+ * @brief Breadth-first search from `source` over a unit-weight graph, writing hop counts into `dist`.
+ * 
+ * @param queue Scratch space of at least `csr.vertices` entries, reused across calls by the same thread.
+ */
+template <typename T>
+static void bfs_row(const csr_graph<T> & csr, int source, T * dist, std::vector<int> & queue) {
+    const T inf = distance_traits<T>::inf();
+    std::fill(dist, dist + csr.vertices, inf);
+    dist[source] = 0;
+    size_t head = 0;
+    size_t tail = 0;
+    queue[tail++] = source;
+    while (head < tail) {
+        int u = queue[head++];
+        T next = distance_traits<T>::add(dist[u], 1);
+        if (next == inf) {
+            break;
+        }
+        for (long long e = csr.offsets[u]; e < csr.offsets[u + 1]; e++) {
+            int v = csr.targets[e];
+            if (dist[v] == inf) {
+                dist[v] = next;
+                queue[tail++] = v;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Dijkstra search from `source`, writing distances into `dist`.
+ * 
+ * @param heap Scratch min-heap of `(distance, vertex)` pairs, reused across calls by the same thread.
+ *             Stale entries are skipped when popped instead of being decreased in place.
+ */
+template <typename T>
+static void dijkstra_row(const csr_graph<T> & csr, int source, T * dist, std::vector<std::pair<T, int>> & heap) {
+    const T inf = distance_traits<T>::inf();
+    auto later = [](const std::pair<T, int> & a, const std::pair<T, int> & b) { return a.first > b.first; };
+    std::fill(dist, dist + csr.vertices, inf);
+    dist[source] = 0;
+    heap.clear();
+    heap.emplace_back(T(0), source);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto [d, u] = heap.back();
+        heap.pop_back();
+        if (d > dist[u]) {
+            continue;
+        }
+        for (long long e = csr.offsets[u]; e < csr.offsets[u + 1]; e++) {
+            int v = csr.targets[e];
+            T candidate = distance_traits<T>::add(d, csr.weights[e]);
+            if (candidate < dist[v]) {
+                dist[v] = candidate;
+                heap.emplace_back(candidate, v);
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+}
+
+template <typename T>
+void sparse_shortest_paths(T * graph, int vertices)
+{
+    const csr_graph<T> csr = build_csr(graph, vertices);
+
+    #pragma omp parallel
+    {
+        std::vector<int> queue;
+        std::vector<std::pair<T, int>> heap;
+        if (csr.unit_weights) {
+            queue.resize(vertices);
+        }
+
+        #pragma omp for schedule(dynamic, 16)
+        for (int source = 0; source < vertices; source++) {
+            T * dist = graph + static_cast<size_t>(source) * vertices;
+            if (csr.unit_weights) {
+                bfs_row(csr, source, dist, queue);
+            }
+            else {
+                dijkstra_row(csr, source, dist, heap);
+            }
+        }
+    }
+}
+
+#define INSTANTIATE_PATH_KERNELS(T, I) \
+    template void blocked_floyd_warshall<T, I>(T *, I *, int, int); \
+    template void naive_floyd_warshall<T, I>(T *, I *, int); \
+    template void serial_floyd_warshall<T, I>(T *, I *, int);
+
+#define INSTANTIATE_SEMIRING_KERNELS(T, S) \
+    template void blocked_floyd_warshall<T, S>(T *, int, int); \
+    template void inplace_blocked_floyd_warshall<T, S>(T *, int, int); \
+    template void task_blocked_floyd_warshall<T, S>(T *, int, int); \
+    template void serial_floyd_warshall<T, S>(T *, int);
+
+#define INSTANTIATE_KERNELS(T) \
+    template void blocked_floyd_warshall<T>(T *, int, int); \
+    template void inplace_blocked_floyd_warshall<T>(T *, int, int); \
+    template void task_blocked_floyd_warshall<T>(T *, int, int); \
+    template void recursive_floyd_warshall<T>(T *, int, int); \
+    template void interleave_matrices<T>(const T * const *, int, int, T *); \
+    template void deinterleave_matrices<T>(const T *, int, int, T * const *); \
+    template void interleaved_floyd_warshall<T>(T *, int, int); \
+    template void naive_floyd_warshall<T>(T *, int); \
+    template void persistent_naive_floyd_warshall<T>(T *, int); \
+    template void persistent_blocked_floyd_warshall<T>(T *, int, int); \
+    template csr_graph<T> build_csr<T>(const T *, int); \
+    template void sparse_shortest_paths<T>(T *, int); \
+    template void serial_floyd_warshall<T>(T *, int); \
+    INSTANTIATE_SEMIRING_KERNELS(T, max_min) \
+    INSTANTIATE_SEMIRING_KERNELS(T, or_and) \
+    INSTANTIATE_PATH_KERNELS(T, uint8_t) \
+    INSTANTIATE_PATH_KERNELS(T, uint16_t) \
+    INSTANTIATE_PATH_KERNELS(T, uint32_t)
+
+INSTANTIATE_KERNELS(int32_t)
+INSTANTIATE_KERNELS(uint16_t)
+INSTANTIATE_KERNELS(uint8_t)
+INSTANTIATE_KERNELS(float)
+INSTANTIATE_SEMIRING_KERNELS(int32_t, max_plus)
+INSTANTIATE_SEMIRING_KERNELS(float, max_plus)
@@ -1,6 +1,9 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include "globals.h"
+#include "semiring.h"
+#include "tile.h"
 #include <vector>
 
 /**
@@ -11,9 +14,13 @@
  * It processes the matrix in phases: computing paths within a block (dependent phase), updating surrounding rows and columns
  * (partially dependent phase), and updating all other blocks (independent phase). It employs parallelization for improved performance.
  * 
- * @param W A reference to a vector representing the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @tparam S The semiring policy (see semiring.h), `min_plus` by default. With another policy the kernel computes
+ *           that semiring's all-pairs closure with the same tiling, SIMD kernels and tile skipping; `W` must then be
+ *           in the policy's convention (see `semiring_from_distances`).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
  * @param n The dimension (number of vertices) of the adjacency matrix. The matrix is assumed to be `n x n`.
- * @param b The size of the blocks into which the adjacency matrix is divided. Must be a divisor of `n`.
+ * @param b The size of the blocks into which the adjacency matrix is divided. Any value in `[1, n]`.
  * 
  * The algorithm is organized into phases:
  * - **Dependent Phase**: Computes shortest paths within the diagonal block `W[k][k]`.
@@ -21,12 +28,170 @@
  * - **Independent Phase**: Updates all other blocks using the results from the previous phases.
  * 
  * The function uses helper functions `block_idx` to calculate indices in flattened blocks and `floyd` to compute shortest paths within a block.
+ * `floyd` forwards to the runtime-dispatched SIMD kernel `minplus_tile` (see tile.h).
  * OpenMP directives are used to parallelize certain phases for improved performance.
  * 
- * @note The input matrix `W` must be flattened and should have dimensions that are divisible by `b` to ensure proper block alignment.
+ * Tiles that are entirely `INF` are tracked in a one-byte-per-tile occupancy map, built once per call: a panel
+ * or independent update whose `W[i][k]` or `W[k][j]` tile is all `INF` cannot change anything and is skipped,
+ * copies included, and a skipped row of tiles costs one byte test. An independent tile that was all `INF` is
+ * rescanned after its update. On sparse graphs most tiles of the early rounds are skipped.
+ * 
+ * @note The input matrix `W` must be flattened. If `n` is not divisible by `b`, the matrix is internally padded
+ *       to the next multiple of `b` with `INF` rows and columns (and `0` on the padded diagonal), solved, and the
+ *       `n x n` result is copied back. The padded copy costs one extra matrix of memory for the duration of the call.
+ *       With another semiring, "`INF`" and "`0`" read as `S::zero()` and `S::one()` throughout.
  */
+template <typename T, typename S = min_plus>
 void blocked_floyd_warshall(
-    std::vector<int> & W,
+    T * W,
+    int n,
+    int b
+);
+
+/**
+ * @brief Performs the blocked Floyd-Warshall algorithm directly on the matrix, without per-tile copies.
+ * 
+ * This function follows the same three-phase schedule as `blocked_floyd_warshall`, but every block is
+ * processed through a strided view into `W` rather than being copied into freshly allocated `b x b`
+ * buffers and written back. No heap allocation happens inside the k-loop. Each block is handed to `minplus_tile`
+ * with a leading dimension of `n`.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @tparam S The semiring policy, `min_plus` by default (see `blocked_floyd_warshall`).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @param n The dimension (number of vertices) of the adjacency matrix. The matrix is assumed to be `n x n`.
+ * @param b The size of the blocks into which the adjacency matrix is divided. Any value in `[1, n]`.
+ * 
+ * The algorithm is organized into phases:
+ * - **Dependent Phase**: Computes shortest paths within the diagonal block `W[k][k]` in place.
+ * - **Partially Dependent Phase**: Updates the row and column panels around `W[k][k]` in one parallel loop.
+ * - **Independent Phase**: Updates all other blocks using the panels computed in the previous phase.
+ * 
+ * If `n` is not divisible by `b`, the last block row and column are ragged (`n % b` wide) and are handled by
+ * the rectangular `minplus_tile`, so no padded copy of the matrix is made. All-`INF` tiles are skipped as in
+ * `blocked_floyd_warshall`.
+ * 
+ * @note The result is identical to `serial_floyd_warshall`. Edge weights are assumed to be non-negative,
+ *       which is what makes the in-place update of aliased blocks safe.
+ */
+template <typename T, typename S = min_plus>
+void inplace_blocked_floyd_warshall(
+    T * W,
+    int n,
+    int b
+);
+
+/**
+ * @brief Performs the blocked Floyd-Warshall algorithm as a DAG of OpenMP tasks instead of per-phase barriers.
+ * 
+ * This function computes the same result as `inplace_blocked_floyd_warshall`, but instead of three
+ * `#pragma omp parallel for` loops (and their barriers) per k-round, a single thread creates one task per
+ * tile update and the OpenMP runtime schedules them from their `depend` clauses.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @tparam S The semiring policy, `min_plus` by default (see `blocked_floyd_warshall`).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @param n The dimension (number of vertices) of the adjacency matrix. The matrix is assumed to be `n x n`.
+ * @param b The size of the blocks into which the adjacency matrix is divided. Any value in `[1, n]`.
+ * 
+ * @details
+ * The tile dependencies expressed for round `k` are:
+ * - **Dependent Phase**: `W[k][k]` depends on its own update from round `k - 1`.
+ * - **Partially Dependent Phase**: `W[k][j]` and `W[i][k]` depend on `W[k][k]` of round `k`.
+ * - **Independent Phase**: `W[i][j]` depends on `W[i][k]` and `W[k][j]` of round `k`.
+ * 
+ * Write-after-read hazards are covered by the same clauses, so a tile of round `k + 1` starts as soon as its
+ * inputs are final rather than when the whole of round `k` has finished, and the serial dependent phase
+ * overlaps with the tail of the previous round.
+ * 
+ * @note Each tile update is one task, so `(n / b)^3` tasks are created in total. Use block lengths of at
+ *       least 64 so that task overhead stays small relative to the `b^3` work of each task.
+ */
+template <typename T, typename S = min_plus>
+void task_blocked_floyd_warshall(
+    T * W,
+    int n,
+    int b
+);
+
+/**
+ * @brief Performs the recursive (R-Kleene) divide-and-conquer version of the Floyd-Warshall algorithm.
+ * Inspired by: J.-S. Park, M. Penner, V. K. Prasanna, "Optimizing graph algorithms for improved cache performance", IEEE TPDS 2004.
+ * 
+ * The matrix is split into quadrants, and the quadrants again, until every dimension of a sub-problem is at
+ * most `b`. Each level visits the quadrants in the order of the Floyd-Warshall `k` loop: for the first half
+ * of `k`, quadrants `11, 12, 21, 22`, and for the second half `22, 21, 12, 11`. The sub-problems shrink through
+ * every cache level on the way down, so locality is good in L1, L2, L3 and DRAM at once without tuning `b`.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @param n The dimension (number of vertices) of the adjacency matrix. Any value; splits are rounded to multiples
+ *          of `b`, so only the last leaf of each dimension is ragged.
+ * @param b The leaf size: sub-problems with every dimension at most `b` run the SIMD kernel `minplus_tile`
+ *          in place on the matrix. Any value in `[1, n]`.
+ * 
+ * @details
+ * - Parallelism comes from OpenMP tasks at the upper levels: quadrants `12` and `21` of each half never touch
+ *   each other's data and run as two tasks, and sub-problems whose output aliases neither input (pure min-plus
+ *   products, the bulk of the work) run all four quadrants of a half as tasks.
+ * - Levels whose largest dimension is below `4 * b` run serially inside their task, to keep task overhead small.
+ */
+template <typename T>
+void recursive_floyd_warshall(
+    T * W,
+    int n,
+    int b
+);
+
+/**
+ * @brief Interleaves up to `interleave_lanes<T>()` flattened `n x n` matrices into one structure-of-arrays matrix.
+ *
+ * @param matrices The matrices; lane `g` of the result holds `matrices[g]`.
+ * @param count The number of matrices, at most `interleave_lanes<T>()`. Unused lanes are filled with `0`.
+ * @param n The dimension of every matrix.
+ * @param W The interleaved matrix of `n * n * interleave_lanes<T>()` elements: cell `(i, j)` of lane `g` is
+ *          at `(i * n + j) * interleave_lanes<T>() + g`.
+ */
+template <typename T>
+void interleave_matrices(
+    const T * const * matrices,
+    int count,
+    int n,
+    T * W
+);
+
+/**
+ * @brief Copies lanes `0` to `count - 1` of an interleaved matrix back to `count` flattened matrices; the
+ *        inverse of `interleave_matrices`.
+ */
+template <typename T>
+void deinterleave_matrices(
+    const T * W,
+    int count,
+    int n,
+    T * const * matrices
+);
+
+/**
+ * @brief Performs the blocked Floyd-Warshall algorithm on `interleave_lanes<T>()` graphs at once, one graph per
+ *        SIMD lane, on the calling thread.
+ *
+ * For small graphs, parallelism within one matrix is mostly fork/join overhead. Here every min-plus update of
+ * a cell is done for all lanes by one vector operation on one cache line, so a single thread runs the SIMD
+ * width of independent graphs without any shuffles or per-graph branches.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param W An interleaved matrix from `interleave_matrices`. Updated in-place.
+ * @param n The dimension (number of vertices) of every graph.
+ * @param b The tile size in cells; three tiles take `3 * b * b * 64` bytes, so 16 to 32 keeps them in L2.
+ *          Any value in `[1, n]`; the last tile may be ragged.
+ *
+ * @details Tiles are visited in the order of `inplace_blocked_floyd_warshall`, serially, and updated with
+ *          `minplus_interleaved_tile`, so the result is that of `serial_floyd_warshall` on every lane.
+ */
+template <typename T>
+void interleaved_floyd_warshall(
+    T * W,
     int n,
     int b
 );
@@ -40,9 +205,10 @@ void blocked_floyd_warshall(
  * nested loops iterate over all vertices to update the graph matrix in-place. The function 
  * is parallelized using OpenMP to improve performance.
  * 
- * @param graph A reference to a vector representing the adjacency matrix of the graph 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix of the graph 
  *              in flattened form. The graph is updated in-place with the shortest path
- *              distances. Infinity (`INF`) is used to indicate the absence of an edge.
+ *              distances. `distance_traits<T>::inf()` is used to indicate the absence of an edge.
  * @param vertices The number of vertices in the graph. The adjacency matrix is assumed
  *                 to be of size `vertices x vertices`.
  * 
@@ -61,8 +227,158 @@ void blocked_floyd_warshall(
  * - `graph[i * vertices + j]` is the weight of the edge from vertex `i` to vertex `j`.
  * - `INF` represents no direct edge between the vertices.
  */
+template <typename T>
 void naive_floyd_warshall(
-    std::vector<int> & graph,
+    T * graph,
+    int vertices
+);
+
+/**
+ * @brief `naive_floyd_warshall` in one persistent parallel region for all `k` rounds.
+ * 
+ * The team is started once per solve instead of once per round, and rounds are separated by a spin-then-yield
+ * sense-reversing barrier rather than the end of a worksharing region. At the start of round `k` every thread
+ * copies row `k` into a private buffer and reads `graph[k][*]` only from there, so the row that all threads
+ * share stays in each thread's own cache (and on its own NUMA node) for the whole round.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix of the graph in flattened form. Updated in-place.
+ * @param vertices The number of vertices in the graph.
+ * 
+ * @details Row `k` and column `k` do not change in round `k` when `graph[k][k] >= 0`, which holds for every
+ *          generated or loaded graph (the diagonal is `0`), so row `k` is skipped and one barrier per round
+ *          suffices. Rows are distributed with `schedule(static)`, as in `naive_floyd_warshall`.
+ */
+template <typename T>
+void persistent_naive_floyd_warshall(
+    T * graph,
+    int vertices
+);
+
+/**
+ * @brief The in-place blocked Floyd-Warshall algorithm in one persistent parallel region for all block rounds.
+ * 
+ * Same tile schedule as `inplace_blocked_floyd_warshall`, but the team is started once per solve instead of
+ * twice per round: thread `0` updates `W[k][k]`, both panels share one `omp for`, and the phases are separated
+ * by a spin-then-yield sense-reversing barrier. Before the independent phase every thread copies the row panel
+ * `W[k][*]` into a private `b x n` buffer, so the tiles that every thread reads come from its own memory.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @param n The dimension (number of vertices) of the adjacency matrix.
+ * @param b The size of the blocks. Any value in `[1, n]`; the last block row and column may be ragged.
+ * 
+ * @note The private row panels take `b * n` elements per thread for the duration of the call.
+ */
+template <typename T>
+void persistent_blocked_floyd_warshall(
+    T * W,
+    int n,
+    int b
+);
+
+/**
+ * @brief Path-tracking variants of `serial_floyd_warshall`, `naive_floyd_warshall` and `blocked_floyd_warshall`.
+ * 
+ * Each computes the same distances as its distance-only counterpart and, in the same sweep, a next-hop matrix:
+ * `next[i][j]` is the vertex after `i` on a shortest path from `i` to `j`, to be walked with `reconstruct_path`.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @tparam I The next-hop index type, normally the narrowest one that fits `n` (see `next_hop_bytes` in paths.h).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @param next A pointer to an `n x n` next-hop matrix in the same layout as `W`. It is initialized from `W`
+ *             by `init_next_hop` and overwritten.
+ * @param n The dimension (number of vertices) of the adjacency matrix.
+ * @param b The block length of the blocked variant. Any value in `[1, n]`.
+ * 
+ * @details
+ * - A next hop is replaced only when a distance strictly improves, taking the next hop towards the
+ *   intermediate vertex `k`.
+ * - The blocked variant runs the zero-copy schedule of `inplace_blocked_floyd_warshall` (ragged edge tiles,
+ *   no padding), with every tile update in `minplus_tile_next`, so next hops are written by the same SIMD
+ *   pass as the distances and never by a second sweep.
+ */
+template <typename T, typename I>
+void blocked_floyd_warshall(
+    T * W,
+    I * next,
+    int n,
+    int b
+);
+
+template <typename T, typename I>
+void naive_floyd_warshall(
+    T * W,
+    I * next,
+    int n
+);
+
+template <typename T, typename I>
+void serial_floyd_warshall(
+    T * W,
+    I * next,
+    int n
+);
+
+/**
+ * @brief Compressed sparse row (CSR) form of a directed graph, built from an adjacency matrix by `build_csr`.
+ * 
+ * @tparam T The distance type of the edge weights.
+ * 
+ * @details
+ * - The out-edges of vertex `u` are `targets[offsets[u]] .. targets[offsets[u + 1] - 1]`, with the matching
+ *   entries of `weights`. `offsets` has `vertices + 1` entries.
+ * - `unit_weights` is set when every edge weighs `1`, which lets `sparse_shortest_paths` use BFS.
+ */
+template <typename T>
+struct csr_graph {
+    int vertices = 0;
+    std::vector<long long> offsets;
+    std::vector<int> targets;
+    std::vector<T> weights;
+    bool unit_weights = true;
+};
+
+/**
+ * @brief Converts a flattened adjacency matrix into CSR form.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix in flattened form. Not modified.
+ * @param vertices The number of vertices in the graph.
+ * @return csr_graph<T> One edge per off-diagonal entry that is not `distance_traits<T>::inf()`.
+ * 
+ * @details Rows are counted and filled in parallel; only the prefix sum of the row counts is serial.
+ */
+template <typename T>
+csr_graph<T> build_csr(
+    const T * graph,
+    int vertices
+);
+
+/**
+ * @brief Computes all-pairs shortest paths of a sparse graph with one BFS or Dijkstra search per source.
+ * 
+ * The matrix is converted to CSR once, then every source vertex runs its own single-source search, with the
+ * sources spread across OpenMP threads. Each search writes its distances straight into its row of `graph`,
+ * so the output is the same flattened matrix the Floyd-Warshall kernels produce.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix in flattened form. The matrix is updated in-place.
+ * @param vertices The number of vertices in the graph.
+ * 
+ * @details
+ * - Unit-weight graphs use BFS, O(n + E) per source. Otherwise Dijkstra with a binary heap and lazy deletion,
+ *   O((n + E) log n) per source. Over all sources that is O(n (n + E) log n) against O(n^3) for Floyd-Warshall,
+ *   which wins by orders of magnitude when `E` is close to `n`.
+ * - Path lengths are summed with `distance_traits<T>::add`, so narrow types saturate exactly as in the
+ *   Floyd-Warshall kernels and the results are identical.
+ * - Sources are scheduled dynamically, since searches from vertices with large reachable sets take longer.
+ * 
+ * @note Edge weights must be non-negative, as for the other kernels. The CSR copy costs `O(E)` extra memory.
+ */
+template <typename T>
+void sparse_shortest_paths(
+    T * graph,
     int vertices
 );
 
@@ -74,9 +390,10 @@ void naive_floyd_warshall(
  * adjacency matrix to reflect the shortest path distances, considering each vertex as an 
  * intermediate point.
  * 
- * @param graph A reference to a vector representing the adjacency matrix of the graph 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param graph A pointer to the adjacency matrix of the graph 
  *              in flattened form. The graph is updated in-place with the shortest path 
- *              distances. Infinity (`INF`) is used to indicate the absence of an edge.
+ *              distances. `distance_traits<T>::inf()` is used to indicate the absence of an edge.
  * @param vertices The number of vertices in the graph. The adjacency matrix is assumed 
  *                 to be of size `vertices x vertices`.
  * 
@@ -103,9 +420,13 @@ void naive_floyd_warshall(
  * This function is suitable for small to medium-sized graphs or when parallelization 
  * is unnecessary or unavailable. For larger graphs, consider using a parallelized 
  * implementation (e.g., `naive_floyd_warshall`).
+ * 
+ * With a semiring policy `S` other than the default `min_plus`, the update is `graph[i][j] ⊕= graph[i][k] ⊗
+ * graph[k][j]`, skipped where `graph[i][k] == S::zero()`; it is the reference for the semiring-generic kernels.
  */
+template <typename T, typename S = min_plus>
 void serial_floyd_warshall(
-    std::vector<int> & graph,
+    T * graph,
     int vertices
 );
 
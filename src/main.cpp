@@ -2,7 +2,20 @@
 #include "plf_nanotimer.h"
 #include "timestamps.h"
 #include "kernels.h"
+#include "autotune.h"
+#include "tile.h"
 #include "globals.h"
+#include "matrix_io.h"
+#include "paths.h"
+#include "numa.h"
+#include "allocator.h"
+#include "offload.h"
+#include "instrument.h"
+#include "solver.h"
+#include "outofcore.h"
+#include "closure.h"
+#include "semiring.h"
+#include "query.h"
 #include <omp.h>
 #include <CLI/CLI.hpp>
 #include <fmt/format.h>
@@ -10,7 +23,858 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
 
-static void reset_graph(std::vector<int> & graph, std::vector<int> & graph_back, int vertices);
+template <typename T>
+static void reset_graph(T * graph, const T * graph_back, int vertices, int block_length);
+
+/**
+ * @brief Semiring selected with `--semiring` (see semiring.h).
+ */
+enum class semiring_kind {
+    min_plus,
+    max_min,
+    max_plus,
+    or_and
+};
+
+/**
+ * @brief Mode of execution selected on the command line. Of the kernel modes, the first set in declaration order
+ *        is run; `out_of_core`, `batch` and `closure` are whole runs of their own, which `main` accepts only alone.
+ */
+struct run_mode {
+    bool sequential;
+    bool naive_parallel;
+    bool block_parallel;
+    bool zero_copy_parallel;
+    bool task_parallel;
+    bool recursive;
+    bool offload;
+    bool out_of_core;
+    bool batch;             // `--batch`: many graphs, whole graphs per thread
+    bool closure;           // `--closure`: reachability only, on a bit-packed matrix
+    bool sparse;
+    bool automatic;         // Resolved by `run` to `sparse` or `zero_copy_parallel` from the graph density
+    bool serve;             // `--serve` with `--input` only: answer queries from the already solved input file
+};
+
+/**
+ * @brief Settings shared by every distance type, resolved and validated by `main` before running.
+ */
+struct run_config {
+    int vertices;
+    int edges;
+    int block_length;
+    int iterations;
+    run_mode mode;
+    bool print;
+    std::string input;      // Matrix file to solve instead of a generated graph, or empty
+    std::string output;     // Matrix file the solution is written to, or empty
+    graph_options generator;
+    double sparse_threshold;    // Density below which `--auto` picks the sparse kernel
+    bool paths;                 // Maintain a next-hop matrix (`-s`, `-n` and `-b` only)
+    std::vector<int> route;     // Source and destination to reconstruct with `--path`, or empty
+    int numa_nodes;             // Number of NUMA nodes, for the placement report
+    size_t memory_budget;       // Bytes of resident strips for `--out-of-core`
+    int warmup;                 // Untimed iterations before the `iterations` timed ones
+    bool instrument;            // Record the phases of `-b` and `-z` over the timed iterations (`FW_INSTRUMENT` build)
+    bool hardware_counters;     // Also read hardware counters for every recorded phase
+    int batch;                  // Number of graphs solved together by `--batch`
+    bool interleave;            // `--batch`: one graph per SIMD lane
+    bool persistent;            // `-n` and `-b` in one parallel region for all rounds
+    semiring_kind semiring;     // Semiring of `-s`, `-b`, `-z` and `-d`
+    std::string serve;          // Socket to answer queries on after solving, or empty
+    int threads;                // Query workers of `--serve`
+    bool reset_from_source;     // `--reset source`: restore from the input file or the seed, without a backup copy
+};
+
+/**
+ * @brief What `run` reports back for the execution details: where the matrix memory came from and where it lives.
+ */
+struct run_report {
+    std::string matrix_memory;          // Backing of the matrix: a `memory_backing_name`, or "file mapping"
+    std::vector<long> matrix_pages;     // Matrix pages per NUMA node after the last iteration
+};
+
+/**
+ * @brief Next-hop matrix for `--paths`, held in the narrowest index type that fits the vertex count.
+ *        Only the member selected by `next_hop_bytes` is allocated.
+ */
+struct next_hop_storage {
+    aligned_vector<uint8_t> narrow;
+    aligned_vector<uint16_t> medium;
+    aligned_vector<uint32_t> wide;
+};
+
+/**
+ * @brief Calls `f` with a pointer to the allocated member of `next`, so one generic lambda serves every index type.
+ */
+template <typename F>
+static void with_next_hop(next_hop_storage & next, F f)
+{
+    if (!next.narrow.empty()) {
+        f(next.narrow.data());
+    }
+    else if (!next.medium.empty()) {
+        f(next.medium.data());
+    }
+    else {
+        f(next.wide.data());
+    }
+}
+
+/**
+ * @brief Calls `f` with the policy object of `semiring`, so one generic lambda instantiates a kernel for each
+ *        semiring. `max_plus` exists for the signed types only, so it is never passed for `uint16_t` and `uint8_t`.
+ */
+template <typename T, typename F>
+static void with_semiring(semiring_kind semiring, F f)
+{
+    switch (semiring) {
+        case semiring_kind::max_min:
+            f(max_min{});
+            break;
+        case semiring_kind::max_plus:
+            if constexpr (std::is_signed_v<T>) {
+                f(max_plus{});
+            }
+            break;
+        case semiring_kind::or_and:
+            f(or_and{});
+            break;
+        default:
+            f(min_plus{});
+            break;
+    }
+}
+
+/**
+ * @brief Runs `--out-of-core`: solves the graph in the `--output` file, streaming strips of rows through memory.
+ * 
+ * @tparam T The distance type selected with `--dtype`, or stored in the `--input` file (see `distance_traits`).
+ * @param config The validated settings; `config.output` is set.
+ * @param timestamps Receives one labeled time per timed iteration.
+ * @param phases Receives the time spent writing the graph file in every timed iteration.
+ * @param report Receives the strip size in place of the memory backing.
+ * @return int Returns `0` on success, or `1` if the graph cannot be generated, copied or solved.
+ * 
+ * @details Every iteration first rewrites the output file, copied from `--input` or generated from the seed
+ *          strip by strip, so the matrix is never held in memory; only the solve is timed.
+ */
+template <typename T>
+static int run_out_of_core(
+    const run_config & config,
+    std::vector<std::tuple<std::string, double>> & timestamps,
+    std::vector<std::tuple<std::string, double>> & phases,
+    run_report & report
+)
+{
+    double time_result;
+    int strip_rows = strip_rows_for_budget(config.vertices, sizeof(T), config.block_length, config.memory_budget);
+    spdlog::info("Streaming strips of {} rows through {}", strip_rows, config.output);
+    for (int i = -config.warmup; i < config.iterations; i++) {
+        spdlog::info("Writing graph data to {}.", config.output);
+        plf::nanotimer write_time;
+        write_time.start();
+        int status = config.input.empty()
+            ? stream_generate_matrix<T>(config.output, config.vertices, config.edges, config.generator, config.block_length, strip_rows)
+            : stream_copy_matrix<T>(config.input, config.output, config.block_length, strip_rows);
+        if (status == -1)
+        {
+            spdlog::error("Failed to write graph data... Exiting program.");
+            return 1;
+        }
+        double write_result = write_time.get_elapsed_ns();
+        spdlog::info("Beginning nanotimer...");
+        plf::nanotimer out_of_core_time;
+        out_of_core_time.start();
+        spdlog::info("Beginning Floyd-Warshall blocked out of core");
+        status = out_of_core_floyd_warshall<T>(config.output, config.block_length, strip_rows);
+        time_result = out_of_core_time.get_elapsed_ns();
+        if (status == -1)
+        {
+            return 1;
+        }
+        spdlog::info("Out-of-core execution done.");
+        spdlog::info("Getting elapsed time...");
+        if (i >= 0) {
+            mark_time(phases, write_result, "Write time, iteration: " + std::to_string(i));
+            std::string label = "Out-of-core block time, iteration: " + std::to_string(i);
+            mark_time(timestamps, time_result, label);
+        }
+    }
+    report.matrix_memory = fmt::format("out of core, strips of {} rows", strip_rows);
+    return 0;
+}
+
+/**
+ * @brief Runs `--batch`: generates `config.batch` graphs and solves them all at once with `floyd_warshall_solver`.
+ * 
+ * @tparam T The distance type selected with `--dtype` (see `distance_traits`).
+ * @param config The validated settings.
+ * @param timestamps Receives one labeled time per timed iteration, for the whole batch.
+ * @param phases Receives the generation time, and the reset before every timed iteration.
+ * @param report Receives the batch memory in place of the memory backing.
+ * @return int Returns `0` on success, or `1` if a graph cannot be generated.
+ * 
+ * @details Graph `m` is generated from seed `--seed + m`. Each thread solves whole graphs with the single-threaded
+ *          zero-copy kernel, or with `--interleave` whole groups of `interleave_lanes<T>()` graphs, one per SIMD lane.
+ */
+template <typename T>
+static int run_batch(
+    const run_config & config,
+    std::vector<std::tuple<std::string, double>> & timestamps,
+    std::vector<std::tuple<std::string, double>> & phases,
+    run_report & report
+)
+{
+    double time_result;
+    const size_t cells = static_cast<size_t>(config.vertices) * config.vertices;
+    aligned_buffer<T> graphs(cells * config.batch);
+    aligned_buffer<T> graphs_back(cells * config.batch);
+    std::vector<batch_matrix<T>> batch;
+
+    spdlog::info("Generating {} graphs.", config.batch);
+    plf::nanotimer generate_time;
+    generate_time.start();
+    for (int m = 0; m < config.batch; m++) {
+        graph_options options = config.generator;
+        options.seed += m;
+        if (generate_linear_graph(graphs_back.data() + m * cells, config.vertices, config.edges, options) == -1)
+        {
+            spdlog::error("Failed to generate graph data... Exiting program.");
+            return 1;
+        }
+    }
+    double generate_result = generate_time.get_elapsed_ns();
+    mark_time(phases, generate_result, "Generate time");
+    for (int m = 0; m < config.batch; m++) {
+        batch.push_back({graphs.data() + m * cells, config.vertices});
+    }
+
+    solver_options options;
+    options.block_length = config.block_length;
+    options.interleave = config.interleave;
+    floyd_warshall_solver<T> solver(options);
+    for (int i = -config.warmup; i < config.iterations; i++) {
+        spdlog::info("Resetting graphs.");
+        plf::nanotimer reset_time;
+        reset_time.start();
+        std::copy(graphs_back.data(), graphs_back.data() + graphs_back.size(), graphs.data());
+        double reset_result = reset_time.get_elapsed_ns();
+        spdlog::info("Beginning nanotimer...");
+        plf::nanotimer batch_time;
+        batch_time.start();
+        spdlog::info("Beginning Floyd-Warshall on a batch of {} graphs", config.batch);
+        solver.solve_batch(batch);
+        time_result = batch_time.get_elapsed_ns();
+        spdlog::info("Batch execution done.");
+        spdlog::info("Getting elapsed time...");
+        if (i >= 0) {
+            mark_time(phases, reset_result, "Reset time, iteration: " + std::to_string(i));
+            std::string label = "Batch time, iteration: " + std::to_string(i);
+            mark_time(timestamps, time_result, label);
+        }
+    }
+    report.matrix_memory = fmt::format("{} graphs{}", config.batch, config.interleave ? ", interleaved" : "");
+    return 0;
+}
+
+/**
+ * @brief Answers queries on `config.serve` from a solved matrix until a client sends `shutdown` or the process
+ *        is interrupted (see `serve_queries` for the protocol).
+ *
+ * @tparam T The distance type of the matrix.
+ * @param config The validated settings; `config.serve` is set.
+ * @param graph The solved matrix; stays resident and is only read.
+ * @param next The next-hop matrix of the same solve, or `nullptr` without `--paths`.
+ * @return int Returns `0` after a clean shutdown, or `1` if the socket cannot be created.
+ */
+template <typename T>
+static int serve_solution(const run_config & config, const T * graph, next_hop_storage * next)
+{
+    query_engine<T> engine(graph, config.vertices);
+    if (next != nullptr) {
+        with_next_hop(*next, [&](auto * hops) { engine.set_next_hops(hops); });
+    }
+    spdlog::info("Serving queries on {} with {} workers.", config.serve, config.threads);
+    fmt::print("Serving queries on {}\n", config.serve);
+    std::fflush(stdout);
+    return serve_queries(engine, config.serve, config.threads) == -1 ? 1 : 0;
+}
+
+/**
+ * @brief Runs `--serve` on an `--input` file that already holds a solution, without solving it again.
+ *
+ * @tparam T The distance type stored in the `--input` file.
+ * @param config The validated settings; `config.input` and `config.serve` are set.
+ * @param report Receives the memory backing of the matrix.
+ * @return int Returns `0` after a clean shutdown, or `1` if the file cannot be mapped or the socket created.
+ *
+ * @details The file is mapped copy-on-write but never written, so its pages stay shared with the page cache and
+ *          with every other process serving the same file.
+ */
+template <typename T>
+static int run_serve(const run_config & config, run_report & report)
+{
+    spdlog::info("Mapping solved matrix from {}.", config.input);
+    mapped_matrix input_matrix{};
+    if (map_matrix(config.input, input_matrix, false) == -1)
+    {
+        return 1;
+    }
+    report.matrix_memory = "file mapping";
+    int status = serve_solution(config, static_cast<const T *>(input_matrix.data), nullptr);
+    unmap_matrix(input_matrix);
+    return status;
+}
+
+/**
+ * @brief Runs `--closure`: packs the graph into a `bit_matrix` and computes its transitive closure.
+ * 
+ * @tparam T The distance type of the `--input` file; generated graphs never exist as distances.
+ * @param config The validated settings.
+ * @param timestamps Receives one labeled time per timed iteration.
+ * @param phases Receives the generation time, and the reset before every timed iteration.
+ * @param report Receives the bit matrix layout in place of the memory backing.
+ * @return int Returns `0` on success, or `1` if the graph cannot be generated or loaded.
+ * 
+ * @details Generated graphs are produced 64 MB of rows at a time by `generate_reachability`, so the memory use
+ *          is the bit matrix and its backup: `n^2 / 4` bytes. The number of reachable pairs is printed.
+ */
+template <typename T>
+static int run_closure(
+    const run_config & config,
+    std::vector<std::tuple<std::string, double>> & timestamps,
+    std::vector<std::tuple<std::string, double>> & phases,
+    run_report & report
+)
+{
+    double time_result;
+    bit_matrix graph(config.vertices);
+    if (!config.input.empty())
+    {
+        spdlog::info("Mapping graph data from {}.", config.input);
+        mapped_matrix input_matrix{};
+        if (map_matrix(config.input, input_matrix, false) == -1)
+        {
+            return 1;
+        }
+        pack_reachability(static_cast<const T *>(input_matrix.data), 0, config.vertices, graph);
+        unmap_matrix(input_matrix);
+    }
+    else
+    {
+        spdlog::info("Generating graph data.");
+        plf::nanotimer generate_time;
+        generate_time.start();
+        int strip_rows = std::max(1, (64 << 20) / config.vertices);
+        if (generate_reachability(graph, config.edges, config.generator, strip_rows) == -1)
+        {
+            spdlog::error("Failed to generate graph... Exiting program.");
+            return 1;
+        }
+        double generate_result = generate_time.get_elapsed_ns();
+        mark_time(phases, generate_result, "Generate time");
+    }
+    bit_matrix graph_back(config.vertices);
+    copy_bit_matrix(graph, graph_back);
+
+    for (int i = -config.warmup; i < config.iterations; i++) {
+        spdlog::info("Resetting graph.");
+        plf::nanotimer reset_time;
+        reset_time.start();
+        copy_bit_matrix(graph_back, graph);
+        double reset_result = reset_time.get_elapsed_ns();
+        spdlog::info("Beginning nanotimer...");
+        plf::nanotimer closure_time;
+        closure_time.start();
+        spdlog::info("Beginning bit-packed transitive closure");
+        transitive_closure(graph);
+        time_result = closure_time.get_elapsed_ns();
+        spdlog::info("Closure execution done.");
+        spdlog::info("Getting elapsed time...");
+        if (i >= 0) {
+            mark_time(phases, reset_result, "Reset time, iteration: " + std::to_string(i));
+            std::string label = "Closure time, iteration: " + std::to_string(i);
+            mark_time(timestamps, time_result, label);
+        }
+    }
+    fmt::print("Reachable pairs: {}\n", count_reachable_pairs(graph));
+    report.matrix_memory = fmt::format("bit-packed, {} words per row", graph.words);
+    return 0;
+}
+
+/**
+ * @brief Restores the input of `run` for `--reset source` without a backup copy.
+ * 
+ * @tparam T The distance type.
+ * @param config The validated settings.
+ * @param graph The matrix the kernels run on.
+ * @param input_matrix The `--input` mapping, or an empty one for a generated graph.
+ * 
+ * @details
+ * - `--input` with `--output`: the input file, still mapped, is copied into the output mapping again with the
+ *   tile-row parallel `copy_matrix`.
+ * - `--input` only: `graph` is the copy-on-write input mapping; `revert_matrix` drops the written pages.
+ * - Generated: `generate_linear_graph` rebuilds the same graph from `--seed`, in parallel over rows.
+ * 
+ * The semiring conversion of the edge weights is applied again afterwards.
+ */
+template <typename T>
+static void restore_graph(const run_config & config, T * graph, mapped_matrix & input_matrix)
+{
+    if (input_matrix.data != nullptr && input_matrix.data != graph) {
+        copy_matrix(graph, static_cast<const T *>(input_matrix.data), config.vertices, config.block_length);
+    }
+    else if (input_matrix.data != nullptr) {
+        revert_matrix(input_matrix);
+    }
+    else {
+        generate_linear_graph(graph, config.vertices, config.edges, config.generator);
+    }
+    if (config.semiring != semiring_kind::min_plus) {
+        with_semiring<T>(config.semiring, [&](auto policy) { semiring_from_distances<decltype(policy)>(graph, config.vertices); });
+    }
+}
+
+/**
+ * @brief Loads or generates the graph in distance type `T`, runs the selected mode for every iteration and records the timings.
+ * 
+ * @tparam T The distance type selected with `--dtype`, or stored in the `--input` file (see `distance_traits`).
+ * @param config The validated settings.
+ * @param timestamps Receives one labeled time per timed iteration; `config.warmup` iterations run first, unrecorded.
+ * @param phases Receives the time of the other phases: graph generation, and the reset before every timed iteration.
+ * @param report Receives the memory backing and per-node page counts of the matrix.
+ * @return int Returns `0` on success, or `1` if the graph cannot be generated, loaded or stored.
+ * 
+ * @details
+ * - With `--output`, the output file is created first and mapped shared, and the kernels run directly on
+ *   that mapping, so the solution reaches the file without a copy.
+ * - With `--input` only, the input file is mapped private (copy-on-write) and the kernels run on the mapping.
+ * - With both, the input is mapped read-only and copied once into the output mapping.
+ * - Before every iteration the input is restored from a backup copy, or with `--reset source` from the file
+ *   or the seed it came from (see `restore_graph`), which halves the peak memory of generated graphs.
+ * - Generated matrices and the backup copy are first touched tile row by tile row, by the threads that own
+ *   those rows in the blocked kernels, so on multi-socket machines each page lands on the right node.
+ */
+template <typename T>
+static int run(
+    const run_config & config,
+    std::vector<std::tuple<std::string, double>> & timestamps,
+    std::vector<std::tuple<std::string, double>> & phases,
+    run_report & report
+)
+{
+    double time_result;
+    int vertices = config.vertices;
+    int edges = config.edges;
+    int block_length = config.block_length;
+    int iterations = config.iterations;
+    run_mode mode = config.mode;
+    bool print = config.print;
+    if (mode.out_of_core)
+    {
+        return run_out_of_core<T>(config, timestamps, phases, report);
+    }
+    if (mode.batch)
+    {
+        return run_batch<T>(config, timestamps, phases, report);
+    }
+    if (mode.closure)
+    {
+        return run_closure<T>(config, timestamps, phases, report);
+    }
+    if (mode.serve)
+    {
+        return run_serve<T>(config, report);
+    }
+
+    // Storage: output mapping, input mapping, or memory.
+    mapped_matrix input_matrix{};
+    mapped_matrix output_matrix{};
+    aligned_buffer<T> storage;
+    T * graph = nullptr;
+    if (!config.output.empty())
+    {
+        if (create_matrix(config.output, dtype_of<T>(), vertices, block_length, output_matrix) == -1)
+        {
+            return 1;
+        }
+        graph = static_cast<T *>(output_matrix.data);
+    }
+    if (!config.input.empty())
+    {
+        spdlog::info("Mapping graph data from {}.", config.input);
+        if (map_matrix(config.input, input_matrix, false) == -1)
+        {
+            unmap_matrix(output_matrix);
+            return 1;
+        }
+        if (graph == nullptr)
+        {
+            graph = static_cast<T *>(input_matrix.data);
+        }
+        else
+        {
+            // Kept mapped for --reset source, which copies from it again before every iteration.
+            copy_matrix(graph, static_cast<const T *>(input_matrix.data), vertices, block_length);
+            if (!config.reset_from_source) {
+                unmap_matrix(input_matrix);
+            }
+        }
+    }
+    else
+    {
+        if (graph == nullptr)
+        {
+            // Left uninitialized, so first_touch decides the placement of every page.
+            storage = aligned_buffer<T>(static_cast<size_t>(vertices) * vertices);
+            graph = storage.data();
+        }
+        first_touch(graph, vertices, block_length, distance_traits<T>::inf());
+
+        // Generate graph.
+        spdlog::info("Generating graph data.");
+        plf::nanotimer generate_time;
+        generate_time.start();
+        if (generate_linear_graph(graph, vertices, edges, config.generator) == -1)
+        {
+            spdlog::error("Failed to generate graph... Exiting program.");
+            unmap_matrix(output_matrix);
+            return 1;
+        }
+        double generate_result = generate_time.get_elapsed_ns();
+        mark_time(phases, generate_result, "Generate time");
+        spdlog::info("Done populating graph with data.");
+    }
+
+    // Edge weights become lengths or capacities of the semiring; generators and files use the min-plus convention.
+    if (config.semiring != semiring_kind::min_plus)
+    {
+        with_semiring<T>(config.semiring, [&](auto policy) { semiring_from_distances<decltype(policy)>(graph, vertices); });
+    }
+
+    // Copy graph to graph_back, unless the input is restored from its source.
+    aligned_buffer<T> graph_back;
+    if (!config.reset_from_source)
+    {
+        spdlog::info("Backing up graph data.");
+        graph_back = aligned_buffer<T>(static_cast<size_t>(vertices) * vertices);
+        copy_matrix(graph_back.data(), graph, vertices, block_length);
+    }
+
+    // Pick the kernel for --auto from the density of the graph actually loaded.
+    if (mode.automatic)
+    {
+        long long graph_edges = count_edges(graph, vertices);
+        double density = vertices > 1 ? static_cast<double>(graph_edges) / (static_cast<double>(vertices) * (vertices - 1)) : 0.0;
+        if (density < config.sparse_threshold) {
+            mode.sparse = true;
+        }
+        else {
+            mode.zero_copy_parallel = true;
+        }
+        spdlog::info(
+            "Graph has {} edges, density {:.6f}: using {} kernel",
+            graph_edges,
+            density,
+            mode.sparse ? "sparse" : "zero-copy block"
+        );
+    }
+
+    // Next-hop matrix for --paths.
+    next_hop_storage next;
+    if (config.paths)
+    {
+        size_t cells = static_cast<size_t>(vertices) * vertices;
+        int index_bytes = next_hop_bytes(vertices);
+        if (index_bytes == 1) {
+            next.narrow.resize(cells);
+        }
+        else if (index_bytes == 2) {
+            next.medium.resize(cells);
+        }
+        else {
+            next.wide.resize(cells);
+        }
+        spdlog::info("Tracking next hops with {}-byte indices.", index_bytes);
+    }
+
+    // Restore the input from the backup before every iteration, or with --reset source from where it came from:
+    // the input file copied into --output again, the copy-on-write --input mapping reverted, or the graph
+    // regenerated from --seed. The graph is still fresh before the first iteration. The restore is timed as a
+    // phase of its own.
+    bool fresh = true;
+    auto reset = [&](int i) {
+        plf::nanotimer reset_time;
+        reset_time.start();
+        if (!config.reset_from_source) {
+            reset_graph(graph, graph_back.data(), vertices, block_length);
+        }
+        else if (!fresh) {
+            restore_graph(config, graph, input_matrix);
+        }
+        fresh = false;
+        double reset_result = reset_time.get_elapsed_ns();
+        if (i >= 0) {
+            mark_time(phases, reset_result, "Reset time, iteration: " + std::to_string(i));
+        }
+        if (i == 0 && config.instrument) {
+            // Drops the phases of the warmup iterations.
+            instrument_start(config.hardware_counters);
+        }
+    };
+
+    // Print generated graph.
+    if (print)
+    {
+        fmt::print("Graph before Floyd-Warshall:\n");
+        print_graph(graph, vertices);
+    }
+
+    if (mode.sequential)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Starting nanotimer.");
+            plf::nanotimer sequential_time;
+            sequential_time.start();
+            spdlog::info("Beginning Floyd-Warshall sequential execution.");
+            if (config.paths) {
+                with_next_hop(next, [&](auto * hops) { serial_floyd_warshall(graph, hops, vertices); });
+            }
+            else {
+                with_semiring<T>(config.semiring, [&](auto policy) { serial_floyd_warshall<T, decltype(policy)>(graph, vertices); });
+            }
+            time_result = sequential_time.get_elapsed_ns();
+            spdlog::info("Sequential execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Sequential time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.naive_parallel)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer naive_parallel_time;
+            naive_parallel_time.start();
+            spdlog::info("Beginning Floyd-Warshall parallel without cache optimizations");
+            if (config.paths) {
+                with_next_hop(next, [&](auto * hops) { naive_floyd_warshall(graph, hops, vertices); });
+            }
+            else if (config.persistent) {
+                persistent_naive_floyd_warshall(graph, vertices);
+            }
+            else {
+                naive_floyd_warshall(graph, vertices);
+            }
+            time_result = naive_parallel_time.get_elapsed_ns();
+            spdlog::info("Naive execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Naive time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.block_parallel)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer block_parallel_time;
+            block_parallel_time.start();
+            spdlog::info("Beginning Floyd-Warshall parallel with cache optimizations");
+            if (config.paths) {
+                with_next_hop(next, [&](auto * hops) { blocked_floyd_warshall(graph, hops, vertices, block_length); });
+            }
+            else if (config.persistent) {
+                persistent_blocked_floyd_warshall(graph, vertices, block_length);
+            }
+            else {
+                with_semiring<T>(config.semiring, [&](auto policy) { blocked_floyd_warshall<T, decltype(policy)>(graph, vertices, block_length); });
+            }
+            time_result = block_parallel_time.get_elapsed_ns();
+            spdlog::info("Optimized execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Block time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.zero_copy_parallel)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer zero_copy_parallel_time;
+            zero_copy_parallel_time.start();
+            spdlog::info("Beginning Floyd-Warshall parallel with cache optimizations, in place");
+            with_semiring<T>(config.semiring, [&](auto policy) { inplace_blocked_floyd_warshall<T, decltype(policy)>(graph, vertices, block_length); });
+            time_result = zero_copy_parallel_time.get_elapsed_ns();
+            spdlog::info("Zero-copy execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Zero-copy block time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.task_parallel)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer task_parallel_time;
+            task_parallel_time.start();
+            spdlog::info("Beginning Floyd-Warshall parallel with cache optimizations, task DAG");
+            with_semiring<T>(config.semiring, [&](auto policy) { task_blocked_floyd_warshall<T, decltype(policy)>(graph, vertices, block_length); });
+            time_result = task_parallel_time.get_elapsed_ns();
+            spdlog::info("Task execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Task block time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.recursive)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer recursive_time;
+            recursive_time.start();
+            spdlog::info("Beginning Floyd-Warshall parallel with recursive (cache-oblivious) quadrants");
+            recursive_floyd_warshall(graph, vertices, block_length);
+            time_result = recursive_time.get_elapsed_ns();
+            spdlog::info("Recursive execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Recursive time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.offload)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer offload_time;
+            offload_time.start();
+            spdlog::info("Beginning Floyd-Warshall blocked on the offload device");
+            offload_floyd_warshall(graph, vertices, block_length);
+            time_result = offload_time.get_elapsed_ns();
+            spdlog::info("Offload execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Offload block time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    else if (mode.sparse)
+    {
+        for (int i = -config.warmup; i < iterations; i++) {
+            spdlog::info("Resetting graph.");
+            reset(i);
+            spdlog::info("Beginning nanotimer...");
+            plf::nanotimer sparse_time;
+            sparse_time.start();
+            spdlog::info("Beginning parallel per-source BFS/Dijkstra on CSR");
+            sparse_shortest_paths(graph, vertices);
+            time_result = sparse_time.get_elapsed_ns();
+            spdlog::info("Sparse execution done.");
+            spdlog::info("Getting elapsed time...");
+            std::string label = "Sparse time, iteration: " + std::to_string(i);
+            if (i >= 0) {
+                mark_time(timestamps, time_result, label);
+            }
+        }
+    }
+
+    // Unreachable max-plus pairs read as -INF again (see max_plus).
+    if (config.semiring != semiring_kind::min_plus)
+    {
+        with_semiring<T>(config.semiring, [&](auto policy) { semiring_canonicalize<decltype(policy)>(graph, vertices); });
+    }
+
+    // Print the solved graph.
+    if (print)
+    {
+        fmt::print("Graph after Floyd-Warshall:\n");
+        print_graph(graph, vertices);
+    }
+    report.matrix_pages = page_nodes(graph, static_cast<size_t>(vertices) * vertices * sizeof(T), config.numa_nodes);
+    report.matrix_memory = storage.data() != nullptr ? memory_backing_name(storage.backing()) : "file mapping";
+
+    // Print the requested route.
+    if (!config.route.empty())
+    {
+        int u = config.route[0];
+        int v = config.route[1];
+        with_next_hop(next, [&](auto * hops) {
+            std::vector<int> path = reconstruct_path(hops, vertices, u, v);
+            if (path.empty()) {
+                fmt::print("Path {} -> {}: unreachable\n", u, v);
+            }
+            else {
+                fmt::print("Path {} -> {} (distance {}): {}\n", u, v, graph[static_cast<size_t>(u) * vertices + v], fmt::join(path, " "));
+            }
+        });
+    }
+
+    // Keep the solution resident and answer queries from it.
+    int status = 0;
+    if (!config.serve.empty())
+    {
+        status = serve_solution(config, static_cast<const T *>(graph), config.paths ? &next : nullptr);
+    }
+
+    // Release the mappings; the output file now holds the solution.
+    unmap_matrix(input_matrix);
+    unmap_matrix(output_matrix);
+    return status;
+}
+
+/**
+ * @brief Calibrates the block length of the `kernel_name` kernel (`block`, `zero-copy`, `task` or `recursive`)
+ *        with distance type `T`, with `calibrate_block_length`.
+ */
+template <typename T>
+static int calibrate_kernel(const std::string & kernel_name, int vertices, int edges, const cache_sizes & caches)
+{
+    blocked_kernel<T> kernel = blocked_floyd_warshall<T>;
+    if (kernel_name == "zero-copy") {
+        kernel = inplace_blocked_floyd_warshall<T>;
+    }
+    else if (kernel_name == "task") {
+        kernel = task_blocked_floyd_warshall<T>;
+    }
+    else if (kernel_name == "recursive") {
+        kernel = recursive_floyd_warshall<T>;
+    }
+    return calibrate_block_length(kernel, vertices, edges, candidate_block_lengths(vertices, caches, sizeof(T)));
+}
 
 /**
  * @brief Entry point for the Floyd-Warshall algorithm program.
@@ -30,31 +894,93 @@ static void reset_graph(std::vector<int> & graph, std::vector<int> & graph_back,
  *    - `-v, --vertices`: Number of vertices in the graph (default: 100).
  *    - `-e, --edges`: Number of directed edges in the graph (default: 200).
  *    - `-t, --threads`: Number of threads for parallel execution (default: 1).
- *    - `-l, --block-length`: Block size for cache-optimized parallel execution (default: 1).
+ *    - `-l, --block-length`: Block size for cache-optimized parallel execution, or `auto` (default: auto).
+ *    - `-i, --iterations`: Number of timed iterations (default: 1).
+ *    - `--warmup`: Untimed iterations run before the timed ones, so a cold first run does not skew the statistics (default: 0).
+ *    - `--timings`: File to write every sample and the per-phase statistics to.
+ *    - `--timings-format`: Format of `--timings`: `csv` or `json` (default: json).
+ *    - `--instrument`: Print per-phase, per-thread times, load imbalance and barrier waits of `-b` and `-z` over the
+ *      timed iterations. Requires the `FW_INSTRUMENT` build.
+ *    - `--trace`: Also write the recorded phases as Chrome trace JSON to this file. Implies `--instrument`.
+ *    - `--counters`: Also read instructions, L1D and LLC misses per phase with `perf_event_open`. Implies `--instrument`.
+ *    - `--calibrate`: With `-l auto`, time candidate block lengths on a sample matrix and cache the winner per host,
+ *      replacing any cached value; without it, `-l auto` uses the cached value if there is one.
  *    - `-s, --sequential`: Run the algorithm sequentially.
  *    - `-n, --naive-parallel`: Run the algorithm in naive parallel mode.
  *    - `-b, --block-parallel`: Run the algorithm in block-parallel (cache-optimized) mode.
+ *    - `-z, --zero-copy-block-parallel`: Run the block-parallel algorithm in place, without per-tile copies.
+ *    - `-d, --task-parallel`: Run the block-parallel algorithm as a DAG of OpenMP tasks.
+ *    - `-r, --recursive`: Run the recursive (R-Kleene) algorithm, splitting into quadrants down to `-l` sized leaves.
+ *    - `-g, --offload`: Run the block-parallel algorithm on an OpenMP target device. Requires the `FW_OFFLOAD` build.
+ *    - `--out-of-core`: Solve the `--output` file in place, streaming strips of rows through memory; for graphs larger than RAM.
+ *    - `--memory-budget`: Megabytes of resident strips for `--out-of-core` (default: 1024).
+ *    - `--batch`: Solve this many graphs of `-v` vertices (seeds `--seed` onward) together, whole graphs per thread.
+ *    - `--interleave`: With `--batch`, solve the graphs one per SIMD lane in interleaved groups, in tiles of `-l` cells
+ *      (`auto`: three tiles of 64-byte cells in half of L2).
+ *    - `--closure`: Compute reachability only (transitive closure) on a bit-packed matrix, 64 vertices per word.
+ *    - `--persistent`: With `-n` or `-b`, run all rounds in one parallel region, separated by a spin barrier,
+ *      reading row `k` (or row panel `k`) from a private copy per thread. `-b` then works in place.
+ *    - `--sparse`: Run one BFS/Dijkstra per source on a CSR copy of the graph, in parallel over sources.
+ *    - `-a, --auto`: Run `--sparse` when the graph density is below `--sparse-threshold`, `-z` otherwise.
+ *    - `--sparse-threshold`: Edge density `E / (n (n - 1))` below which `--auto` picks the sparse kernel (default: 0.001).
+ *    - `--semiring`: Path algebra of `-s`, `-b`, `-z` and `-d`: `min-plus` (shortest paths), `max-min` (widest paths,
+ *      weights are capacities), `max-plus` (longest paths of a DAG, `int32` and `float` only) or `or-and`
+ *      (reachability, `1` per reachable pair) (default: min-plus). Not with `--out-of-core`, `--batch` or `--closure`.
+ *    - `--paths`: Also maintain a next-hop matrix (with `-s`, `-n` or `-b`) in the narrowest index type that fits.
+ *    - `--path`: Two vertices `u v`; prints the shortest route from `u` to `v` after solving. Implies `--paths`.
  *    - `-p, --print`: Print the graph before and after execution.
+ *    - `--simd`: Instruction set for the blocked tile kernel: `auto`, `scalar`, `avx2` or `avx512` (default: auto).
+ *    - `--dtype`: Distance type: `int32`, `uint16`, `uint8` or `float` (default: int32).
+ *    - `--seed`: Seed of the graph generator; the same seed always yields the same graph (default: 0).
+ *    - `--topology`: Generated graph structure: `erdos-renyi`, `grid` or `power-law` (default: erdos-renyi).
+ *    - `--weights`: Edge weight distribution: `unit`, `uniform` or `exponential` (default: unit).
+ *    - `--max-weight`: Largest edge weight for `--weights uniform` and `exponential` (default: 100).
+ *    - `--bind`: Pin OpenMP threads: `none`, `close` (fill one NUMA node first) or `spread` (alternate nodes) (default: none).
+ *    - `--hugepages`: Matrix memory: `none` (4 KB pages), `thp` (transparent hugepages) or `explicit` (MAP_HUGETLB,
+ *      falling back to `thp`) (default: thp). All matrices are 64-byte aligned.
+ *    - `--input`: Binary matrix file to solve instead of a generated graph; sets the vertices and distance type.
+ *    - `--output`: Binary matrix file to write the solution to; the kernels run directly on its mapping.
+ *    - `--reset`: How the input is restored before every iteration: `copy` (from a backup copy in memory) or `source`
+ *      (no backup: revert the copy-on-write `--input` mapping, copy `--input` into `--output` again, or regenerate
+ *      the graph from `--seed`) (default: copy).
+ *    - `--serve`: Unix socket to answer `dist`, `dists`, `row` and `path` queries on after solving, with `-t` workers,
+ *      until a client sends `shutdown`. With `--input` and no mode, serves the input file as an already solved matrix.
  * 
  * 2. **Input Validation**:
- *    - Ensures the block size does not exceed or misalign with the number of vertices.
+ *    - Resolves `-l auto` from the per-host tuning cache, a calibration sweep, or the L1/L2 sizes.
+ *    - Ensures the block size does not exceed the number of vertices. Other sizes are handled by padding.
  *    - Caps the thread count to the maximum available OpenMP threads.
  *    - Verifies that at least one mode of execution is selected.
+ *    - Verifies that the requested SIMD instruction set is supported by the CPU.
  * 
  * 3. **Graph Generation**:
- *    - Generates a random directed graph with the specified vertices and edges.
+ *    - Generates a random directed graph with the specified vertices and edges, stored in the `--dtype` distance type.
+ *    - Rows are generated in parallel from per-row streams of `--seed`, so the graph does not depend on `-t`.
  *    - Uses `INF` to represent disconnected vertices and `0` for self-loops (diagonal entries).
  * 
  * 4. **Algorithm Execution**:
  *    - Depending on the selected mode, executes one of the following:
  *      - **Sequential Mode**: Runs `serial_floyd_warshall`.
- *      - **Naive Parallel Mode**: Runs `naive_floyd_warshall` without cache optimizations.
- *      - **Block Parallel Mode**: Runs `blocked_floyd_warshall` with cache optimizations.
+ *      - **Naive Parallel Mode**: Runs `naive_floyd_warshall` without cache optimizations, or
+ *        `persistent_naive_floyd_warshall` with `--persistent`.
+ *      - **Block Parallel Mode**: Runs `blocked_floyd_warshall` with cache optimizations, or
+ *        `persistent_blocked_floyd_warshall` with `--persistent`.
+ *      - **Zero-Copy Block Parallel Mode**: Runs `inplace_blocked_floyd_warshall` on strided views of the matrix.
+ *      - **Task Parallel Mode**: Runs `task_blocked_floyd_warshall`, scheduling tile updates from their dependencies.
+ *      - **Recursive Mode**: Runs `recursive_floyd_warshall`, a cache-oblivious divide-and-conquer over quadrants.
+ *      - **Offload Mode**: Runs `offload_floyd_warshall`, keeping the matrix on the device for all rounds.
+ *      - **Out-of-Core Mode**: Runs `out_of_core_floyd_warshall` on the output file, with background strip I/O.
+ *      - **Batch Mode**: Runs `floyd_warshall_solver::solve_batch` over many generated graphs.
+ *      - **Closure Mode**: Runs `transitive_closure` on the graph packed into a `bit_matrix`.
+ *      - **Sparse Mode**: Runs `sparse_shortest_paths`, one single-source search per vertex.
+ *      - **Serve Mode**: Runs `serve_queries` on the `--input` file, which already holds a solution.
  *    - Measures execution time for each mode using `plf::nanotimer` and records it with a label.
  * 
  * 5. **Output**:
  *    - Optionally prints the graph before and after execution.
  *    - Outputs graph details, including memory footprint and execution timestamps.
+ *    - Prints min, median, p95, max, mean, standard deviation and a 95% confidence interval per phase: the
+ *      kernel, graph generation and the reset before each iteration.
  * 
  * @note 
  * - The program uses `spdlog` for logging and `fmt` for formatted printing.
@@ -76,61 +1002,140 @@ int main(const int argc, const char *const argv[])
     bool run_sequential{false};
     bool run_naive_parallel{false};
     bool run_block_parallel{false};
+    bool run_zero_copy_parallel{false};
+    bool run_task_parallel{false};
+    bool run_recursive{false};
+    bool run_offload{false};
+    bool run_out_of_core{false};
+    size_t memory_budget{1024};
+    int batch{0};
+    bool interleave{false};
+    bool persistent{false};
+    bool run_closure{false};
+    bool run_sparse{false};
+    bool run_automatic{false};
+    double sparse_threshold{0.001};
+    bool paths{false};
+    std::vector<int> route;
+    std::string semiring{"min-plus"};
+    std::string bind{"none"};
+    std::string hugepages{"thp"};
     bool print{false};
 
     int vertices{100};
     int edges{200};
     int threads{1};
     int block_length{1};
+    std::string block_length_arg{"auto"};
+    bool calibrate{false};
     int iterations{1};
+    std::string simd{"auto"};
+    std::string dtype{"int32"};
+    std::string input;
+    std::string output;
+    std::string serve;
+    std::string reset{"copy"};
+    uint64_t seed{0};
+    std::string topology{"erdos-renyi"};
+    std::string weights{"unit"};
+    int max_weight{100};
+
+    int warmup{0};
+    std::string timings;
+    std::string timings_format{"json"};
+    bool instrument{false};
+    std::string trace;
+    bool hardware_counters{false};
 
-    double time_result;
     std::vector<std::tuple<std::string, double>> timestamps;
+    std::vector<std::tuple<std::string, double>> phases;
 
     // CLI setup and parse.
     CLI::App app{"Floyd-Warshall"};
     app.option_defaults()->always_capture_default(true);
     app.add_option("-i, --iterations", iterations)
         ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--warmup", warmup)
+        ->check(CLI::NonNegativeNumber.description(" >= 0"));
+    app.add_option("--timings", timings);
+    app.add_option("--timings-format", timings_format)
+        ->check(CLI::IsMember({"csv", "json"}));
+    app.add_flag("--instrument", instrument);
+    app.add_option("--trace", trace);
+    app.add_flag("--counters", hardware_counters);
     app.add_option("-v, --vertices", vertices)
         ->check(CLI::PositiveNumber.description(" >= 1"));
     app.add_option("-e, --edges", edges)
         ->check(CLI::PositiveNumber.description(" >= 1"));
     app.add_option("-t, --threads", threads)
         ->check(CLI::PositiveNumber.description(" >= 1"));
-    app.add_option("-l, --block-length", block_length)
-        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-l, --block-length", block_length_arg)
+        ->check(CLI::PositiveNumber.description(" >= 1") | CLI::IsMember({"auto"}));
+    app.add_flag("--calibrate", calibrate);
     app.add_flag("-s, --sequential", run_sequential);
     app.add_flag("-n, --naive-parallel", run_naive_parallel);
     app.add_flag("-b, --block-parallel", run_block_parallel);
+    app.add_flag("-z, --zero-copy-block-parallel", run_zero_copy_parallel);
+    app.add_flag("-d, --task-parallel", run_task_parallel);
+    app.add_flag("-r, --recursive", run_recursive);
+    app.add_flag("-g, --offload", run_offload);
+    app.add_flag("--out-of-core", run_out_of_core);
+    app.add_option("--memory-budget", memory_budget)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--batch", batch)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_flag("--interleave", interleave);
+    app.add_flag("--persistent", persistent);
+    app.add_flag("--closure", run_closure);
+    app.add_flag("--sparse", run_sparse);
+    app.add_flag("-a, --auto", run_automatic);
+    app.add_option("--sparse-threshold", sparse_threshold)
+        ->check(CLI::Range(0.0, 1.0));
+    app.add_option("--semiring", semiring)
+        ->check(CLI::IsMember({"min-plus", "max-min", "max-plus", "or-and"}));
+    app.add_flag("--paths", paths);
+    app.add_option("--path", route)
+        ->expected(2)
+        ->check(CLI::NonNegativeNumber);
     app.add_flag("-p, --print", print);
+    app.add_option("--simd", simd)
+        ->check(CLI::IsMember({"auto", "scalar", "avx2", "avx512"}));
+    app.add_option("--dtype", dtype)
+        ->check(CLI::IsMember({"int32", "uint16", "uint8", "float"}));
+    app.add_option("--seed", seed);
+    app.add_option("--topology", topology)
+        ->check(CLI::IsMember({"erdos-renyi", "grid", "power-law"}));
+    app.add_option("--weights", weights)
+        ->check(CLI::IsMember({"unit", "uniform", "exponential"}));
+    app.add_option("--max-weight", max_weight)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--bind", bind)
+        ->check(CLI::IsMember({"none", "close", "spread"}));
+    app.add_option("--hugepages", hugepages)
+        ->check(CLI::IsMember({"none", "thp", "explicit"}));
+    app.add_option("--input", input);
+    app.add_option("--output", output);
+    app.add_option("--serve", serve);
+    app.add_option("--reset", reset)
+        ->check(CLI::IsMember({"copy", "source"}));
     CLI11_PARSE(app, argc, argv);
 
-    // Log the number of vertices and edges.
-    //spdlog::info("Number of vertices: {}", vertices);
-    //spdlog::info("Number of edges: {}", edges);
-
-    // Check if block length is greater than number of vertices.
-    if (block_length > vertices)
+    // A matrix file fixes the number of vertices and the distance type.
+    if (!input.empty())
     {
-        spdlog::error(
-            "Block length {} cannot be greater than number of vertices {}",
-            block_length,
-            vertices
-        );
-        return 1;
+        matrix_header header;
+        if (read_matrix_header(input, header) == -1)
+        {
+            return 1;
+        }
+        vertices = static_cast<int>(header.vertices);
+        dtype = matrix_dtype_name(header.dtype);
+        spdlog::info("Input {} holds {} vertices of type {}", input, vertices, dtype);
     }
 
-    // Check if the number of vertices is divisible by block length.
-    if (vertices % block_length != 0)
-    {
-        spdlog::error(
-            "Vertices: {} must be divisible by block length: {}",
-            vertices,
-            block_length
-        );
-        return 1;
-    }
+    // Log the number of vertices and edges.
+    //spdlog::info("Number of vertices: {}", vertices);
+    //spdlog::info("Number of edges: {}", edges);
 
     // Check if user input for threads is within maximum. If greater than, set to maximum.
     int max_threads = omp_get_max_threads();
@@ -147,6 +1152,49 @@ int main(const int argc, const char *const argv[])
     }
     omp_set_num_threads(threads);
 
+    // Backing of the matrix allocations.
+    if (hugepages == "none") {
+        set_hugepage_mode(hugepage_mode::none);
+    }
+    else if (hugepages == "explicit") {
+        set_hugepage_mode(hugepage_mode::explicit_pages);
+    }
+
+    // Pin the OpenMP threads, in place of OMP_PROC_BIND/OMP_PLACES.
+    numa_topology numa = read_numa_topology();
+    bind_policy binding = bind_policy::none;
+    parse_bind_policy(bind, binding);
+    if (binding != bind_policy::none && bind_threads(binding, numa) == -1)
+    {
+        spdlog::error("Failed to bind threads with policy {}", bind);
+        return 1;
+    }
+    std::vector<thread_placement> placements = thread_placements(numa);
+    for (const thread_placement & placement : placements) {
+        spdlog::info("Thread {} on CPU {}, node {}", placement.thread, placement.cpu, placement.node);
+    }
+
+    // Select the instruction set of the tile kernel. 'auto' keeps the CPUID selection.
+    if (simd != "auto")
+    {
+        tile_isa isa = tile_isa::scalar;
+        if (simd == "avx2") {
+            isa = tile_isa::avx2;
+        }
+        else if (simd == "avx512") {
+            isa = tile_isa::avx512;
+        }
+        if (!set_tile_isa(isa))
+        {
+            spdlog::error(
+                "SIMD instruction set {} is not supported, best available is {}",
+                simd,
+                tile_isa_name(detect_tile_isa())
+            );
+            return 1;
+        }
+    }
+
     // Print number of OMP threads in use -- used for testing.
     //#pragma omp parallel for
     //for (int t = 0; t < 1; t++) {
@@ -156,137 +1204,458 @@ int main(const int argc, const char *const argv[])
     //    );
     //}
 
-    // Check user input for mode of execution.
+    // Check user input for mode of execution; without one, `--serve` serves an --input file as already solved.
+    bool run_serve_only{false};
     if
     (
         !run_sequential &&
         !run_naive_parallel &&
-        !run_block_parallel
+        !run_block_parallel &&
+        !run_zero_copy_parallel &&
+        !run_task_parallel &&
+        !run_recursive &&
+        !run_offload &&
+        !run_out_of_core &&
+        batch == 0 &&
+        !run_closure &&
+        !run_sparse &&
+        !run_automatic
     )
     {
-        spdlog::error(
-            "\n"
-            "Specify mode of execution: \n"
-            "-s: sequential \n"
-            "-n: naive-parallel (No cache optimizations) \n"
-            "-b: block-parallel (Cache optimizations) \n"
-        );
+        run_serve_only = !serve.empty() && !input.empty();
+        if (!run_serve_only)
+        {
+            spdlog::error(
+                "\n"
+                "Specify mode of execution: \n"
+                "-s: sequential \n"
+                "-n: naive-parallel (No cache optimizations) \n"
+                "-b: block-parallel (Cache optimizations) \n"
+                "-z: zero-copy-block-parallel (Cache optimizations, in place) \n"
+                "-d: task-parallel (Cache optimizations, task DAG) \n"
+                "-r: recursive (Cache-oblivious quadrant recursion) \n"
+                "-g: offload (Blocked on an OpenMP target device) \n"
+                "--out-of-core: out-of-core (Blocked, strips streamed from --output) \n"
+                "--batch <count>: batch (Many graphs, whole graphs per thread) \n"
+                "--closure: closure (Reachability only, bit-packed Warshall) \n"
+                "--sparse: sparse (BFS/Dijkstra per source) \n"
+                "-a: auto (sparse or zero-copy-block-parallel by density) \n"
+                "--serve <socket> --input <file>: serve (Queries on an already solved matrix) \n"
+            );
+            return 1;
+        }
+    }
+
+    // The out-of-core, batch and closure modes are whole runs of their own, not kernels to choose among.
+    bool kernel_mode = run_sequential || run_naive_parallel || run_block_parallel || run_zero_copy_parallel ||
+        run_task_parallel || run_recursive || run_offload || run_sparse || run_automatic;
+    int whole_runs = (kernel_mode ? 1 : 0) + (run_out_of_core ? 1 : 0) + (batch > 0 ? 1 : 0) + (run_closure ? 1 : 0);
+    if (whole_runs > 1)
+    {
+        spdlog::error("--out-of-core, --batch and --closure cannot be combined with each other or with another mode");
         return 1;
     }
-    
-    // Generate graph.
-    spdlog::info("Generating graph data.");
-    std::vector<int> graph(vertices * vertices, INF);
-    if (generate_linear_graph(graph, vertices, edges) == -1)
+
+    // The offload mode needs the FW_OFFLOAD build; without a device its regions fall back to the host.
+    if (run_offload)
+    {
+        if (!offload_enabled())
+        {
+            spdlog::error("-g requires a build with -DFW_OFFLOAD=ON");
+            return 1;
+        }
+        if (offload_devices() == 0)
+        {
+            spdlog::warn("No OpenMP target device found; -g runs on the host");
+        }
+    }
+
+    // The phase instrumentation is compiled in only with FW_INSTRUMENT, and covers the -b and -z kernels.
+    instrument = instrument || !trace.empty() || hardware_counters;
+    if (instrument)
+    {
+        if (!instrument_enabled())
+        {
+            spdlog::error("--instrument, --trace and --counters require a build with -DFW_INSTRUMENT=ON");
+            return 1;
+        }
+        if ((!run_block_parallel && !run_zero_copy_parallel) || persistent)
+        {
+            spdlog::warn("Only -b and -z without --persistent record instrumented phases");
+        }
+    }
+
+    // The out-of-core mode works on the output file and never holds the whole matrix.
+    if (run_out_of_core)
     {
-        spdlog::error("Failed to generate graph... Exiting program.");
+        if (output.empty() || output == input)
+        {
+            spdlog::error("--out-of-core requires an --output file other than --input");
+            return 1;
+        }
+        if (paths || !route.empty() || print)
+        {
+            spdlog::error("--out-of-core does not support --paths, --path or -p");
+            return 1;
+        }
+    }
+
+    // The batch mode generates its own graphs and keeps none of them.
+    if (batch > 0)
+    {
+        if (!input.empty() || !output.empty() || paths || !route.empty() || print)
+        {
+            spdlog::error("--batch does not support --input, --output, --paths, --path or -p");
+            return 1;
+        }
+    }
+    else if (interleave)
+    {
+        spdlog::error("--interleave requires --batch");
         return 1;
     }
-    spdlog::info("Done populating graph with data.");
 
-    // Copy graph to graph_back
-    spdlog::info("Backing up graph data.");
-    std::vector<int> graph_back(vertices * vertices, INF);
-    for (int i = 0; i < vertices; i++) {
-        for (int j = 0; j < vertices; j++) {
-            int position = i * vertices + j;
-            graph_back[position] = graph[position];
+    // The closure mode keeps reachability bits only, so there are no distances to print or store.
+    if (run_closure)
+    {
+        if (!output.empty() || paths || !route.empty() || print)
+        {
+            spdlog::error("--closure does not support --output, --paths, --path or -p");
+            return 1;
         }
     }
 
-    // Print generated graph.
-    if (print)
+    // The query server needs the whole distance matrix resident; served files carry no next hops.
+    if (!serve.empty())
     {
-        fmt::print("Graph before Floyd-Warshall:\n");
-        print_graph(graph, vertices);
+        if (run_out_of_core || batch > 0 || run_closure)
+        {
+            spdlog::error("--serve does not support --out-of-core, --batch or --closure");
+            return 1;
+        }
+        if (run_serve_only && (!output.empty() || paths || !route.empty() || print))
+        {
+            spdlog::error("--serve without a mode does not support --output, --paths, --path or -p");
+            return 1;
+        }
     }
 
-    if (run_sequential)
+    // The batch and closure modes keep their own compact backups; the out-of-core mode always restores from the source.
+    if (reset == "source" && (batch > 0 || run_closure))
     {
-        for (int i = 0; i < iterations; i++) {
-            spdlog::info("Resetting graph.");
-            reset_graph(graph, graph_back, vertices);
-            spdlog::info("Starting nanotimer.");
-            plf::nanotimer sequential_time;
-            sequential_time.start();
-            spdlog::info("Beginning Floyd-Warshall sequential execution.");
-            serial_floyd_warshall(graph, vertices);
-            time_result = sequential_time.get_elapsed_ns();
-            spdlog::info("Sequential execution done.");
-            spdlog::info("Getting elapsed time...");
-            std::string label = "Sequential time, iteration: " + std::to_string(i);
-            mark_time(timestamps, time_result, label);
+        spdlog::error("--reset source does not support --batch or --closure");
+        return 1;
+    }
+
+    // The persistent kernels replace -n and -b; whichever of them runs must be the selected mode.
+    if (persistent)
+    {
+        if (run_sequential || (!run_naive_parallel && !run_block_parallel))
+        {
+            spdlog::error("--persistent requires -n or -b");
+            return 1;
+        }
+        if (paths || !route.empty())
+        {
+            spdlog::error("--persistent does not support --paths or --path");
+            return 1;
         }
     }
 
-    else if (run_naive_parallel)
+    // The semiring-generic kernels are -s, -b, -z and -d; max-plus needs a signed distance type for its -INF.
+    // The out-of-core, batch and closure runs are min-plus only.
+    semiring_kind semiring_policy = semiring_kind::min_plus;
+    if (semiring != "min-plus")
     {
-        for (int i = 0; i < iterations; i++) {
-            spdlog::info("Resetting graph.");
-            reset_graph(graph, graph_back, vertices);
-            spdlog::info("Beginning nanotimer...");
-            plf::nanotimer naive_parallel_time;
-            naive_parallel_time.start();
-            spdlog::info("Beginning Floyd-Warshall parallel without cache optimizations");
-            naive_floyd_warshall(graph, vertices);
-            time_result = naive_parallel_time.get_elapsed_ns();
-            spdlog::info("Naive execution done.");
-            spdlog::info("Getting elapsed time...");
-            std::string label = "Naive time, iteration: " + std::to_string(i);
-            mark_time(timestamps, time_result, label);
+        bool generic = run_sequential || (!run_naive_parallel && (run_block_parallel || run_zero_copy_parallel || run_task_parallel));
+        if (!generic || run_out_of_core || batch > 0 || run_closure || persistent || paths || !route.empty())
+        {
+            spdlog::error(
+                "--semiring {} requires -s, -b, -z or -d, without --out-of-core, --batch, --closure, --persistent, "
+                "--paths or --path",
+                semiring
+            );
+            return 1;
+        }
+        if (semiring == "max-plus" && dtype != "int32" && dtype != "float")
+        {
+            spdlog::error("--semiring max-plus requires the int32 or float distance type, not {}", dtype);
+            return 1;
+        }
+        if (semiring == "max-min") {
+            semiring_policy = semiring_kind::max_min;
+        }
+        else if (semiring == "max-plus") {
+            semiring_policy = semiring_kind::max_plus;
+        }
+        else {
+            semiring_policy = semiring_kind::or_and;
         }
     }
 
-    else if (run_block_parallel)
+    // Next hops are tracked by the serial, naive and copy-based blocked kernels.
+    if (!route.empty())
     {
-        for (int i = 0; i < iterations; i++) {
-            spdlog::info("Resetting graph.");
-            reset_graph(graph, graph_back, vertices);
-            spdlog::info("Beginning nanotimer...");
-            plf::nanotimer block_parallel_time;
-            block_parallel_time.start();
-            spdlog::info("Beginning Floyd-Warshall parallel with cache optimizations");
-            blocked_floyd_warshall(graph, vertices, block_length);
-            time_result = block_parallel_time.get_elapsed_ns();
-            spdlog::info("Optimized execution done.");
-            spdlog::info("Getting elapsed time...");
-            std::string label = "Block time, iteration: " + std::to_string(i);
-            mark_time(timestamps, time_result, label);
+        paths = true;
+        if (route[0] >= vertices || route[1] >= vertices)
+        {
+            spdlog::error("Path endpoints {} and {} must be below the number of vertices {}", route[0], route[1], vertices);
+            return 1;
         }
     }
+    if (paths && !run_sequential && !run_naive_parallel && !run_block_parallel)
+    {
+        spdlog::error("--paths requires one of -s, -n or -b");
+        return 1;
+    }
 
-    // Compute average:
+    size_t element_size = sizeof(int32_t);
+    if (dtype == "uint16") {
+        element_size = sizeof(uint16_t);
+    }
+    else if (dtype == "uint8") {
+        element_size = sizeof(uint8_t);
+    }
+
+    // Resolve block length: either an explicit value, or 'auto' (tuning cache, calibration or cache-size heuristic).
+    if (block_length_arg == "auto")
+    {
+        cache_sizes caches = read_cache_sizes();
+        spdlog::info(
+            "Cache sizes: L1d {} B, L2 {} B, L3 {} B",
+            caches.l1d,
+            caches.l2,
+            caches.l3
+        );
+        std::string kernel_name = "block";
+        if (!run_block_parallel && (run_zero_copy_parallel || run_automatic)) {
+            kernel_name = "zero-copy";
+        }
+        else if (!run_block_parallel && run_task_parallel) {
+            kernel_name = "task";
+        }
+        else if (!run_block_parallel && run_recursive) {
+            kernel_name = "recursive";
+        }
+        // Narrower distances fit larger tiles in the same cache, so the distance type is part of the key.
+        std::string tune_key = fmt::format(
+            "{}:{}:{}:{}",
+            kernel_name,
+            dtype,
+            threads,
+            vertices
+        );
+        // --calibrate always times the candidates again, replacing a stale cache entry.
+        bool calibrating = calibrate && (run_block_parallel || run_zero_copy_parallel || run_task_parallel || run_recursive || run_automatic);
+        block_length = calibrating ? -1 : load_tuned_block_length(tune_key);
+        if (block_length > 0)
+        {
+            spdlog::info("Using block length {} from {}", block_length, tune_cache_path());
+        }
+        else if (calibrating)
+        {
+            spdlog::info("Calibrating block length...");
+            if (dtype == "uint16") {
+                block_length = calibrate_kernel<uint16_t>(kernel_name, vertices, edges, caches);
+            }
+            else if (dtype == "uint8") {
+                block_length = calibrate_kernel<uint8_t>(kernel_name, vertices, edges, caches);
+            }
+            else if (dtype == "float") {
+                block_length = calibrate_kernel<float>(kernel_name, vertices, edges, caches);
+            }
+            else {
+                block_length = calibrate_kernel<int32_t>(kernel_name, vertices, edges, caches);
+            }
+            if (store_tuned_block_length(tune_key, block_length) == -1)
+            {
+                spdlog::error("Failed to write tuning cache {}", tune_cache_path());
+            }
+            spdlog::info("Calibrated block length is {}", block_length);
+        }
+        else
+        {
+            block_length = heuristic_block_length(vertices, caches, element_size);
+            spdlog::info("Block length {} chosen from cache sizes", block_length);
+        }
+    }
+    else
+    {
+        block_length = std::stoi(block_length_arg);
+    }
+    // Interleaved tiles are sized in cells of one 64-byte vector per lane; `0` leaves them to the solver.
+    if (interleave && block_length_arg == "auto")
+    {
+        block_length = 0;
+    }
+
+    // Check if block length is greater than number of vertices.
+    if (block_length > vertices)
+    {
+        spdlog::error(
+            "Block length {} cannot be greater than number of vertices {}",
+            block_length,
+            vertices
+        );
+        return 1;
+    }
+
+    
+    // Generate the graph and run the selected mode in the requested distance type.
+    run_mode mode{
+        run_sequential,
+        run_naive_parallel,
+        run_block_parallel,
+        run_zero_copy_parallel,
+        run_task_parallel,
+        run_recursive,
+        run_offload,
+        run_out_of_core,
+        batch > 0,
+        run_closure,
+        run_sparse,
+        run_automatic,
+        run_serve_only
+    };
+    graph_options generator;
+    generator.seed = seed;
+    if (topology == "grid") {
+        generator.topology = graph_topology::grid;
+    }
+    else if (topology == "power-law") {
+        generator.topology = graph_topology::power_law;
+    }
+    if (weights == "uniform") {
+        generator.weights = weight_distribution::uniform;
+        generator.max_weight = max_weight;
+    }
+    else if (weights == "exponential") {
+        generator.weights = weight_distribution::exponential;
+        generator.max_weight = max_weight;
+    }
+    run_config config{
+        vertices,
+        edges,
+        block_length,
+        iterations,
+        mode,
+        print,
+        input,
+        output,
+        generator,
+        sparse_threshold,
+        paths,
+        route,
+        static_cast<int>(numa.node_cpus.size()),
+        memory_budget * 1024 * 1024,
+        warmup,
+        instrument,
+        hardware_counters,
+        batch,
+        interleave,
+        persistent,
+        semiring_policy,
+        serve,
+        threads,
+        reset == "source"
+    };
+    int status = 1;
+    run_report report;
+    if (dtype == "int32") {
+        status = run<int32_t>(config, timestamps, phases, report);
+    }
+    else if (dtype == "uint16") {
+        status = run<uint16_t>(config, timestamps, phases, report);
+    }
+    else if (dtype == "uint8") {
+        status = run<uint8_t>(config, timestamps, phases, report);
+    }
+    else if (dtype == "float") {
+        status = run<float>(config, timestamps, phases, report);
+    }
+    instrument_stop();
+    if (status != 0)
+    {
+        return status;
+    }
+
+    // Serving a solved file times nothing.
+    if (run_serve_only)
+    {
+        spdlog::info("Exiting program.");
+        return 0;
+    }
+
+    // Per-phase statistics: the kernel, then generation and resets. The average stays for the scaling scripts.
+    std::vector<timing_summary> summaries = summarize_timestamps(timestamps);
+    for (const timing_summary & summary : summarize_timestamps(phases)) {
+        summaries.push_back(summary);
+    }
+    std::vector<std::tuple<std::string, double>> samples = timestamps;
+    samples.insert(samples.end(), phases.begin(), phases.end());
     double avg = compute_average(timestamps);
     mark_time(timestamps, avg, "Average execution time");
 
-    // Print execution details.
-    spdlog::info("Printing graph details.");
-    if (print)
+    // Print execution details; the closure mode holds one bit per pair.
+    size_t footprint = static_cast<size_t>(vertices) * vertices * element_size;
+    if (run_closure)
     {
-        fmt::print("Graph after Floyd-Warshall:\n");
-        print_graph(graph, vertices);
+        footprint = static_cast<size_t>(vertices) * bit_matrix_words(vertices) * sizeof(uint64_t);
     }
+    spdlog::info("Printing graph details.");
     fmt::print("Execution details:\n");
     fmt::print(
-        "Number of vertices: {}\nNumber of edges: {}\nGraph memory footprint: {}\nNumber of threads: {}\nBlock length: {}\n",
+        "Number of vertices: {}\nNumber of edges: {}\nGraph memory footprint: {}\nNumber of threads: {}\nBlock length: {}\nSIMD tile kernel: {}\nDistance type: {}\nSemiring: {}\n",
         vertices,
         edges,
-        graph.capacity() * sizeof(graph[0]),
+        footprint,
         threads,
-        block_length
+        block_length,
+        tile_isa_name(get_tile_isa()),
+        dtype,
+        semiring
+    );
+    std::vector<int> threads_per_node(numa.node_cpus.size(), 0);
+    for (const thread_placement & placement : placements) {
+        if (placement.node >= 0) {
+            threads_per_node[placement.node]++;
+        }
+    }
+    fmt::print(
+        "Thread binding: {}\nThreads per NUMA node: {}\nMatrix memory: {}\nMatrix pages per NUMA node: {}\n",
+        bind_policy_name(binding),
+        fmt::join(threads_per_node, " "),
+        report.matrix_memory,
+        fmt::join(report.matrix_pages, " ")
     );
     spdlog::info("Printing timestamps...");
     print_timestamps(timestamps);
+    print_summaries(summaries);
+    if (!timings.empty())
+    {
+        if (write_timestamps(timings, timings_format, samples, summaries) == -1)
+        {
+            return 1;
+        }
+    }
+    if (instrument)
+    {
+        print_instrument_summary();
+    }
+    if (!trace.empty())
+    {
+        if (write_chrome_trace(trace) == -1)
+        {
+            return 1;
+        }
+    }
     spdlog::info("Exiting program.");
     return 0;
 }
 
-static void reset_graph(std::vector<int> & graph, std::vector<int> & graph_back, int vertices)
+template <typename T>
+static void reset_graph(T * graph, const T * graph_back, int vertices, int block_length)
 {
-    for (int i = 0; i < vertices; i++) {
-        for (int j = 0; j < vertices; j++) {
-            int position = i * vertices + j;
-            graph[position] = graph_back[position];
-        }
-    }
+    // Tile-row parallel copy, so every page stays on the node of the thread that owns it.
+    copy_matrix(graph, graph_back, vertices, block_length);
 }
\ No newline at end of file
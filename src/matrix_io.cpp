@@ -0,0 +1,155 @@
+#include "matrix_io.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char matrix_magic[8] = {'F', 'W', 'M', 'A', 'T', 'R', 'I', 'X'};
+
+template <> matrix_dtype dtype_of<int32_t>() { return matrix_dtype::int32; }
+template <> matrix_dtype dtype_of<uint16_t>() { return matrix_dtype::uint16; }
+template <> matrix_dtype dtype_of<uint8_t>() { return matrix_dtype::uint8; }
+template <> matrix_dtype dtype_of<float>() { return matrix_dtype::float32; }
+
+/**
+ * @brief Returns the element size of a `matrix_dtype` code, or `0` if unknown.
+ */
+static size_t matrix_element_size(uint32_t dtype) {
+    switch (static_cast<matrix_dtype>(dtype)) {
+        case matrix_dtype::int32:
+        case matrix_dtype::float32:
+            return 4;
+        case matrix_dtype::uint16:
+            return 2;
+        case matrix_dtype::uint8:
+            return 1;
+    }
+    return 0;
+}
+
+const char * matrix_dtype_name(uint32_t dtype) {
+    switch (static_cast<matrix_dtype>(dtype)) {
+        case matrix_dtype::int32:
+            return "int32";
+        case matrix_dtype::uint16:
+            return "uint16";
+        case matrix_dtype::uint8:
+            return "uint8";
+        case matrix_dtype::float32:
+            return "float";
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the number of bytes a file with `header` must have: header, padding and matrix.
+ */
+static size_t matrix_file_size(const matrix_header & header) {
+    return header.data_offset + header.vertices * header.vertices * header.element_size;
+}
+
+int read_matrix_header(const std::string & path, matrix_header & header) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        spdlog::error("Cannot open matrix file {}: {}", path, strerror(errno));
+        return -1;
+    }
+    struct stat info;
+    ssize_t got = pread(fd, &header, sizeof(header), 0);
+    int status = fstat(fd, &info);
+    close(fd);
+
+    if (got != static_cast<ssize_t>(sizeof(header)) || std::memcmp(header.magic, matrix_magic, sizeof(matrix_magic)) != 0) {
+        spdlog::error("{} is not a matrix file", path);
+        return -1;
+    }
+    if (header.version != 1 || matrix_element_size(header.dtype) == 0 || matrix_element_size(header.dtype) != header.element_size) {
+        spdlog::error("{} has an unsupported version {} or dtype {}", path, header.version, header.dtype);
+        return -1;
+    }
+    if (status == -1 || static_cast<size_t>(info.st_size) < matrix_file_size(header)) {
+        spdlog::error("{} is truncated: expected {} bytes", path, matrix_file_size(header));
+        return -1;
+    }
+    return 1;
+}
+
+int map_matrix(const std::string & path, mapped_matrix & matrix, bool writable) {
+    matrix = mapped_matrix{};
+    if (read_matrix_header(path, matrix.header) == -1) {
+        return -1;
+    }
+    int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (fd == -1) {
+        spdlog::error("Cannot open matrix file {}: {}", path, strerror(errno));
+        return -1;
+    }
+    size_t length = matrix_file_size(matrix.header);
+    void * base = mmap(nullptr, length, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        spdlog::error("Cannot map matrix file {}: {}", path, strerror(errno));
+        return -1;
+    }
+    matrix.base = base;
+    matrix.length = length;
+    matrix.data = static_cast<char *>(base) + matrix.header.data_offset;
+    return 1;
+}
+
+int create_matrix(const std::string & path, matrix_dtype dtype, int vertices, int block_length, mapped_matrix & matrix) {
+    matrix = mapped_matrix{};
+    matrix_header & header = matrix.header;
+    std::memcpy(header.magic, matrix_magic, sizeof(matrix_magic));
+    header.version = 1;
+    header.dtype = static_cast<uint32_t>(dtype);
+    header.vertices = static_cast<uint64_t>(vertices);
+    header.data_offset = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    header.block_length = static_cast<uint32_t>(block_length);
+    header.element_size = static_cast<uint32_t>(matrix_element_size(header.dtype));
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        spdlog::error("Cannot create matrix file {}: {}", path, strerror(errno));
+        return -1;
+    }
+    size_t length = matrix_file_size(header);
+    if (ftruncate(fd, static_cast<off_t>(length)) == -1) {
+        spdlog::error("Cannot size matrix file {} to {} bytes: {}", path, length, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    void * base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        spdlog::error("Cannot map matrix file {}: {}", path, strerror(errno));
+        return -1;
+    }
+    std::memcpy(base, &header, sizeof(header));
+    matrix.base = base;
+    matrix.length = length;
+    matrix.data = static_cast<char *>(base) + header.data_offset;
+    return 1;
+}
+
+int revert_matrix(mapped_matrix & matrix) {
+    if (madvise(matrix.base, matrix.length, MADV_DONTNEED) != 0) {
+        spdlog::error("Cannot revert matrix mapping: {}", strerror(errno));
+        return -1;
+    }
+    return 1;
+}
+
+void unmap_matrix(mapped_matrix & matrix) {
+    if (matrix.base == nullptr) {
+        return;
+    }
+    msync(matrix.base, matrix.length, MS_SYNC);
+    munmap(matrix.base, matrix.length);
+    matrix.base = nullptr;
+    matrix.data = nullptr;
+    matrix.length = 0;
+}
@@ -0,0 +1,131 @@
+#ifndef MATRIX_IO_H
+#define MATRIX_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Distance type codes stored in the binary matrix header.
+ */
+enum class matrix_dtype : uint32_t {
+    int32 = 1,
+    uint16 = 2,
+    uint8 = 3,
+    float32 = 4
+};
+
+/**
+ * @brief Header of the binary matrix format.
+ * 
+ * A matrix file is this 64-byte header, zero padding up to `data_offset`, and then the `vertices x vertices`
+ * matrix in the same flattened row-major layout the kernels use, in native byte order. `data_offset` is a
+ * multiple of the page size, so a mapping of the file hands the kernels a page-aligned matrix with no copy
+ * and no parse step.
+ */
+struct matrix_header {
+    char magic[8];          // "FWMATRIX"
+    uint32_t version;       // Format version, currently 1
+    uint32_t dtype;         // A matrix_dtype code
+    uint64_t vertices;      // Matrix dimension n
+    uint64_t data_offset;   // Byte offset of the first element, page aligned
+    uint32_t block_length;  // Block length the matrix was solved or tuned with, 0 if unknown
+    uint32_t element_size;  // sizeof the distance type, checked on load
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(matrix_header) == 64, "matrix_header must stay 64 bytes");
+
+/**
+ * @brief A matrix file mapped into memory. Release it with `unmap_matrix`.
+ */
+struct mapped_matrix {
+    matrix_header header;
+    void * base;            // Start of the mapping (the header)
+    size_t length;          // Length of the mapping in bytes
+    void * data;            // First matrix element, base + header.data_offset
+};
+
+/**
+ * @brief Returns the `matrix_dtype` code of distance type `T`.
+ */
+template <typename T>
+matrix_dtype dtype_of();
+
+/**
+ * @brief Returns the `--dtype` name (`int32`, `uint16`, `uint8`, `float`) of a `matrix_dtype` code, or `nullptr` if unknown.
+ */
+const char * matrix_dtype_name(
+    uint32_t dtype
+);
+
+/**
+ * @brief Reads and validates the header of a matrix file without mapping the matrix.
+ * 
+ * @param path Path of the matrix file.
+ * @param header Receives the header.
+ * @return int Returns `1` on success, or `-1` if the file cannot be read, is not a matrix file, or is truncated.
+ */
+int read_matrix_header(
+    const std::string & path,
+    matrix_header & header
+);
+
+/**
+ * @brief Maps an existing matrix file.
+ * 
+ * @param path Path of the matrix file.
+ * @param matrix Receives the mapping.
+ * @param writable If `true`, the mapping is shared and writable, so kernels update the file in place. If `false`,
+ *                 the mapping is private copy-on-write: kernels can still run on it, but the file is never modified.
+ * @return int Returns `1` on success, or `-1` on error (logged with `spdlog`).
+ */
+int map_matrix(
+    const std::string & path,
+    mapped_matrix & matrix,
+    bool writable
+);
+
+/**
+ * @brief Creates (or truncates) a matrix file of the given size, writes its header and maps it shared and writable.
+ * 
+ * Kernels can then solve directly into the file; the result is on disk once the mapping is released.
+ * The matrix element area is left zeroed.
+ * 
+ * @param path Path of the matrix file.
+ * @param dtype The distance type of the matrix.
+ * @param vertices The matrix dimension.
+ * @param block_length The block length to record in the header, or `0`.
+ * @param matrix Receives the mapping.
+ * @return int Returns `1` on success, or `-1` on error (logged with `spdlog`).
+ */
+int create_matrix(
+    const std::string & path,
+    matrix_dtype dtype,
+    int vertices,
+    int block_length,
+    mapped_matrix & matrix
+);
+
+/**
+ * @brief Discards every write to a copy-on-write mapping (`map_matrix` with `writable == false`), so it reads
+ *        the file contents again at the same address.
+ * 
+ * @details The private copies of the written pages are dropped with `madvise(MADV_DONTNEED)`; the next access
+ *          faults the page back in from the page cache. Nothing is copied, so a reset costs one page fault per
+ *          page the kernel wrote rather than a full matrix copy, and no backup matrix is needed.
+ * 
+ * @return int Returns `1` on success, or `-1` on error (logged with `spdlog`).
+ */
+int revert_matrix(
+    mapped_matrix & matrix
+);
+
+/**
+ * @brief Flushes a writable mapping to disk and unmaps it. Safe to call on a mapping that was never created.
+ */
+void unmap_matrix(
+    mapped_matrix & matrix
+);
+
+#endif
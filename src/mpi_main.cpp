@@ -0,0 +1,308 @@
+#include "distributed.h"
+#include "graph.h"
+#include "plf_nanotimer.h"
+#include "timestamps.h"
+#include "kernels.h"
+#include "tile.h"
+#include "globals.h"
+#include "allocator.h"
+#include <mpi.h>
+#include <omp.h>
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of a distributed run, identical on every rank.
+ */
+struct mpi_config {
+    int vertices;
+    int edges;
+    int block_length;
+    int iterations;
+    bool print;
+    bool verify;            // Gather the result on rank 0 and compare it with the shared-memory blocked kernel
+    graph_options generator;
+};
+
+/**
+ * @brief Generates the distributed graph in distance type `T`, solves it for every iteration and records the timings on rank 0.
+ *
+ * @tparam T The distance type selected with `--dtype` (see `distance_traits`).
+ * @param config The validated settings.
+ * @param grid The process grid.
+ * @param timestamps Receives one labeled time per iteration, on rank 0.
+ * @return int Returns `0` on success, or `1` if the graph cannot be generated or the verification fails.
+ *
+ * @details
+ * - Every iteration regenerates the local tiles from the seed, so no process ever holds more than its own
+ *   tiles plus one tile row of scratch, and no iteration starts from a solved matrix.
+ * - A barrier precedes the timer, and the time of an iteration is the time until the slowest rank is done.
+ */
+template <typename T>
+static int run(
+    const mpi_config & config,
+    const process_grid & grid,
+    std::vector<std::tuple<std::string, double>> & timestamps
+)
+{
+    double time_result;
+    block_cyclic_matrix<T> W = make_block_cyclic_matrix<T>(grid, config.vertices, config.block_length);
+
+    for (int i = 0; i < config.iterations; i++) {
+        spdlog::info("Generating local tiles.");
+        int status = generate_block_cyclic(W, grid, config.edges, config.generator);
+        int failed = status == -1;
+        MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_MAX, grid.comm);
+        if (failed)
+        {
+            return 1;
+        }
+        MPI_Barrier(grid.comm);
+        spdlog::info("Beginning nanotimer...");
+        plf::nanotimer distributed_time;
+        distributed_time.start();
+        spdlog::info("Beginning Floyd-Warshall distributed over a {} x {} process grid", grid.rows, grid.cols);
+        distributed_floyd_warshall(W, grid);
+        MPI_Barrier(grid.comm);
+        time_result = distributed_time.get_elapsed_ns();
+        spdlog::info("Distributed execution done.");
+        if (grid.rank == 0)
+        {
+            std::string label = "Distributed block time, iteration: " + std::to_string(i);
+            mark_time(timestamps, time_result, label);
+        }
+    }
+
+    if (!config.print && !config.verify)
+    {
+        return 0;
+    }
+
+    // Small graphs only: the whole matrix is collected on rank 0.
+    std::vector<T> solved(grid.rank == 0 ? static_cast<size_t>(config.vertices) * config.vertices : 0);
+    gather_matrix(W, grid, solved.data());
+    if (grid.rank != 0)
+    {
+        return 0;
+    }
+    if (config.print)
+    {
+        print_graph(solved.data(), config.vertices);
+    }
+    if (config.verify)
+    {
+        std::vector<T> expected(solved.size());
+        generate_linear_graph(expected.data(), config.vertices, config.edges, config.generator);
+        blocked_floyd_warshall(expected.data(), config.vertices, config.block_length);
+        bool match = expected == solved;
+        fmt::print("Verification against blocked kernel: {}\n", match ? "passed" : "failed");
+        if (!match)
+        {
+            spdlog::error("Distributed result differs from the shared-memory blocked kernel");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Entry point of the distributed Floyd-Warshall engine, run with `mpirun`.
+ *
+ * Every rank parses the same arguments, generates only its own tiles of the graph, and solves the graph with
+ * `distributed_floyd_warshall` on a 2D block-cyclic process grid. Rank 0 prints the execution details.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line arguments.
+ * @return int Returns `0` on success, or `1` on invalid input, generation failure or failed verification.
+ *
+ * @details
+ * 1. **Command-Line Parsing**:
+ *    - `-v, --vertices`: Number of vertices in the graph (default: 100).
+ *    - `-e, --edges`: Number of edges in the graph (default: 200).
+ *    - `-t, --threads`: Number of OpenMP threads per rank (default: 1).
+ *    - `-l, --block-length`: Tile size of the block-cyclic distribution (default: 64).
+ *    - `-i, --iterations`: Number of iterations (default: 1).
+ *    - `--grid-rows`: Process rows of the grid; must divide the number of ranks (default: most square grid).
+ *    - `--dtype`: Distance type: `int32`, `uint16`, `uint8` or `float` (default: int32).
+ *    - `--seed`, `--topology`, `--weights`, `--max-weight`: Graph generator settings, as in `floyd_warshall`.
+ *    - `--hugepages`: Backing of the local tiles: `none`, `thp` or `explicit` (default: thp).
+ *    - `--verify`: Collect the result on rank 0 and compare it with `blocked_floyd_warshall` (small graphs only).
+ *    - `-p, --print`: Collect and print the solved graph on rank 0 (small graphs only).
+ *
+ * 2. **Logging**: Each rank logs to its own `logfile_rank<r>.txt`.
+ *
+ * @note MPI is initialized with `MPI_THREAD_FUNNELED`: only the master thread of each rank calls MPI.
+ *
+ * @example
+ * To solve a 50k vertex graph on 16 ranks of 8 threads each:
+ * ```
+ * mpirun -np 16 ./floyd_warshall_mpi -v 50000 -e 5000000 -t 8 -l 128
+ * ```
+ */
+int main(int argc, char *argv[])
+{
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // Setting up spdlog, one file per rank.
+    auto file_logger = spdlog::basic_logger_mt("file_logger", fmt::format("logfile_rank{}.txt", rank));
+    spdlog::set_default_logger(file_logger);
+    if (provided < MPI_THREAD_FUNNELED)
+    {
+        spdlog::warn("MPI provides thread level {} only, below MPI_THREAD_FUNNELED", provided);
+    }
+
+    // Initializing defaults.
+    int vertices{100};
+    int edges{200};
+    int threads{1};
+    int block_length{64};
+    int iterations{1};
+    int grid_rows{0};
+    std::string dtype{"int32"};
+    uint64_t seed{0};
+    std::string topology{"erdos-renyi"};
+    std::string weights{"unit"};
+    int max_weight{100};
+    std::string hugepages{"thp"};
+    bool verify{false};
+    bool print{false};
+
+    // Parse user input.
+    CLI::App app{"Distributed Floyd-Warshall"};
+    app.add_option("-v, --vertices", vertices)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-e, --edges", edges)
+        ->check(CLI::NonNegativeNumber.description(" >= 0"));
+    app.add_option("-t, --threads", threads)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-l, --block-length", block_length)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-i, --iterations", iterations)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--grid-rows", grid_rows)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--dtype", dtype)
+        ->check(CLI::IsMember({"int32", "uint16", "uint8", "float"}));
+    app.add_option("--seed", seed);
+    app.add_option("--topology", topology)
+        ->check(CLI::IsMember({"erdos-renyi", "grid", "power-law"}));
+    app.add_option("--weights", weights)
+        ->check(CLI::IsMember({"unit", "uniform", "exponential"}));
+    app.add_option("--max-weight", max_weight)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--hugepages", hugepages)
+        ->check(CLI::IsMember({"none", "thp", "explicit"}));
+    app.add_flag("--verify", verify);
+    app.add_flag("-p, --print", print);
+    try
+    {
+        app.parse(argc, argv);
+    }
+    catch (const CLI::ParseError & e)
+    {
+        int code = rank == 0 ? app.exit(e) : e.get_exit_code();
+        MPI_Finalize();
+        return code;
+    }
+
+    // Every check below depends on the arguments only, so all ranks agree on the outcome.
+    if (block_length > vertices)
+    {
+        spdlog::error(
+            "Block length {} cannot be greater than number of vertices {}",
+            block_length,
+            vertices
+        );
+        MPI_Finalize();
+        return 1;
+    }
+    process_grid grid = make_process_grid(MPI_COMM_WORLD, grid_rows);
+    if (grid.comm == MPI_COMM_NULL)
+    {
+        spdlog::error("Grid rows {} do not divide the number of ranks {}", grid_rows, grid.size);
+        MPI_Finalize();
+        return 1;
+    }
+
+    // Cap the thread count to the maximum available OpenMP threads.
+    threads = std::min(threads, omp_get_max_threads());
+    omp_set_num_threads(threads);
+    if (hugepages == "none") {
+        set_hugepage_mode(hugepage_mode::none);
+    }
+    else if (hugepages == "explicit") {
+        set_hugepage_mode(hugepage_mode::explicit_pages);
+    }
+
+    mpi_config config{vertices, edges, block_length, iterations, print, verify, graph_options{}};
+    config.generator.seed = seed;
+    if (topology == "grid") {
+        config.generator.topology = graph_topology::grid;
+    }
+    else if (topology == "power-law") {
+        config.generator.topology = graph_topology::power_law;
+    }
+    if (weights == "uniform") {
+        config.generator.weights = weight_distribution::uniform;
+        config.generator.max_weight = max_weight;
+    }
+    else if (weights == "exponential") {
+        config.generator.weights = weight_distribution::exponential;
+        config.generator.max_weight = max_weight;
+    }
+
+    std::vector<std::tuple<std::string, double>> timestamps;
+    int status = 1;
+    size_t element_size = sizeof(int32_t);
+    if (dtype == "int32") {
+        status = run<int32_t>(config, grid, timestamps);
+    }
+    else if (dtype == "uint16") {
+        status = run<uint16_t>(config, grid, timestamps);
+        element_size = sizeof(uint16_t);
+    }
+    else if (dtype == "uint8") {
+        status = run<uint8_t>(config, grid, timestamps);
+        element_size = sizeof(uint8_t);
+    }
+    else if (dtype == "float") {
+        status = run<float>(config, grid, timestamps);
+        element_size = sizeof(float);
+    }
+
+    if (status == 0 && grid.rank == 0)
+    {
+        std::vector<timing_summary> summaries = summarize_timestamps(timestamps);
+        double avg = compute_average(timestamps);
+        mark_time(timestamps, avg, "Average execution time");
+        int tiles = (vertices + block_length - 1) / block_length;
+        fmt::print("Execution details:\n");
+        fmt::print(
+            "Number of vertices: {}\nNumber of edges: {}\nGraph memory footprint: {}\nNumber of ranks: {}\nProcess grid: {} x {}\nLargest local part: {}\nThreads per rank: {}\nBlock length: {}\nSIMD tile kernel: {}\nDistance type: {}\n",
+            vertices,
+            edges,
+            static_cast<size_t>(vertices) * vertices * element_size,
+            grid.size,
+            grid.rows,
+            grid.cols,
+            static_cast<size_t>((tiles + grid.rows - 1) / grid.rows) * ((tiles + grid.cols - 1) / grid.cols) * block_length * block_length * element_size,
+            threads,
+            block_length,
+            tile_isa_name(get_tile_isa()),
+            dtype
+        );
+        print_timestamps(timestamps);
+        print_summaries(summaries);
+    }
+    spdlog::info("Exiting program.");
+    free_process_grid(grid);
+    MPI_Finalize();
+    return status;
+}
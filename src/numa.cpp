@@ -0,0 +1,230 @@
+#include "numa.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <omp.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Parses a sysfs CPU list such as `0-3,8-11` into CPU numbers.
+ */
+static std::vector<int> parse_cpu_list(const std::string & text) {
+    std::vector<int> cpus;
+    std::stringstream ranges(text);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+numa_topology read_numa_topology() {
+    numa_topology topology;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                topology.allowed_cpus.push_back(cpu);
+            }
+        }
+    }
+
+    for (int node = 0; ; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file) {
+            break;
+        }
+        std::string text;
+        std::getline(file, text);
+        std::vector<int> cpus;
+        for (int cpu : parse_cpu_list(text)) {
+            if (std::find(topology.allowed_cpus.begin(), topology.allowed_cpus.end(), cpu) != topology.allowed_cpus.end()) {
+                cpus.push_back(cpu);
+            }
+        }
+        topology.node_cpus.push_back(cpus);
+    }
+    if (topology.node_cpus.empty()) {
+        topology.node_cpus.push_back(topology.allowed_cpus);
+    }
+    return topology;
+}
+
+bool parse_bind_policy(const std::string & name, bind_policy & policy) {
+    if (name == "none") {
+        policy = bind_policy::none;
+    }
+    else if (name == "close") {
+        policy = bind_policy::close;
+    }
+    else if (name == "spread") {
+        policy = bind_policy::spread;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+const char * bind_policy_name(bind_policy policy) {
+    switch (policy) {
+        case bind_policy::close:
+            return "close";
+        case bind_policy::spread:
+            return "spread";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * @brief Orders the allowed CPUs for `policy`: node by node for `close`, one CPU per node in turn for `spread`.
+ */
+static std::vector<int> cpu_order(bind_policy policy, const numa_topology & topology) {
+    std::vector<int> order;
+    if (policy == bind_policy::close) {
+        for (const std::vector<int> & cpus : topology.node_cpus) {
+            order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+    }
+    else {
+        size_t depth = 0;
+        for (const std::vector<int> & cpus : topology.node_cpus) {
+            depth = std::max(depth, cpus.size());
+        }
+        for (size_t c = 0; c < depth; c++) {
+            for (const std::vector<int> & cpus : topology.node_cpus) {
+                if (c < cpus.size()) {
+                    order.push_back(cpus[c]);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+int bind_threads(bind_policy policy, const numa_topology & topology) {
+    std::vector<int> order = cpu_order(policy, topology);
+    if (policy != bind_policy::none && order.empty()) {
+        return -1;
+    }
+    int failures = 0;
+
+    #pragma omp parallel reduction(+ : failures)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (policy == bind_policy::none) {
+            for (int cpu : topology.allowed_cpus) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        else {
+            CPU_SET(order[omp_get_thread_num() % order.size()], &set);
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            failures++;
+        }
+    }
+    return failures == 0 ? 1 : -1;
+}
+
+/**
+ * @brief Returns the NUMA node of `cpu`, or `-1` if it is in no node of `topology`.
+ */
+static int node_of_cpu(const numa_topology & topology, int cpu) {
+    for (size_t node = 0; node < topology.node_cpus.size(); node++) {
+        const std::vector<int> & cpus = topology.node_cpus[node];
+        if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+            return static_cast<int>(node);
+        }
+    }
+    return -1;
+}
+
+std::vector<thread_placement> thread_placements(const numa_topology & topology) {
+    std::vector<thread_placement> placements(omp_get_max_threads());
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int cpu = sched_getcpu();
+        placements[thread] = thread_placement{thread, cpu, node_of_cpu(topology, cpu)};
+    }
+    return placements;
+}
+
+std::vector<long> page_nodes(const void * data, size_t bytes, int nodes) {
+    std::vector<long> counts(nodes, 0);
+#ifdef SYS_move_pages
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t first = reinterpret_cast<uintptr_t>(data) / page * page;
+    size_t total = (reinterpret_cast<uintptr_t>(data) + bytes - first + page - 1) / page;
+    size_t samples = std::min<size_t>(total, 4096);
+    if (samples == 0) {
+        return counts;
+    }
+    std::vector<void *> pages(samples);
+    std::vector<int> status(samples, -1);
+    for (size_t s = 0; s < samples; s++) {
+        pages[s] = reinterpret_cast<void *>(first + (s * total / samples) * page);
+    }
+    // With no target nodes, move_pages only reports the node of each page.
+    if (syscall(SYS_move_pages, 0, samples, pages.data(), nullptr, status.data(), 0) == 0) {
+        for (int node : status) {
+            if (node >= 0 && node < nodes) {
+                counts[node]++;
+            }
+        }
+    }
+#endif
+    return counts;
+}
+
+template <typename T>
+void first_touch(T * W, int n, int b, T value)
+{
+    int B = (n + b - 1) / b;
+
+    #pragma omp parallel for
+    for (int i = 0; i < B; i++) {
+        size_t begin = static_cast<size_t>(i) * b * n;
+        size_t end = static_cast<size_t>(std::min(n, (i + 1) * b)) * n;
+        std::fill(W + begin, W + end, value);
+    }
+}
+
+template <typename T>
+void copy_matrix(T * dst, const T * src, int n, int b)
+{
+    int B = (n + b - 1) / b;
+
+    #pragma omp parallel for
+    for (int i = 0; i < B; i++) {
+        size_t begin = static_cast<size_t>(i) * b * n;
+        size_t end = static_cast<size_t>(std::min(n, (i + 1) * b)) * n;
+        std::memcpy(dst + begin, src + begin, (end - begin) * sizeof(T));
+    }
+}
+
+#define INSTANTIATE_NUMA(T) \
+    template void first_touch<T>(T *, int, int, T); \
+    template void copy_matrix<T>(T *, const T *, int, int);
+
+INSTANTIATE_NUMA(int32_t)
+INSTANTIATE_NUMA(uint16_t)
+INSTANTIATE_NUMA(uint8_t)
+INSTANTIATE_NUMA(float)
@@ -0,0 +1,135 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Thread pinning policy, after `OMP_PROC_BIND`.
+ */
+enum class bind_policy {
+    none,       // Every thread may run on any CPU of the process
+    close,      // Thread `t` on the `t`-th allowed CPU, filling one NUMA node before the next
+    spread      // Consecutive threads alternate between NUMA nodes, so every node gets its share of threads
+};
+
+/**
+ * @brief CPUs of every NUMA node, restricted to the CPUs the process may run on.
+ * 
+ * @details Read from `/sys/devices/system/node/node<N>/cpulist`. Without that directory (non-NUMA kernels),
+ *          all allowed CPUs form node `0`.
+ */
+struct numa_topology {
+    std::vector<std::vector<int>> node_cpus;
+    std::vector<int> allowed_cpus;   // Affinity of the process when the topology was read
+};
+
+/**
+ * @brief Where one OpenMP thread ran, as reported by `thread_placements`.
+ */
+struct thread_placement {
+    int thread;
+    int cpu;
+    int node;
+};
+
+/**
+ * @brief Reads the NUMA topology of the machine and the CPU affinity of the process.
+ */
+numa_topology read_numa_topology();
+
+/**
+ * @brief Parses `none`, `close` or `spread`.
+ * 
+ * @return bool `false` if `name` is not a policy; `policy` is then left unchanged.
+ */
+bool parse_bind_policy(
+    const std::string & name,
+    bind_policy & policy
+);
+
+/**
+ * @brief Returns the name of a binding policy, for reporting.
+ */
+const char * bind_policy_name(
+    bind_policy policy
+);
+
+/**
+ * @brief Pins every thread of the OpenMP team to one CPU chosen by `policy`.
+ * 
+ * @param policy The pinning policy; `bind_policy::none` restores the affinity of the process.
+ * @param topology The topology returned by `read_numa_topology`.
+ * @return int Returns `1` on success, or `-1` if a thread could not be pinned.
+ * 
+ * @details
+ * - Each thread of a parallel region calls `sched_setaffinity` on itself. OpenMP runtimes keep their worker
+ *   threads between regions of the same size, so later regions run on the same CPUs.
+ * - This plays the role of `OMP_PROC_BIND`/`OMP_PLACES`, which runtimes read once at startup and so cannot be
+ *   set from the command line of the program itself. Call it after `omp_set_num_threads`.
+ * - With more threads than CPUs, threads wrap around the CPU order.
+ */
+int bind_threads(
+    bind_policy policy,
+    const numa_topology & topology
+);
+
+/**
+ * @brief Reports the CPU and NUMA node of every thread of the OpenMP team.
+ */
+std::vector<thread_placement> thread_placements(
+    const numa_topology & topology
+);
+
+/**
+ * @brief Counts the pages of `[data, data + bytes)` resident on each NUMA node.
+ * 
+ * @param data The start of the buffer, typically the distance matrix.
+ * @param bytes The length of the buffer.
+ * @param nodes The number of NUMA nodes, the size of the returned vector.
+ * @return std::vector<long> Pages per node, from a sample of at most 4096 evenly spaced pages. Pages that are
+ *         not resident or cannot be queried (no `move_pages`) are not counted.
+ */
+std::vector<long> page_nodes(
+    const void * data,
+    size_t bytes,
+    int nodes
+);
+
+/**
+ * @brief Fills a freshly allocated matrix with `value`, each tile row written by the thread that owns it in the kernels.
+ * 
+ * @tparam T The distance type.
+ * @param W A pointer to the untouched `n x n` matrix, e.g. from `new T[n * n]`.
+ * @param n The number of vertices.
+ * @param b The block length of the run; tile row `i` holds matrix rows `[i * b, (i + 1) * b)`.
+ * @param value The value written to every element.
+ * 
+ * @details The tile rows are spread with `#pragma omp parallel for` and the default static schedule, the
+ *          same decomposition as the row loops of the blocked kernels, so under first-touch placement each
+ *          tile row lands on the NUMA node of the thread that later updates it.
+ */
+template <typename T>
+void first_touch(
+    T * W,
+    int n,
+    int b,
+    T value
+);
+
+/**
+ * @brief Copies an `n x n` matrix with the tile-row decomposition of `first_touch`.
+ * 
+ * @details Used for the backup of the input matrix and for resetting it between iterations, so both stay
+ *          node-local and the copy runs at the bandwidth of all sockets.
+ */
+template <typename T>
+void copy_matrix(
+    T * dst,
+    const T * src,
+    int n,
+    int b
+);
+
+#endif
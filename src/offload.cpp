@@ -0,0 +1,110 @@
+#include "offload.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+
+bool offload_enabled() {
+#ifdef FW_OFFLOAD
+    return true;
+#else
+    return false;
+#endif
+}
+
+int offload_devices() {
+#ifdef FW_OFFLOAD
+    return omp_get_num_devices();
+#else
+    return 0;
+#endif
+}
+
+#ifdef FW_OFFLOAD
+
+template <typename T>
+int offload_floyd_warshall(T *W, int n, int b) {
+    const size_t cells = static_cast<size_t>(n) * n;
+    const int tiles = (n + b - 1) / b;
+
+    // The matrix stays on the device for every round; only the final result is copied back.
+    #pragma omp target data map(tofrom: W[0:cells])
+    for (int kb = 0; kb < tiles; ++kb) {
+        const int k0 = kb * b;
+        const int k1 = std::min(n, k0 + b);
+
+        // Dependent phase: W[k][k], one team stepping through k with a barrier between steps.
+        #pragma omp target teams num_teams(1)
+        #pragma omp parallel
+        for (int k = k0; k < k1; ++k) {
+            #pragma omp for collapse(2)
+            for (int i = k0; i < k1; ++i) {
+                for (int j = k0; j < k1; ++j) {
+                    T sum = distance_traits<T>::add(W[static_cast<size_t>(i) * n + k], W[static_cast<size_t>(k) * n + j]);
+                    if (sum < W[static_cast<size_t>(i) * n + j]) {
+                        W[static_cast<size_t>(i) * n + j] = sum;
+                    }
+                }
+            }
+        }
+
+        // Partially dependent phase: tiles 0 .. tiles-1 of block row k, then of block column k.
+        #pragma omp target teams distribute
+        for (int t = 0; t < 2 * tiles; ++t) {
+            const int tb = t % tiles;
+            if (tb != kb) {
+                const bool row = t < tiles;
+                const int i0 = row ? k0 : tb * b;
+                const int i1 = row ? k1 : std::min(n, i0 + b);
+                const int j0 = row ? tb * b : k0;
+                const int j1 = row ? std::min(n, j0 + b) : k1;
+                #pragma omp parallel
+                for (int k = k0; k < k1; ++k) {
+                    #pragma omp for collapse(2)
+                    for (int i = i0; i < i1; ++i) {
+                        for (int j = j0; j < j1; ++j) {
+                            T sum = distance_traits<T>::add(W[static_cast<size_t>(i) * n + k], W[static_cast<size_t>(k) * n + j]);
+                            if (sum < W[static_cast<size_t>(i) * n + j]) {
+                                W[static_cast<size_t>(i) * n + j] = sum;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Independent phase: every other cell is a min-plus product of two panels that this phase leaves unchanged.
+        #pragma omp target teams distribute parallel for collapse(2)
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                if (i / b != kb && j / b != kb) {
+                    T best = W[static_cast<size_t>(i) * n + j];
+                    for (int k = k0; k < k1; ++k) {
+                        T sum = distance_traits<T>::add(W[static_cast<size_t>(i) * n + k], W[static_cast<size_t>(k) * n + j]);
+                        best = sum < best ? sum : best;
+                    }
+                    W[static_cast<size_t>(i) * n + j] = best;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+#else
+
+template <typename T>
+int offload_floyd_warshall(T *, int, int) {
+    return -1;
+}
+
+#endif
+
+#define INSTANTIATE_OFFLOAD(T) \
+    template int offload_floyd_warshall<T>(T *, int, int);
+
+INSTANTIATE_OFFLOAD(int32_t)
+INSTANTIATE_OFFLOAD(uint16_t)
+INSTANTIATE_OFFLOAD(uint8_t)
+INSTANTIATE_OFFLOAD(float)
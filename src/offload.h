@@ -0,0 +1,40 @@
+#ifndef OFFLOAD_H
+#define OFFLOAD_H
+
+/**
+ * @brief Returns whether the offload backend was compiled in (CMake option `FW_OFFLOAD`).
+ */
+bool offload_enabled();
+
+/**
+ * @brief Returns the number of OpenMP target devices visible to the process, or `0` without `FW_OFFLOAD`.
+ */
+int offload_devices();
+
+/**
+ * @brief Performs the blocked Floyd-Warshall algorithm on the default OpenMP target device (a GPU).
+ *
+ * The matrix is copied to the device once, kept resident for all `ceil(n / b)` rounds, and copied back at the
+ * end. Each round launches the three phases of `blocked_floyd_warshall` as separate device kernels:
+ * - **Dependent Phase**: one team solves the diagonal tile `W[k][k]`, one `k` step at a time.
+ * - **Partially Dependent Phase**: one team per tile of block row and block column `k`.
+ * - **Independent Phase**: one device thread per remaining cell, reading its row and column panel of round `k`.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param W A pointer to the adjacency matrix of the graph in flattened form. The matrix is updated in-place.
+ * @param n The dimension (number of vertices) of the adjacency matrix. Any value; the last tile may be ragged.
+ * @param b The size of the tiles. Any value in `[1, n]`; 16 or 32 map well onto GPU warps.
+ * @return int `1` on success, `-1` if the backend was not compiled in (see `offload_enabled`).
+ *
+ * @note Without a target device the OpenMP runtime runs the same regions on the host, which is correct but slow;
+ *       set `OMP_TARGET_OFFLOAD=MANDATORY` to make that an error instead. Each `k` step of the first two phases
+ *       relies on `W[k][k] == 0`, which holds for graphs without negative cycles.
+ */
+template <typename T>
+int offload_floyd_warshall(
+    T * W,
+    int n,
+    int b
+);
+
+#endif
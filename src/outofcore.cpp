@@ -0,0 +1,300 @@
+#include "outofcore.h"
+#include "globals.h"
+#include "kernels.h"
+#include "tile.h"
+#include "matrix_io.h"
+#include "allocator.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+int strip_rows_for_budget(int n, size_t element_size, int b, size_t budget) {
+    size_t row_bytes = static_cast<size_t>(n) * element_size;
+    size_t rows = budget / (4 * row_bytes);
+    int limit = (n + b - 1) / b * b;
+    int strip = static_cast<int>(std::min<size_t>(rows, static_cast<size_t>(limit))) / b * b;
+    return std::max(b, strip);
+}
+
+/**
+ * @brief An open matrix file, addressed by strips of `rows` rows.
+ */
+struct strip_file {
+    int fd = -1;
+    size_t data_offset = 0;
+    int n = 0;
+    int rows = 0;
+    size_t element_size = 0;
+};
+
+/**
+ * @brief Returns the number of rows of strip `s`; the last strip may be ragged.
+ */
+static int strip_extent(const strip_file & file, int s) {
+    return std::min(file.rows, file.n - s * file.rows);
+}
+
+/**
+ * @brief Moves strip `s` between `data` and the file, looping over short reads and writes.
+ * @return int Returns `1` on success, or `-1` on an I/O error (logged).
+ */
+static int transfer_strip(const strip_file & file, int s, void * data, bool write) {
+    size_t row_bytes = static_cast<size_t>(file.n) * file.element_size;
+    size_t bytes = static_cast<size_t>(strip_extent(file, s)) * row_bytes;
+    off_t offset = static_cast<off_t>(file.data_offset + static_cast<size_t>(s) * file.rows * row_bytes);
+    char * cursor = static_cast<char *>(data);
+    while (bytes > 0) {
+        ssize_t done = write ? pwrite(file.fd, cursor, bytes, offset) : pread(file.fd, cursor, bytes, offset);
+        if (done <= 0) {
+            if (done == -1 && errno == EINTR) {
+                continue;
+            }
+            spdlog::error("Cannot {} strip {} of the matrix file: {}", write ? "write" : "read", s, done == 0 ? "end of file" : strerror(errno));
+            return -1;
+        }
+        cursor += done;
+        bytes -= static_cast<size_t>(done);
+        offset += done;
+    }
+    return 1;
+}
+
+/**
+ * @brief Opens a matrix file of distance type `T` for strip I/O.
+ * @return int Returns `1` on success, or `-1` if the file is missing, malformed or of another type.
+ */
+template <typename T>
+static int open_strip_file(const std::string & path, int strip_rows, bool writable, strip_file & file) {
+    matrix_header header;
+    if (read_matrix_header(path, header) == -1) {
+        return -1;
+    }
+    if (header.dtype != static_cast<uint32_t>(dtype_of<T>())) {
+        spdlog::error("{} holds {} distances, expected {}", path, matrix_dtype_name(header.dtype), distance_traits<T>::name());
+        return -1;
+    }
+    file.fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (file.fd == -1) {
+        spdlog::error("Cannot open matrix file {}: {}", path, strerror(errno));
+        return -1;
+    }
+    file.data_offset = header.data_offset;
+    file.n = static_cast<int>(header.vertices);
+    file.rows = strip_rows;
+    file.element_size = sizeof(T);
+    return 1;
+}
+
+/**
+ * @brief Creates a matrix file of distance type `T` and opens it for strip I/O.
+ */
+template <typename T>
+static int create_strip_file(const std::string & path, int vertices, int block_length, int strip_rows, strip_file & file) {
+    mapped_matrix matrix;
+    if (create_matrix(path, dtype_of<T>(), vertices, block_length, matrix) == -1) {
+        return -1;
+    }
+    unmap_matrix(matrix);
+    return open_strip_file<T>(path, strip_rows, true, file);
+}
+
+template <typename T>
+int stream_generate_matrix(const std::string & path, int vertices, int edges, const graph_options & options, int block_length, int strip_rows) {
+    strip_file file;
+    if (create_strip_file<T>(path, vertices, block_length, strip_rows, file) == -1) {
+        return -1;
+    }
+    aligned_buffer<T> strip(static_cast<size_t>(strip_rows) * vertices);
+    int status = 1;
+    for (int s = 0; status == 1 && s * strip_rows < vertices; ++s) {
+        status = generate_graph_rows(strip.data(), vertices, edges, s * strip_rows, strip_extent(file, s), options);
+        if (status == 1) {
+            status = transfer_strip(file, s, strip.data(), true);
+        }
+    }
+    close(file.fd);
+    return status;
+}
+
+template <typename T>
+int stream_copy_matrix(const std::string & source, const std::string & destination, int block_length, int strip_rows) {
+    strip_file in;
+    if (open_strip_file<T>(source, strip_rows, false, in) == -1) {
+        return -1;
+    }
+    strip_file out;
+    if (create_strip_file<T>(destination, in.n, block_length, strip_rows, out) == -1) {
+        close(in.fd);
+        return -1;
+    }
+    aligned_buffer<T> strip(static_cast<size_t>(strip_rows) * in.n);
+    int status = 1;
+    for (int s = 0; status == 1 && s * strip_rows < in.n; ++s) {
+        status = transfer_strip(in, s, strip.data(), false);
+        if (status == 1) {
+            status = transfer_strip(out, s, strip.data(), true);
+        }
+    }
+    close(in.fd);
+    close(out.fd);
+    return status;
+}
+
+/**
+ * @brief Pivot strip of round `k`: solves `W[k][k]` and then updates the row panel `W[k][*]` from it.
+ *
+ * @param P The strip, `rows x n` with leading dimension `n`.
+ * @param k0 The first column of the diagonal block, equal to the first row of the strip.
+ * @param D Scratch for the `rows x rows` diagonal block.
+ */
+template <typename T>
+static void solve_pivot_strip(T *P, int rows, int n, int k0, int b, T *D) {
+    for (int i = 0; i < rows; ++i) {
+        std::copy(P + static_cast<size_t>(i) * n + k0, P + static_cast<size_t>(i) * n + k0 + rows, D + static_cast<size_t>(i) * rows);
+    }
+    inplace_blocked_floyd_warshall(D, rows, b);
+    for (int i = 0; i < rows; ++i) {
+        std::copy(D + static_cast<size_t>(i) * rows, D + static_cast<size_t>(i + 1) * rows, P + static_cast<size_t>(i) * n + k0);
+    }
+
+    // W[k][j] = W[k][k]* (x) W[k][j]: each thread owns a column block, so the aliased reads are its own.
+    const int blocks = (n + b - 1) / b;
+    #pragma omp parallel for schedule(dynamic)
+    for (int J = 0; J < blocks; ++J) {
+        const int j0 = J * b;
+        const int cols = std::min(b, n - j0);
+        if (j0 + cols > k0 && j0 < k0 + rows) {
+            continue;
+        }
+        for (int i0 = 0; i0 < rows; i0 += b) {
+            const int bi = std::min(b, rows - i0);
+            for (int l0 = 0; l0 < rows; l0 += b) {
+                minplus_tile(P + static_cast<size_t>(i0) * n + j0, P + static_cast<size_t>(i0) * n + k0 + l0,
+                             P + static_cast<size_t>(l0) * n + j0, bi, cols, std::min(b, rows - l0), n);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Any other strip in round `k`: updates its column block `W[i][k]` from `W[k][k]`, then every other
+ *        block from `W[i][k]` and the pivot strip.
+ *
+ * @param S The strip, `rows x n` with leading dimension `n`.
+ * @param P The solved pivot strip, `pivot_rows x n`, whose rows are vertices `k0 .. k0 + pivot_rows - 1`.
+ */
+template <typename T>
+static void update_strip(T *S, int rows, const T *P, int pivot_rows, int n, int k0, int b) {
+    // W[i][k] = W[i][k] (x) W[k][k]*: each thread owns a block of rows.
+    #pragma omp parallel for schedule(dynamic)
+    for (int i0 = 0; i0 < rows; i0 += b) {
+        const int bi = std::min(b, rows - i0);
+        T *row = S + static_cast<size_t>(i0) * n;
+        for (int l0 = 0; l0 < pivot_rows; l0 += b) {
+            for (int j0 = 0; j0 < pivot_rows; j0 += b) {
+                minplus_tile(row + k0 + j0, row + k0 + l0, P + static_cast<size_t>(l0) * n + k0 + j0,
+                             bi, std::min(b, pivot_rows - j0), std::min(b, pivot_rows - l0), n);
+            }
+        }
+    }
+
+    // W[i][j] = min(W[i][j], W[i][k] (x) W[k][j]) for the blocks outside column block k.
+    const int row_blocks = (rows + b - 1) / b;
+    const int col_blocks = (n + b - 1) / b;
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int I = 0; I < row_blocks; ++I) {
+        for (int J = 0; J < col_blocks; ++J) {
+            const int i0 = I * b;
+            const int j0 = J * b;
+            const int cols = std::min(b, n - j0);
+            if (j0 + cols > k0 && j0 < k0 + pivot_rows) {
+                continue;
+            }
+            T *row = S + static_cast<size_t>(i0) * n;
+            for (int l0 = 0; l0 < pivot_rows; l0 += b) {
+                minplus_tile(row + j0, row + k0 + l0, P + static_cast<size_t>(l0) * n + j0,
+                             std::min(b, rows - i0), cols, std::min(b, pivot_rows - l0), n);
+            }
+        }
+    }
+}
+
+template <typename T>
+int out_of_core_floyd_warshall(const std::string & path, int b, int strip_rows) {
+    // Strips must be whole blocks, so the diagonal block of a strip is a set of whole column blocks.
+    if (strip_rows % b != 0) {
+        spdlog::error("Strip of {} rows is not a multiple of the block length {}", strip_rows, b);
+        return -1;
+    }
+    strip_file file;
+    if (open_strip_file<T>(path, strip_rows, true, file) == -1) {
+        return -1;
+    }
+    const int n = file.n;
+    const int strips = (n + strip_rows - 1) / strip_rows;
+    const size_t strip_size = static_cast<size_t>(strip_rows) * n;
+    aligned_buffer<T> pivot(strip_size);
+    aligned_buffer<T> next_pivot(strip_size);
+    aligned_buffer<T> work[2] = {aligned_buffer<T>(strip_size), aligned_buffer<T>(strip_size)};
+    aligned_buffer<T> diagonal(static_cast<size_t>(strip_rows) * strip_rows);
+
+    int status = transfer_strip(file, 0, pivot.data(), false);
+    for (int k = 0; status == 1 && k < strips; ++k) {
+        const int k0 = k * strip_rows;
+        const int pivot_rows = strip_extent(file, k);
+        solve_pivot_strip(pivot.data(), pivot_rows, n, k0, b, diagonal.data());
+
+        // Streaming order: k + 1, ..., strips - 1, 0, ..., k - 1, so each round reads the file front to back.
+        // The I/O thread writes the previous buffer (the pivot, at first) and reads the next strip.
+        std::vector<int> order;
+        for (int t = 1; t < strips; ++t) {
+            order.push_back((k + t) % strips);
+        }
+        int written = k;
+        T *previous = pivot.data();
+        if (!order.empty()) {
+            status = transfer_strip(file, order[0], work[0].data(), false);
+        }
+        for (size_t t = 0; status == 1 && t < order.size(); ++t) {
+            T *current = work[t % 2].data();
+            T *spare = work[(t + 1) % 2].data();
+            int following = t + 1 < order.size() ? order[t + 1] : -1;
+            std::future<int> io = std::async(std::launch::async, [&file, written, previous, following, spare]() {
+                int result = transfer_strip(file, written, previous, true);
+                if (result == 1 && following != -1) {
+                    result = transfer_strip(file, following, spare, false);
+                }
+                return result;
+            });
+            update_strip(current, strip_extent(file, order[t]), pivot.data(), pivot_rows, n, k0, b);
+            if (order[t] == k + 1) {
+                std::copy(current, current + strip_size, next_pivot.data());
+            }
+            status = io.get();
+            written = order[t];
+            previous = current;
+        }
+        if (status == 1) {
+            status = transfer_strip(file, written, previous, true);
+        }
+        std::swap(pivot, next_pivot);
+    }
+    close(file.fd);
+    return status;
+}
+
+#define INSTANTIATE_OUT_OF_CORE(T) \
+    template int stream_generate_matrix<T>(const std::string &, int, int, const graph_options &, int, int); \
+    template int stream_copy_matrix<T>(const std::string &, const std::string &, int, int); \
+    template int out_of_core_floyd_warshall<T>(const std::string &, int, int);
+
+INSTANTIATE_OUT_OF_CORE(int32_t)
+INSTANTIATE_OUT_OF_CORE(uint16_t)
+INSTANTIATE_OUT_OF_CORE(uint8_t)
+INSTANTIATE_OUT_OF_CORE(float)
@@ -0,0 +1,95 @@
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+#include "graph.h"
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Returns the number of rows per strip that keeps the out-of-core working set within `budget` bytes.
+ *
+ * @param n The dimension (number of vertices) of the matrix.
+ * @param element_size The size of one distance in bytes.
+ * @param b The block length of the in-memory tile updates; strips are a multiple of it.
+ * @param budget The memory budget in bytes for the four resident strips.
+ * @return int Rows per strip: a multiple of `b`, at least `b`, at most `n` rounded up to a multiple of `b`.
+ */
+int strip_rows_for_budget(
+    int n,
+    size_t element_size,
+    int b,
+    size_t budget
+);
+
+/**
+ * @brief Writes the graph `generate_linear_graph` would produce into a new matrix file, one strip of rows at a time.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @param path The matrix file to create (see matrix_io.h); an existing file is replaced.
+ * @param vertices The number of vertices in the graph.
+ * @param edges The number of directed edges in the graph.
+ * @param options Topology, weight distribution and seed (see `graph_options`).
+ * @param block_length Block length recorded in the header.
+ * @param strip_rows Rows generated per write; memory use is `strip_rows * vertices` elements.
+ * @return int Returns `1` on success, or `-1` if the edges are impossible or the file cannot be written.
+ */
+template <typename T>
+int stream_generate_matrix(
+    const std::string & path,
+    int vertices,
+    int edges,
+    const graph_options & options,
+    int block_length,
+    int strip_rows
+);
+
+/**
+ * @brief Copies the matrix file `source` to a new file `destination`, one strip of rows at a time.
+ *
+ * @tparam T The distance type of `source`; checked against its header.
+ * @return int Returns `1` on success, or `-1` on a type mismatch or an I/O error.
+ */
+template <typename T>
+int stream_copy_matrix(
+    const std::string & source,
+    const std::string & destination,
+    int block_length,
+    int strip_rows
+);
+
+/**
+ * @brief Performs the blocked Floyd-Warshall algorithm on a matrix file in place, holding only four strips of
+ *        rows in memory, for matrices larger than RAM.
+ *
+ * The matrix is cut into `K = ceil(n / strip_rows)` strips of whole rows, each one contiguous range of the file.
+ * Round `k` treats strip `k` as the pivot:
+ * - **Pivot Strip**: Strip `k` solves its diagonal block `W[k][k]` with `inplace_blocked_floyd_warshall` and
+ *   then updates its row panel `W[k][*]` from it.
+ * - **Other Strips**: Strips `k + 1, ..., K - 1, 0, ..., k - 1` are streamed through memory. Each updates its
+ *   own column block `W[i][k]` from `W[k][k]`, then all its other blocks from `W[i][k]` and the pivot strip,
+ *   and is written back.
+ *
+ * @tparam T The distance type of the file; checked against its header.
+ * @param path The matrix file (see matrix_io.h), solved in place.
+ * @param b The block length of the in-memory tile updates (`minplus_tile`). Any value in `[1, n]`.
+ * @param strip_rows Rows per strip, a multiple of `b`, e.g. from `strip_rows_for_budget`.
+ * @return int Returns `1` on success, or `-1` on a type mismatch, a strip that is not whole blocks, or an I/O error.
+ *
+ * @details
+ * - A background thread writes the previous strip and reads the next one while the current strip is
+ *   updated, so I/O overlaps computation. Each round reads the file front to back, with a single
+ *   wrap-around after the last strip.
+ * - Strip `k + 1` is the first strip updated in round `k`; it is kept as the next pivot instead of being
+ *   read again, so each round reads `K - 1` strips and writes `K`.
+ * - Memory use is four strips: the pivot, the next pivot, and two buffers alternating between I/O and compute.
+ * - Every byte of the matrix is read and written once per round, against `2 * strip_rows * n^2` operations
+ *   per round, so larger strips lower the I/O share.
+ */
+template <typename T>
+int out_of_core_floyd_warshall(
+    const std::string & path,
+    int b,
+    int strip_rows
+);
+
+#endif
@@ -0,0 +1,61 @@
+#include "paths.h"
+#include "globals.h"
+#include <cstddef>
+
+int next_hop_bytes(int vertices) {
+    if (vertices < std::numeric_limits<uint8_t>::max()) {
+        return 1;
+    }
+    if (vertices < std::numeric_limits<uint16_t>::max()) {
+        return 2;
+    }
+    return 4;
+}
+
+template <typename T, typename I>
+void init_next_hop(const T * graph, I * next, int vertices)
+{
+    const T inf = distance_traits<T>::inf();
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < vertices; i++) {
+        const T * row = graph + static_cast<size_t>(i) * vertices;
+        I * next_row = next + static_cast<size_t>(i) * vertices;
+        for (int j = 0; j < vertices; j++) {
+            next_row[j] = (row[j] == inf && j != i) ? no_next_hop<I>() : static_cast<I>(j);
+        }
+    }
+}
+
+template <typename I>
+std::vector<int> reconstruct_path(const I * next, int vertices, int u, int v)
+{
+    std::vector<int> path;
+    if (next[static_cast<size_t>(u) * vertices + v] == no_next_hop<I>()) {
+        return path;
+    }
+    path.push_back(u);
+    while (u != v) {
+        u = next[static_cast<size_t>(u) * vertices + v];
+        path.push_back(u);
+        if (static_cast<int>(path.size()) > vertices) {
+            path.clear();
+            break;
+        }
+    }
+    return path;
+}
+
+#define INSTANTIATE_NEXT_HOP(T, I) \
+    template void init_next_hop<T, I>(const T *, I *, int);
+
+#define INSTANTIATE_PATHS(I) \
+    INSTANTIATE_NEXT_HOP(int32_t, I) \
+    INSTANTIATE_NEXT_HOP(uint16_t, I) \
+    INSTANTIATE_NEXT_HOP(uint8_t, I) \
+    INSTANTIATE_NEXT_HOP(float, I) \
+    template std::vector<int> reconstruct_path<I>(const I *, int, int, int);
+
+INSTANTIATE_PATHS(uint8_t)
+INSTANTIATE_PATHS(uint16_t)
+INSTANTIATE_PATHS(uint32_t)
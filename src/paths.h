@@ -0,0 +1,70 @@
+#ifndef PATHS_H
+#define PATHS_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Marker stored in a next-hop matrix for pairs with no path: the largest value of the index type `I`.
+ * 
+ * @tparam I The index type of the next-hop matrix: `uint8_t`, `uint16_t` or `uint32_t`.
+ */
+template <typename I>
+constexpr I no_next_hop() {
+    return std::numeric_limits<I>::max();
+}
+
+/**
+ * @brief Returns the size in bytes of the narrowest next-hop index type that can address `vertices` vertices.
+ * 
+ * @param vertices The number of vertices in the graph.
+ * @return int `1` (`uint8_t`) for fewer than 255 vertices, `2` (`uint16_t`) for fewer than 65535, `4` (`uint32_t`)
+ *             otherwise. The largest value of each type is reserved for `no_next_hop`.
+ */
+int next_hop_bytes(
+    int vertices
+);
+
+/**
+ * @brief Fills the next-hop matrix for a graph that has not been solved yet.
+ * 
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ * @tparam I The index type of the next-hop matrix (see `next_hop_bytes`).
+ * @param graph A pointer to the adjacency matrix in flattened form.
+ * @param next A pointer to the `vertices x vertices` next-hop matrix, same layout as `graph`.
+ * @param vertices The number of vertices in the graph.
+ * 
+ * @details `next[i][j]` becomes `j` for every edge and for `i == j`, and `no_next_hop<I>()` where
+ *          `graph[i][j]` is `distance_traits<T>::inf()`. Rows are filled in parallel.
+ */
+template <typename T, typename I>
+void init_next_hop(
+    const T * graph,
+    I * next,
+    int vertices
+);
+
+/**
+ * @brief Recovers the shortest route from `u` to `v` out of a solved next-hop matrix.
+ * 
+ * @tparam I The index type of the next-hop matrix (see `next_hop_bytes`).
+ * @param next A pointer to the next-hop matrix filled by one of the path-tracking kernels.
+ * @param vertices The number of vertices in the graph.
+ * @param u The source vertex.
+ * @param v The destination vertex.
+ * @return std::vector<int> The vertices of the route, `u` first and `v` last; `{u}` if `u == v`,
+ *                          and empty if `v` is unreachable from `u`.
+ * 
+ * @details Follows `u = next[u][v]` until `v` is reached, one read per hop, so the cost is the length of the route.
+ *          A route longer than `vertices` hops cannot be a shortest path and is reported as empty.
+ */
+template <typename I>
+std::vector<int> reconstruct_path(
+    const I * next,
+    int vertices,
+    int u,
+    int v
+);
+
+#endif
@@ -0,0 +1,511 @@
+#include "query.h"
+#include "paths.h"
+#include "tile.h"
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QUERY_X86 1
+#include <immintrin.h>
+#endif
+
+template <typename T>
+query_engine<T>::query_engine(const T *W, int n) : W_(W), n_(n) {}
+
+template <typename T>
+template <typename I>
+void query_engine<T>::set_next_hops(const I *next) {
+    next_ = next;
+    next_bytes_ = sizeof(I);
+}
+
+template <typename T>
+T query_engine<T>::distance(int u, int v) const {
+    return W_[static_cast<size_t>(u) * n_ + v];
+}
+
+template <typename T>
+const T * query_engine<T>::row(int u) const {
+    return W_ + static_cast<size_t>(u) * n_;
+}
+
+template <typename T>
+std::vector<int> query_engine<T>::path(int u, int v) const {
+    switch (next_bytes_) {
+        case 1:
+            return reconstruct_path(static_cast<const uint8_t *>(next_), n_, u, v);
+        case 2:
+            return reconstruct_path(static_cast<const uint16_t *>(next_), n_, u, v);
+        case 4:
+            return reconstruct_path(static_cast<const uint32_t *>(next_), n_, u, v);
+        default:
+            return {};
+    }
+}
+
+template <typename T>
+bool query_engine<T>::has_paths() const {
+    return next_ != nullptr;
+}
+
+template <typename T>
+int query_engine<T>::vertices() const {
+    return n_;
+}
+
+#ifdef QUERY_X86
+/**
+ * @brief Bit offsets of elements `u * n + v` within their aligned 32-bit words, for the narrow types. Only the two
+ *        lowest bits of the byte offset matter, so 32-bit wrapping arithmetic is exact.
+ */
+template <typename T>
+__attribute__((target("avx2"), always_inline)) static inline __m128i word_shifts(__m128i u, __m128i v, int n) {
+    const int log_size = sizeof(T) == 2 ? 1 : 0;
+    __m128i offset = _mm_slli_epi32(_mm_add_epi32(_mm_mullo_epi32(u, _mm_set1_epi32(n)), v), log_size);
+    return _mm_slli_epi32(_mm_and_si128(offset, _mm_set1_epi32(3)), 3);
+}
+
+/**
+ * @brief AVX2 `query_engine::distances`, 4 pairs per gather. Returns the number of pairs done.
+ */
+template <typename T>
+__attribute__((target("avx2"))) static int gather_avx2(const T *W, int n, const int *s, const int *t, int count, T *out) {
+    const __m256i vn = _mm256_set1_epi64x(n);
+    const int *base = reinterpret_cast<const int *>(W);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + x));
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(t + x));
+        __m256i index = _mm256_add_epi64(_mm256_mul_epu32(_mm256_cvtepi32_epi64(u), vn), _mm256_cvtepi32_epi64(v));
+        if constexpr (sizeof(T) == 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm256_i64gather_epi32(base, index, 4));
+        }
+        else {
+            __m256i word = _mm256_andnot_si256(
+                _mm256_set1_epi64x(3), _mm256_slli_epi64(index, sizeof(T) == 2 ? 1 : 0)
+            );
+            __m128i values = _mm_srlv_epi32(_mm256_i64gather_epi32(base, word, 1), word_shifts<T>(u, v, n));
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), values);
+            for (int l = 0; l < 4; ++l) {
+                out[x + l] = static_cast<T>(lanes[l]);
+            }
+        }
+    }
+    return x;
+}
+
+/**
+ * @brief AVX-512 `query_engine::distances`, 8 pairs per gather. Returns the number of pairs done.
+ */
+template <typename T>
+__attribute__((target("avx512f"))) static int gather_avx512(const T *W, int n, const int *s, const int *t, int count, T *out) {
+    const __m512i vn = _mm512_set1_epi64(n);
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + x));
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(t + x));
+        __m512i index = _mm512_add_epi64(_mm512_mul_epu32(_mm512_cvtepi32_epi64(u), vn), _mm512_cvtepi32_epi64(v));
+        if constexpr (sizeof(T) == 4) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm512_i64gather_epi32(index, W, 4));
+        }
+        else {
+            __m512i word = _mm512_andnot_si512(
+                _mm512_set1_epi64(3), _mm512_slli_epi64(index, sizeof(T) == 2 ? 1 : 0)
+            );
+            __m128i low = word_shifts<T>(_mm256_castsi256_si128(u), _mm256_castsi256_si128(v), n);
+            __m128i high = word_shifts<T>(_mm256_extracti128_si256(u, 1), _mm256_extracti128_si256(v, 1), n);
+            __m256i values = _mm256_srlv_epi32(
+                _mm512_i64gather_epi32(word, W, 1), _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1)
+            );
+            alignas(32) uint32_t lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), values);
+            for (int l = 0; l < 8; ++l) {
+                out[x + l] = static_cast<T>(lanes[l]);
+            }
+        }
+    }
+    return x;
+}
+#endif
+
+template <typename T>
+void query_engine<T>::distances(const int *sources, const int *targets, int count, T *out) const {
+    int done = 0;
+#ifdef QUERY_X86
+    switch (get_tile_isa()) {
+        case tile_isa::avx512:
+            done = gather_avx512(W_, n_, sources, targets, count, out);
+            break;
+        case tile_isa::avx2:
+            done = gather_avx2(W_, n_, sources, targets, count, out);
+            break;
+        default:
+            break;
+    }
+#endif
+    for (int x = done; x < count; ++x) {
+        out[x] = distance(sources[x], targets[x]);
+    }
+}
+
+/**
+ * @brief Set by `SIGINT` and `SIGTERM` while `serve_queries` runs.
+ */
+static volatile std::sig_atomic_t stop_signal = 0;
+
+static void handle_stop_signal(int) {
+    stop_signal = 1;
+}
+
+/**
+ * @brief Appends a distance to a response, `INF` for no path; `uint8_t` as a number, not a character.
+ */
+template <typename T>
+static void append_distance(fmt::memory_buffer &out, T value) {
+    if (value == distance_traits<T>::inf()) {
+        fmt::format_to(std::back_inserter(out), "INF");
+    }
+    else if constexpr (sizeof(T) < sizeof(int)) {
+        fmt::format_to(std::back_inserter(out), "{}", static_cast<int>(value));
+    }
+    else {
+        fmt::format_to(std::back_inserter(out), "{}", value);
+    }
+}
+
+/**
+ * @brief Parses a vertex token, which must be a decimal integer in `[0, n)`.
+ */
+static bool parse_vertex(const char *token, int n, int &vertex) {
+    char *end = nullptr;
+    errno = 0;
+    long value = std::strtol(token, &end, 10);
+    if (errno != 0 || end == token || *end != '\0' || value < 0 || value >= n) {
+        return false;
+    }
+    vertex = static_cast<int>(value);
+    return true;
+}
+
+/**
+ * @brief What a connection should do after a request.
+ */
+enum class request_result {
+    keep,       // Read the next request
+    close,      // `quit`: close this connection
+    shutdown,   // `shutdown`: stop the server
+};
+
+/**
+ * @brief Answers one request line into `out`, newline included (see `serve_queries` for the protocol).
+ */
+template <typename T>
+static request_result answer_request(
+    const query_engine<T> &engine,
+    std::string &line,
+    fmt::memory_buffer &out,
+    std::vector<int> &sources,
+    std::vector<int> &targets,
+    std::vector<T> &batch
+) {
+    const int n = engine.vertices();
+    // strtok_r: every worker tokenizes its own lines concurrently.
+    std::vector<char *> tokens;
+    char *state = nullptr;
+    for (char *token = strtok_r(line.data(), " \t\r", &state); token; token = strtok_r(nullptr, " \t\r", &state)) {
+        tokens.push_back(token);
+    }
+    auto inserter = std::back_inserter(out);
+    if (tokens.empty()) {
+        fmt::format_to(inserter, "ERR empty request\n");
+        return request_result::keep;
+    }
+    const std::string command = tokens[0];
+    const size_t arguments = tokens.size() - 1;
+    int u, v;
+    if (command == "dist" && arguments == 2) {
+        if (!parse_vertex(tokens[1], n, u) || !parse_vertex(tokens[2], n, v)) {
+            fmt::format_to(inserter, "ERR vertex out of range [0, {})\n", n);
+            return request_result::keep;
+        }
+        append_distance(out, engine.distance(u, v));
+    }
+    else if (command == "dists" && arguments > 0 && arguments % 2 == 0) {
+        const int count = static_cast<int>(arguments / 2);
+        sources.resize(count);
+        targets.resize(count);
+        batch.resize(count);
+        for (int x = 0; x < count; ++x) {
+            if (!parse_vertex(tokens[1 + 2 * x], n, sources[x]) || !parse_vertex(tokens[2 + 2 * x], n, targets[x])) {
+                fmt::format_to(inserter, "ERR vertex out of range [0, {}) in pair {}\n", n, x);
+                return request_result::keep;
+            }
+        }
+        engine.distances(sources.data(), targets.data(), count, batch.data());
+        for (int x = 0; x < count; ++x) {
+            if (x > 0) {
+                out.push_back(' ');
+            }
+            append_distance(out, batch[x]);
+        }
+    }
+    else if (command == "row" && arguments == 1) {
+        if (!parse_vertex(tokens[1], n, u)) {
+            fmt::format_to(inserter, "ERR vertex out of range [0, {})\n", n);
+            return request_result::keep;
+        }
+        const T *row = engine.row(u);
+        for (int j = 0; j < n; ++j) {
+            if (j > 0) {
+                out.push_back(' ');
+            }
+            append_distance(out, row[j]);
+        }
+    }
+    else if (command == "path" && arguments == 2) {
+        if (!engine.has_paths()) {
+            fmt::format_to(inserter, "ERR no next hops: solve with --paths\n");
+            return request_result::keep;
+        }
+        if (!parse_vertex(tokens[1], n, u) || !parse_vertex(tokens[2], n, v)) {
+            fmt::format_to(inserter, "ERR vertex out of range [0, {})\n", n);
+            return request_result::keep;
+        }
+        std::vector<int> route = engine.path(u, v);
+        if (route.empty()) {
+            fmt::format_to(inserter, "unreachable");
+        }
+        else {
+            fmt::format_to(inserter, "{}", fmt::join(route, " "));
+        }
+    }
+    else if (command == "info" && arguments == 0) {
+        fmt::format_to(
+            inserter, "vertices {} dtype {} paths {}", n, distance_traits<T>::name(), engine.has_paths() ? 1 : 0
+        );
+    }
+    else if (command == "quit" && arguments == 0) {
+        return request_result::close;
+    }
+    else if (command == "shutdown" && arguments == 0) {
+        fmt::format_to(inserter, "OK\n");
+        return request_result::shutdown;
+    }
+    else {
+        fmt::format_to(inserter, "ERR unknown request: {}\n", command);
+        return request_result::keep;
+    }
+    out.push_back('\n');
+    return request_result::keep;
+}
+
+/**
+ * @brief Writes all of `data`, without `SIGPIPE` if the client has gone away.
+ */
+static bool send_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * @brief Shared state of the `serve_queries` workers.
+ */
+struct server_state {
+    int listen_fd;
+    const std::atomic<bool> *stop;
+    std::atomic<bool> shutdown{false};
+
+    bool stopping() const {
+        return shutdown.load(std::memory_order_relaxed) || stop_signal
+            || (stop && stop->load(std::memory_order_relaxed));
+    }
+};
+
+/**
+ * @brief Longest request line a connection buffers: room for a `dists` batch of about 64k pairs.
+ */
+static const size_t max_request_length = 1 << 20;
+
+/**
+ * @brief Serves one connection until the client closes it, sends `quit` or `shutdown`, or the server stops.
+ */
+template <typename T>
+static void serve_connection(const query_engine<T> &engine, server_state &state, int fd) {
+    std::string pending, line;
+    fmt::memory_buffer out;
+    std::vector<int> sources, targets;
+    std::vector<T> batch;
+    char buffer[65536];
+    bool discarding = false;    // Skipping the rest of a line longer than `max_request_length`
+    while (!state.stopping()) {
+        pollfd client = {fd, POLLIN, 0};
+        int ready = poll(&client, 1, 100);
+        if (ready < 0 && errno != EINTR) {
+            return;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return;
+        }
+        const char *data = buffer;
+        size_t size = static_cast<size_t>(received);
+        if (discarding) {
+            const char *newline = static_cast<const char *>(std::memchr(data, '\n', size));
+            if (newline == nullptr) {
+                continue;
+            }
+            size -= static_cast<size_t>(newline + 1 - data);
+            data = newline + 1;
+            discarding = false;
+        }
+        pending.append(data, size);
+        // Answer every complete line received so far, as one write.
+        size_t start = 0, end;
+        out.clear();
+        request_result result = request_result::keep;
+        while (result == request_result::keep && (end = pending.find('\n', start)) != std::string::npos) {
+            line.assign(pending, start, end - start);
+            start = end + 1;
+            result = answer_request(engine, line, out, sources, targets, batch);
+        }
+        pending.erase(0, start);
+        if (result == request_result::keep && pending.size() > max_request_length) {
+            fmt::format_to(std::back_inserter(out), "ERR request longer than {} bytes\n", max_request_length);
+            pending.clear();
+            discarding = true;
+        }
+        if (!send_all(fd, out.data(), out.size()) || result == request_result::close) {
+            return;
+        }
+        if (result == request_result::shutdown) {
+            state.shutdown.store(true, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief A worker: accepts connections one at a time until the server stops. The listening socket is
+ *        non-blocking, so workers woken for the same connection that lose the race go back to polling.
+ */
+template <typename T>
+static void serve_worker(const query_engine<T> &engine, server_state &state) {
+    while (!state.stopping()) {
+        pollfd listener = {state.listen_fd, POLLIN, 0};
+        if (poll(&listener, 1, 100) <= 0) {
+            continue;
+        }
+        int fd = accept(state.listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        serve_connection(engine, state, fd);
+        close(fd);
+    }
+}
+
+template <typename T>
+int serve_queries(
+    const query_engine<T> &engine,
+    const std::string &socket_path,
+    int threads,
+    const std::atomic<bool> *stop,
+    std::atomic<bool> *ready
+) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        spdlog::error("Socket path must have 1 to {} characters: {}", sizeof(address.sun_path) - 1, socket_path);
+        return -1;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+    // Replace a socket left behind by a previous server, but never any other file.
+    struct stat existing;
+    if (stat(socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            spdlog::error("{} exists and is not a socket", socket_path);
+            return -1;
+        }
+        unlink(socket_path.c_str());
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        spdlog::error("Cannot create socket: {}", strerror(errno));
+        return -1;
+    }
+    if (bind(listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || listen(listen_fd, 128) != 0) {
+        spdlog::error("Cannot listen on {}: {}", socket_path, strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+    fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL) | O_NONBLOCK);
+
+    stop_signal = 0;
+    auto previous_int = std::signal(SIGINT, handle_stop_signal);
+    auto previous_term = std::signal(SIGTERM, handle_stop_signal);
+
+    server_state state{listen_fd, stop};
+    if (ready) {
+        ready->store(true);
+    }
+    std::vector<std::thread> workers;
+    for (int t = 1; t < std::max(threads, 1); ++t) {
+        workers.emplace_back(serve_worker<T>, std::cref(engine), std::ref(state));
+    }
+    serve_worker(engine, state);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    std::signal(SIGINT, previous_int);
+    std::signal(SIGTERM, previous_term);
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    return 1;
+}
+
+#define INSTANTIATE_QUERY(T) \
+    template class query_engine<T>; \
+    template void query_engine<T>::set_next_hops<uint8_t>(const uint8_t *); \
+    template void query_engine<T>::set_next_hops<uint16_t>(const uint16_t *); \
+    template void query_engine<T>::set_next_hops<uint32_t>(const uint32_t *); \
+    template int serve_queries<T>( \
+        const query_engine<T> &, const std::string &, int, const std::atomic<bool> *, std::atomic<bool> * \
+    );
+
+INSTANTIATE_QUERY(int32_t)
+INSTANTIATE_QUERY(uint16_t)
+INSTANTIATE_QUERY(uint8_t)
+INSTANTIATE_QUERY(float)
@@ -0,0 +1,116 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "globals.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Read-only lookups into a solved `n x n` distance matrix, and optionally its next-hop matrix, for the query
+ *        server (`serve_queries`) and library users that keep a solution resident.
+ *
+ * The engine only holds pointers: the matrices stay wherever they were solved or mapped (e.g. a `--output` file
+ * mapped with `map_matrix`), and must outlive the engine. Nothing is written after construction, so any number of
+ * threads may query one engine concurrently.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ *
+ * @note Vertex indices are not checked; callers validate them against `vertices()` (as `serve_queries` does).
+ */
+template <typename T>
+class query_engine {
+public:
+    /**
+     * @param W A pointer to the solved matrix in flattened form.
+     * @param n The number of vertices.
+     */
+    query_engine(const T * W, int n);
+
+    /**
+     * @brief Attaches the next-hop matrix of the same solve, so `path` can answer (see paths.h).
+     *
+     * @tparam I The next-hop index type: `uint8_t`, `uint16_t` or `uint32_t` (see `next_hop_bytes`).
+     */
+    template <typename I>
+    void set_next_hops(const I * next);
+
+    /**
+     * @brief Returns the distance from `u` to `v`; `distance_traits<T>::inf()` if `v` is unreachable.
+     */
+    T distance(int u, int v) const;
+
+    /**
+     * @brief Looks up `count` pairs at once: `out[x]` is the distance from `sources[x]` to `targets[x]`.
+     *
+     * @details With AVX-512 or AVX2 (see `get_tile_isa`), 8 or 4 pairs per step: their 64-bit element offsets
+     *          `u * n + v` are computed in vector registers and loaded with one gather, so the cache misses of
+     *          independent lookups overlap. `uint16_t` and `uint8_t` gather the aligned 32-bit word holding each
+     *          element and shift it out; such a word never crosses a page, so it is always mapped.
+     */
+    void distances(const int * sources, const int * targets, int count, T * out) const;
+
+    /**
+     * @brief Returns row `u` of the matrix: the distances from `u` to every vertex, without a copy.
+     */
+    const T * row(int u) const;
+
+    /**
+     * @brief Returns the shortest route from `u` to `v`, `u` first (see `reconstruct_path`); empty if `v` is
+     *        unreachable or no next-hop matrix is attached.
+     */
+    std::vector<int> path(int u, int v) const;
+
+    /**
+     * @brief Returns whether a next-hop matrix is attached.
+     */
+    bool has_paths() const;
+
+    /**
+     * @brief Returns the number of vertices.
+     */
+    int vertices() const;
+
+private:
+    const T * W_;
+    int n_;
+    const void * next_ = nullptr;
+    int next_bytes_ = 0;
+};
+
+/**
+ * @brief Serves queries against `engine` on a Unix domain socket until a client sends `shutdown`, `stop` becomes
+ *        `true`, or the process receives `SIGINT` or `SIGTERM`.
+ *
+ * The protocol is one request per line and one response line per request, so a session can be driven with
+ * `nc -U <socket>` or `socat`:
+ * - `dist <u> <v>`: The distance from `u` to `v`, or `INF`.
+ * - `dists <u1> <v1> <u2> <v2> ...`: The distances of all pairs, space separated, looked up as one
+ *   `query_engine::distances` batch.
+ * - `row <u>`: The `n` distances from `u`, space separated.
+ * - `path <u> <v>`: The vertices of a shortest route, `unreachable`, or an error without next hops.
+ * - `info`: `vertices <n> dtype <name> paths <0|1>`.
+ * - `quit`: Closes the connection. `shutdown`: Stops the server.
+ *
+ * Malformed requests and vertices out of range are answered with a line starting with `ERR`, as is a request line
+ * longer than 1 MiB, whose rest is skipped.
+ *
+ * @param engine The matrix to answer from.
+ * @param socket_path Path of the socket; an existing socket file there is replaced, and the file is removed on return.
+ * @param threads Worker threads. Each worker serves one connection at a time, so up to `threads` clients are
+ *                served concurrently and further ones wait in the listen backlog.
+ * @param stop Optional flag that stops the server when set, checked every 100 ms.
+ * @param ready Optional flag set once the socket is listening.
+ * @return int Returns `1` after a clean shutdown, or `-1` if the socket cannot be created (logged with `spdlog`).
+ */
+template <typename T>
+int serve_queries(
+    const query_engine<T> & engine,
+    const std::string & socket_path,
+    int threads,
+    const std::atomic<bool> * stop = nullptr,
+    std::atomic<bool> * ready = nullptr
+);
+
+#endif
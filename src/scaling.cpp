@@ -0,0 +1,235 @@
+#include "scaling.h"
+#include "allocator.h"
+#include "globals.h"
+#include "plf_nanotimer.h"
+#include "tile.h"
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <omp.h>
+
+/**
+ * @brief Best STREAM triad bandwidth of five runs, in bytes per second.
+ */
+static double triad_bandwidth(int threads, size_t bytes)
+{
+    const long count = static_cast<long>(std::max<size_t>(bytes / sizeof(double), 1));
+    aligned_buffer<double> a(count), b(count), c(count);
+    #pragma omp parallel for num_threads(threads)
+    for (long i = 0; i < count; ++i) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    double * pa = a.data();
+    const double * pb = b.data();
+    const double * pc = c.data();
+    const double scalar = 3.0;
+    double best = 0.0;
+    for (int run = 0; run < 5; ++run) {
+        plf::nanotimer timer;
+        timer.start();
+        #pragma omp parallel for num_threads(threads)
+        for (long i = 0; i < count; ++i) {
+            pa[i] = pb[i] + scalar * pc[i];
+        }
+        double ns = timer.get_elapsed_ns();
+        best = std::max(best, 3.0 * count * sizeof(double) / (ns * 1e-9));
+    }
+    return best;
+}
+
+/**
+ * @brief Best min-plus rate of five runs of `minplus_tile` on private `64 x 64` tiles, in operations per second.
+ */
+template <typename T>
+static double tile_compute(int threads)
+{
+    const int b = 64;
+    const int calls = 200;
+    double best = 0.0;
+    plf::nanotimer timer;
+    #pragma omp parallel num_threads(threads)
+    {
+        // Finite weights, so no row of A is skipped as unreachable.
+        aligned_buffer<T> tiles(3 * b * b);
+        for (int x = 0; x < 3 * b * b; ++x) {
+            tiles[x] = static_cast<T>(1 + x % 7);
+        }
+        T * C = tiles.data();
+        const T * A = C + b * b;
+        const T * B = A + b * b;
+        for (int run = 0; run < 5; ++run) {
+            #pragma omp barrier
+            #pragma omp single
+            timer.start();
+            for (int call = 0; call < calls; ++call) {
+                minplus_tile(C, A, B, b, b);
+            }
+            #pragma omp barrier
+            #pragma omp single
+            {
+                double ns = timer.get_elapsed_ns();
+                best = std::max(best, 2.0 * b * b * b * calls * omp_get_num_threads() / (ns * 1e-9));
+            }
+        }
+    }
+    return best;
+}
+
+template <typename T>
+roofline measure_roofline(int threads, size_t bytes)
+{
+    return {threads, triad_bandwidth(threads, bytes), tile_compute<T>(threads)};
+}
+
+double matrix_traffic(int n, int b, size_t element_size)
+{
+    double matrix = 2.0 * n * n * element_size;
+    double rounds = b > 0 ? (n + b - 1) / b : n;
+    return rounds * matrix;
+}
+
+int weak_scaling_vertices(int base_vertices, int base_threads, int threads)
+{
+    return static_cast<int>(std::lround(base_vertices * std::cbrt(static_cast<double>(threads) / base_threads)));
+}
+
+void compute_scaling(std::vector<scaling_point> & points, const std::vector<roofline> & rooflines)
+{
+    for (scaling_point & point : points) {
+        double seconds = point.median_ns * 1e-9;
+        point.operations = 2.0 * point.vertices * point.vertices * point.vertices / seconds;
+        point.bandwidth = point.bytes / seconds;
+        point.intensity = point.bytes > 0 ? 2.0 * point.vertices * point.vertices * point.vertices / point.bytes : 0.0;
+
+        // The base run: fewest threads of the same kernel, block length and series (and size, for strong scaling).
+        const scaling_point * base = nullptr;
+        for (const scaling_point & other : points) {
+            bool same = other.kernel == point.kernel && other.weak == point.weak && other.block_length == point.block_length
+                && (point.weak || other.vertices == point.vertices);
+            if (same && (base == nullptr || other.threads < base->threads)) {
+                base = &other;
+            }
+        }
+        point.speedup = 0.0;
+        point.efficiency = 0.0;
+        if (base != nullptr && point.median_ns > 0) {
+            double ratio = base->median_ns / point.median_ns;
+            double scale = static_cast<double>(point.threads) / base->threads;
+            point.speedup = point.weak ? ratio * scale : ratio;
+            point.efficiency = point.weak ? ratio : ratio / scale;
+        }
+
+        point.roof = 0.0;
+        point.roof_fraction = 0.0;
+        point.memory_bound = false;
+        for (const roofline & roof : rooflines) {
+            if (roof.threads == point.threads) {
+                double slope = point.intensity * roof.bandwidth;
+                point.memory_bound = slope < roof.compute;
+                point.roof = std::min(slope, roof.compute);
+                point.roof_fraction = point.roof > 0 ? point.operations / point.roof : 0.0;
+            }
+        }
+    }
+}
+
+void print_scaling(const std::vector<scaling_point> & points, const std::vector<roofline> & rooflines)
+{
+    for (const roofline & roof : rooflines) {
+        fmt::print(
+            "Roofline, {} threads: triad bandwidth {:.2f} GB/s, min-plus tile compute {:.2f} Gop/s, ridge {:.2f} op/B\n",
+            roof.threads,
+            roof.bandwidth * 1e-9,
+            roof.compute * 1e-9,
+            roof.bandwidth > 0 ? roof.compute / roof.bandwidth : 0.0
+        );
+    }
+    for (const scaling_point & p : points) {
+        fmt::print(
+            "{} {} n {} b {} threads {}: median {:.0f} ns, speedup {:.2f}, efficiency {:.2f}, {:.2f} Gop/s, {:.2f} GB/s, "
+            "{:.2f} op/B, {:.0f}% of the {} roof\n",
+            p.kernel,
+            p.weak ? "weak" : "strong",
+            p.vertices,
+            p.block_length,
+            p.threads,
+            p.median_ns,
+            p.speedup,
+            p.efficiency,
+            p.operations * 1e-9,
+            p.bandwidth * 1e-9,
+            p.intensity,
+            100.0 * p.roof_fraction,
+            p.memory_bound ? "memory" : "compute"
+        );
+    }
+}
+
+int write_scaling(
+    const std::string & path,
+    const std::string & format,
+    const std::vector<scaling_point> & points,
+    const std::vector<roofline> & rooflines
+)
+{
+    if (format != "csv" && format != "json") {
+        spdlog::error("Unknown scaling format {}", format);
+        return -1;
+    }
+    std::FILE * file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        spdlog::error("Cannot write scaling results to {}", path);
+        return -1;
+    }
+
+    if (format == "csv") {
+        fmt::print(file, "threads,bandwidth,compute\n");
+        for (const roofline & roof : rooflines) {
+            fmt::print(file, "{},{:.0f},{:.0f}\n", roof.threads, roof.bandwidth, roof.compute);
+        }
+        fmt::print(file, "\nkernel,scaling,vertices,block_length,threads,samples,median_ns,bytes,speedup,efficiency,"
+            "operations,bandwidth,intensity,roof,roof_fraction,bound\n");
+        for (const scaling_point & p : points) {
+            fmt::print(file, "{},{},{},{},{},{},{:.0f},{:.0f},{:.4f},{:.4f},{:.0f},{:.0f},{:.4f},{:.0f},{:.4f},{}\n",
+                p.kernel, p.weak ? "weak" : "strong", p.vertices, p.block_length, p.threads, p.samples, p.median_ns, p.bytes,
+                p.speedup, p.efficiency, p.operations, p.bandwidth, p.intensity, p.roof, p.roof_fraction,
+                p.memory_bound ? "memory" : "compute");
+        }
+    }
+    else {
+        fmt::print(file, "{{\n  \"rooflines\": [");
+        for (size_t i = 0; i < rooflines.size(); ++i) {
+            const roofline & roof = rooflines[i];
+            fmt::print(file, "{}\n    {{\"threads\": {}, \"bandwidth\": {:.0f}, \"compute\": {:.0f}}}",
+                i == 0 ? "" : ",", roof.threads, roof.bandwidth, roof.compute);
+        }
+        fmt::print(file, "\n  ],\n  \"points\": [");
+        for (size_t i = 0; i < points.size(); ++i) {
+            const scaling_point & p = points[i];
+            fmt::print(file,
+                "{}\n    {{\"kernel\": \"{}\", \"scaling\": \"{}\", \"vertices\": {}, \"block_length\": {}, \"threads\": {}, "
+                "\"samples\": {}, \"median_ns\": {:.0f}, \"bytes\": {:.0f}, \"speedup\": {:.4f}, \"efficiency\": {:.4f}, "
+                "\"operations\": {:.0f}, \"bandwidth\": {:.0f}, \"intensity\": {:.4f}, \"roof\": {:.0f}, "
+                "\"roof_fraction\": {:.4f}, \"bound\": \"{}\"}}",
+                i == 0 ? "" : ",", p.kernel, p.weak ? "weak" : "strong", p.vertices, p.block_length, p.threads, p.samples,
+                p.median_ns, p.bytes, p.speedup, p.efficiency, p.operations, p.bandwidth, p.intensity, p.roof,
+                p.roof_fraction, p.memory_bound ? "memory" : "compute");
+        }
+        fmt::print(file, "\n  ]\n}}\n");
+    }
+    int status = std::fclose(file) == 0 ? 1 : -1;
+    if (status == -1) {
+        spdlog::error("Cannot write scaling results to {}", path);
+    }
+    return status;
+}
+
+template roofline measure_roofline<int32_t>(int, size_t);
+template roofline measure_roofline<uint16_t>(int, size_t);
+template roofline measure_roofline<uint8_t>(int, size_t);
+template roofline measure_roofline<float>(int, size_t);
@@ -0,0 +1,126 @@
+#ifndef SCALING_H
+#define SCALING_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The two ceilings of the roofline model of this host at one thread count, as measured by `measure_roofline`.
+ */
+struct roofline {
+    int threads;
+    double bandwidth;       // DRAM bytes per second of a STREAM triad
+    double compute;         // Min-plus operations per second of `minplus_tile` on cache-resident tiles
+};
+
+/**
+ * @brief Measures the memory and compute ceilings with `threads` OpenMP threads.
+ *
+ * @tparam T The distance type whose tile kernel sets the compute ceiling (see `distance_traits`).
+ * @param threads The number of threads.
+ * @param bytes The size of each of the three triad arrays; at least a few times the last-level cache, so the
+ *              triad runs from DRAM.
+ * @return roofline The best of five runs of each measurement.
+ *
+ * @details
+ * - **Bandwidth**: The STREAM triad `a[i] = b[i] + s * c[i]` on `double`s, first touched with the same static
+ *   schedule. Counted as STREAM does, `3 * bytes` per run, without the write-allocate read of `a`.
+ * - **Compute**: Every thread updates its own `64 x 64` tiles with `minplus_tile` (three tiles in L2, the
+ *   specialized kernel of the selected `tile_isa`), `2 * 64^3` operations per call.
+ */
+template <typename T>
+roofline measure_roofline(
+    int threads,
+    size_t bytes
+);
+
+/**
+ * @brief Bytes of matrix traffic of one dense solve, in a simple streaming model.
+ *
+ * @details Every k-round reads and writes the whole matrix once: `n` rounds for the untiled kernels (`b == 0`)
+ *          and `ceil(n / b)` for the tiled ones, so `2 n^2 element_size` bytes per round. This is the DRAM
+ *          traffic when the matrix does not fit in cache; caches make the real number lower.
+ */
+double matrix_traffic(
+    int n,
+    int b,
+    size_t element_size
+);
+
+/**
+ * @brief Returns the vertex count of a weak-scaling run: `base_vertices * cbrt(threads / base_threads)`,
+ *        rounded, so that the `n^3 / threads` work per thread stays that of the base run.
+ */
+int weak_scaling_vertices(
+    int base_vertices,
+    int base_threads,
+    int threads
+);
+
+/**
+ * @brief One point of a scaling sweep: a kernel, size, block length and thread count, and what it achieved.
+ */
+struct scaling_point {
+    std::string kernel;
+    bool weak;                  // Part of a weak-scaling series, whose size grows with the thread count
+    int vertices;
+    int block_length;           // `0` for the untiled kernels
+    int threads;
+    int samples;                // Timed iterations behind `median_ns`
+    double median_ns;
+    double bytes;               // Traffic of one solve, from `matrix_traffic`
+    double speedup;             // Strong: base time / time. Weak: scaled speedup, efficiency * threads / base threads
+    double efficiency;          // Strong: speedup * base threads / threads. Weak: base time / time
+    double operations;          // Min-plus operations per second, `2 n^3` per solve
+    double bandwidth;           // Bytes per second of the traffic model
+    double intensity;           // Operations per byte of the traffic model
+    double roof;                // Attainable operations per second: min(compute, intensity * bandwidth)
+    double roof_fraction;       // `operations / roof`
+    bool memory_bound;          // The bandwidth slope, not the compute ceiling, is the lower roof
+};
+
+/**
+ * @brief Fills the derived fields of every point: rates, speedup and efficiency, and the roofline.
+ *
+ * @param points The measured points; `kernel`, `weak`, `vertices`, `block_length`, `threads`, `median_ns` and
+ *               `bytes` are set.
+ * @param rooflines One roofline per thread count of the sweep.
+ *
+ * @details The base of a point is the point of the same kernel, block length and series with the fewest
+ *          threads: of the same size for strong scaling, of any size for weak scaling. Points without a base
+ *          or a roofline for their thread count are left with zero speedup or roof.
+ */
+void compute_scaling(
+    std::vector<scaling_point> & points,
+    const std::vector<roofline> & rooflines
+);
+
+/**
+ * @brief Prints one line per point: time, speedup, efficiency, achieved bandwidth and the roofline verdict.
+ */
+void print_scaling(
+    const std::vector<scaling_point> & points,
+    const std::vector<roofline> & rooflines
+);
+
+/**
+ * @brief Writes the rooflines and the points of a sweep to a file.
+ *
+ * @param path The file to write; it is replaced.
+ * @param format `csv` or `json`.
+ * @return int Returns `1` on success, or `-1` if the file cannot be written or the format is unknown.
+ *
+ * @details
+ * - **CSV**: A `threads,bandwidth,compute` row per roofline, then a blank line and a row per point with every
+ *   field of `scaling_point`; `weak` is `strong` or `weak`, `memory_bound` is `memory` or `compute`.
+ * - **JSON**: `{"rooflines": [{"threads", "bandwidth", "compute"}...], "points": [{"kernel", "scaling", ...}...]}`.
+ */
+int write_scaling(
+    const std::string & path,
+    const std::string & format,
+    const std::vector<scaling_point> & points,
+    const std::vector<roofline> & rooflines
+);
+
+#endif
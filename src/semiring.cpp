@@ -0,0 +1,55 @@
+#include "semiring.h"
+#include <cstddef>
+#include <cstdint>
+
+template <typename S, typename T>
+void semiring_from_distances(T *W, int n) {
+    const T inf = distance_traits<T>::inf();
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; ++i) {
+        T *row = W + static_cast<size_t>(i) * n;
+        for (int j = 0; j < n; ++j) {
+            if (i == j) {
+                row[j] = S::template one<T>();
+            }
+            else if (row[j] == inf) {
+                row[j] = S::template zero<T>();
+            }
+            else if constexpr (std::is_same_v<S, or_and>) {
+                row[j] = S::template one<T>();
+            }
+        }
+    }
+}
+
+template <typename S, typename T>
+void semiring_canonicalize(T *W, int n) {
+    if constexpr (std::is_same_v<S, max_plus> && std::is_integral_v<T>) {
+        const T zero = S::template zero<T>();
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; ++i) {
+            T *row = W + static_cast<size_t>(i) * n;
+            for (int j = 0; j < n; ++j) {
+                row[j] = row[j] < 0 ? zero : row[j];
+            }
+        }
+    }
+}
+
+#define INSTANTIATE_SEMIRING(S, T) \
+    template void semiring_from_distances<S, T>(T *, int); \
+    template void semiring_canonicalize<S, T>(T *, int);
+
+#define INSTANTIATE_ANY_TYPE_SEMIRINGS(T) \
+    INSTANTIATE_SEMIRING(min_plus, T) \
+    INSTANTIATE_SEMIRING(max_min, T) \
+    INSTANTIATE_SEMIRING(or_and, T)
+
+#define INSTANTIATE_SEMIRINGS(T) \
+    INSTANTIATE_ANY_TYPE_SEMIRINGS(T) \
+    INSTANTIATE_SEMIRING(max_plus, T)
+
+INSTANTIATE_SEMIRINGS(int32_t)
+INSTANTIATE_ANY_TYPE_SEMIRINGS(uint16_t)
+INSTANTIATE_ANY_TYPE_SEMIRINGS(uint8_t)
+INSTANTIATE_SEMIRINGS(float)
@@ -0,0 +1,143 @@
+#ifndef SEMIRING_H
+#define SEMIRING_H
+
+#include "globals.h"
+#include <algorithm>
+#include <type_traits>
+
+/**
+ * @brief The elementwise operations a semiring's `⊕` and `⊗` are built from.
+ *
+ * Policies name their operations with these tags instead of providing functions, so that every tile kernel
+ * maps them to its own instructions at compile time: `std::min` in the scalar kernel, `vpminsd` in the AVX2
+ * kernel, and so on (see `semiring_apply` and tile.cpp).
+ */
+enum class semiring_op {
+    min,        // `std::min`
+    max,        // `std::max`
+    add,        // `distance_traits<T>::add`, saturating for the narrow unsigned types
+    bit_or,     // Bitwise OR; `std::max` in the scalar kernel, which is the same on `0` and `1`
+    bit_and,    // Bitwise AND; `std::min` in the scalar kernel, which is the same on `0` and `1`
+};
+
+/**
+ * @brief Applies `O` to two elements. The scalar counterpart of the vector operations in tile.cpp.
+ */
+template <semiring_op O, typename T>
+inline T semiring_apply(T a, T b) {
+    if constexpr (O == semiring_op::min) {
+        return std::min(a, b);
+    }
+    else if constexpr (O == semiring_op::max || O == semiring_op::bit_or) {
+        return std::max(a, b);
+    }
+    else if constexpr (O == semiring_op::bit_and) {
+        return std::min(a, b);
+    }
+    else {
+        return distance_traits<T>::add(a, b);
+    }
+}
+
+/**
+ * @brief Semiring policies of the semiring-generic kernels (`semiring_tile`, `blocked_floyd_warshall` and others).
+ *
+ * A blocked kernel instantiated with a policy computes, for every pair `(i, j)`, the `⊕` over all paths from
+ * `i` to `j` of the `⊗` of their edge weights. Every policy provides:
+ * - `plus`: The `semiring_op` of `⊕`, which combines alternative paths: `min`, `max` or `bit_or`, all idempotent.
+ * - `times`: The `semiring_op` of `⊗`, which concatenates paths.
+ * - `zero<T>()`: The identity of `⊕` and annihilator of `⊗`: "no path". Kernels skip rows of `A` equal to it,
+ *   and tiles that are all `zero()`.
+ * - `one<T>()`: The identity of `⊗`: the empty path, on the diagonal.
+ * - `name()`: The name used by the `--semiring` CLI option.
+ *
+ * The kernels update tiles in place, so they need `x ⊕ (x ⊗ w) == x` for every cycle weight `w` through a vertex,
+ * i.e. no cycle ever improves a path. This holds for min-plus with non-negative weights, for max-min and Boolean
+ * always, and for max-plus on acyclic graphs only.
+ */
+struct min_plus {
+    static constexpr semiring_op plus = semiring_op::min;
+    static constexpr semiring_op times = semiring_op::add;
+    template <typename T> static constexpr T zero() { return distance_traits<T>::inf(); }
+    template <typename T> static constexpr T one() { return T(0); }
+    static const char * name() { return "min-plus"; }
+};
+
+/**
+ * @brief Widest (bottleneck) paths: the largest capacity over all paths, where the capacity of a path is that of
+ *        its narrowest edge. "No path" is `0` and the empty path has unbounded capacity, `distance_traits<T>::inf()`.
+ */
+struct max_min {
+    static constexpr semiring_op plus = semiring_op::max;
+    static constexpr semiring_op times = semiring_op::min;
+    template <typename T> static constexpr T zero() { return T(0); }
+    template <typename T> static constexpr T one() { return distance_traits<T>::inf(); }
+    static const char * name() { return "max-min"; }
+};
+
+/**
+ * @brief Longest paths of a directed acyclic graph. "No path" is `-distance_traits<T>::inf()`, so only the signed
+ *        types `int32_t` and `float` are supported.
+ *
+ * @note With `int32_t`, `-INF + w` is not absorbing: unreachable pairs may end up anywhere in `[-INF, 0)`, which
+ *       every kernel treats alike. `semiring_canonicalize` maps them back to `zero()`.
+ */
+struct max_plus {
+    static constexpr semiring_op plus = semiring_op::max;
+    static constexpr semiring_op times = semiring_op::add;
+    template <typename T> static constexpr T zero() {
+        static_assert(std::is_signed_v<T>, "max-plus needs a signed distance type");
+        return -distance_traits<T>::inf();
+    }
+    template <typename T> static constexpr T one() { return T(0); }
+    static const char * name() { return "max-plus"; }
+};
+
+/**
+ * @brief Boolean reachability, `(OR, AND)` on `0` and `1`. The vector kernels use bitwise operations, and
+ *        `c | (a & b)` is a single `vpternlogd` on AVX-512, where max-min takes two instructions on one port.
+ *        For large graphs the bit-packed `transitive_closure` (see closure.h) uses 1/8 of the memory of `uint8_t`.
+ *
+ * @note Every entry must be `0` or `1` (`1.0f` for `float`, whose bits are then OR'ed and AND'ed alike), as
+ *       after `semiring_from_distances`.
+ */
+struct or_and {
+    static constexpr semiring_op plus = semiring_op::bit_or;
+    static constexpr semiring_op times = semiring_op::bit_and;
+    template <typename T> static constexpr T zero() { return T(0); }
+    template <typename T> static constexpr T one() { return T(1); }
+    static const char * name() { return "or-and"; }
+};
+
+/**
+ * @brief Converts an adjacency matrix in the min-plus convention of the graph generators and matrix files
+ *        (`distance_traits<T>::inf()` for no edge, `0` on the diagonal) to the convention of `S`.
+ *
+ * No edge becomes `S::zero<T>()` and the diagonal `S::one<T>()`. Edge weights are kept as lengths (min-plus,
+ * max-plus) or capacities (max-min), and become `1` for `or_and`.
+ *
+ * @tparam S The semiring policy.
+ * @tparam T The distance type.
+ * @param W A pointer to the `n x n` matrix in flattened form. Updated in-place.
+ * @param n The number of vertices.
+ */
+template <typename S, typename T>
+void semiring_from_distances(
+    T * W,
+    int n
+);
+
+/**
+ * @brief Maps every entry that `S` reads as "no path" to exactly `S::zero<T>()`. Only `max_plus` on `int32_t`
+ *        has such entries other than `zero()` (see `max_plus`); for every other semiring this returns at once.
+ *
+ * @param W A pointer to the `n x n` result matrix in flattened form. Updated in-place.
+ * @param n The number of vertices.
+ */
+template <typename S, typename T>
+void semiring_canonicalize(
+    T * W,
+    int n
+);
+
+#endif
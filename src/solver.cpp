@@ -0,0 +1,148 @@
+#include "solver.h"
+#include "kernels.h"
+#include "allocator.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <omp.h>
+
+template <typename T>
+floyd_warshall_solver<T>::floyd_warshall_solver(const solver_options & options)
+    : options_(options), caches_(read_cache_sizes()) {
+    if (options_.threads <= 0) {
+        options_.threads = omp_get_max_threads();
+    }
+}
+
+template <typename T>
+int floyd_warshall_solver<T>::block_length(int n) const {
+    if (options_.block_length > 0) {
+        return std::min(options_.block_length, n);
+    }
+    return heuristic_block_length(n, caches_, sizeof(T));
+}
+
+template <typename T>
+int floyd_warshall_solver<T>::threads() const {
+    return options_.threads;
+}
+
+template <typename T>
+int floyd_warshall_solver<T>::interleaved_block_length(int n) const {
+    if (options_.block_length > 0) {
+        return std::min(options_.block_length, n);
+    }
+    const long l2 = caches_.l2 > 0 ? caches_.l2 : 256 * 1024;
+    int b = 4;
+    while (3L * (b + 4) * (b + 4) * 64 <= l2 / 2) {
+        b += 4;
+    }
+    return std::min(b, n);
+}
+
+template <typename T>
+void floyd_warshall_solver<T>::run(T * W, int n) const {
+    if (n <= 0) {
+        return;
+    }
+    const int b = block_length(n);
+    switch (options_.kernel) {
+    case solver_kernel::blocked:
+        blocked_floyd_warshall(W, n, b);
+        break;
+    case solver_kernel::zero_copy:
+        inplace_blocked_floyd_warshall(W, n, b);
+        break;
+    case solver_kernel::task:
+        task_blocked_floyd_warshall(W, n, b);
+        break;
+    case solver_kernel::recursive:
+        recursive_floyd_warshall(W, n, b);
+        break;
+    }
+}
+
+template <typename T>
+void floyd_warshall_solver<T>::solve(T * W, int n) const {
+    // nthreads-var belongs to the calling task, so this never changes the settings of another thread.
+    const int saved = omp_get_max_threads();
+    omp_set_num_threads(options_.threads);
+    run(W, n);
+    omp_set_num_threads(saved);
+}
+
+template <typename T>
+void floyd_warshall_solver<T>::solve_interleaved(const std::vector<batch_matrix<T>> & batch) const {
+    constexpr int L = interleave_lanes<T>();
+    struct lane_group {
+        int n;
+        std::vector<T *> matrices;
+    };
+
+    // Groups of up to L matrices of one size, largest sizes first.
+    std::map<int, std::vector<T *>, std::greater<int>> by_size;
+    for (const batch_matrix<T> & matrix : batch) {
+        if (matrix.n > 0) {
+            by_size[matrix.n].push_back(matrix.W);
+        }
+    }
+    std::vector<lane_group> groups;
+    for (const auto & [n, matrices] : by_size) {
+        for (size_t first = 0; first < matrices.size(); first += L) {
+            size_t last = std::min(matrices.size(), first + L);
+            groups.push_back({n, std::vector<T *>(matrices.begin() + first, matrices.begin() + last)});
+        }
+    }
+    const size_t largest = by_size.empty() ? 0 : static_cast<size_t>(by_size.begin()->first) * by_size.begin()->first * L;
+
+    #pragma omp parallel num_threads(options_.threads)
+    {
+        aligned_buffer<T> group_buffer;
+        #pragma omp for schedule(dynamic)
+        for (size_t x = 0; x < groups.size(); ++x) {
+            if (group_buffer.size() == 0) {
+                group_buffer = aligned_buffer<T>(largest);
+            }
+            const lane_group & group = groups[x];
+            const int count = static_cast<int>(group.matrices.size());
+            interleave_matrices<T>(group.matrices.data(), count, group.n, group_buffer.data());
+            interleaved_floyd_warshall(group_buffer.data(), group.n, interleaved_block_length(group.n));
+            deinterleave_matrices<T>(group_buffer.data(), count, group.n, group.matrices.data());
+        }
+    }
+}
+
+template <typename T>
+void floyd_warshall_solver<T>::solve_batch(const std::vector<batch_matrix<T>> & batch) const {
+    if (options_.interleave) {
+        solve_interleaved(batch);
+        return;
+    }
+    const int count = static_cast<int>(batch.size());
+    if (count < options_.threads) {
+        for (const batch_matrix<T> & matrix : batch) {
+            solve(matrix.W, matrix.n);
+        }
+        return;
+    }
+
+    // Largest matrices first, so the dynamic schedule ends on small ones and the threads finish together.
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return batch[a].n > batch[b].n; });
+
+    #pragma omp parallel for schedule(dynamic) num_threads(options_.threads)
+    for (int x = 0; x < count; ++x) {
+        // The kernel's own parallel regions run on this thread alone.
+        omp_set_num_threads(1);
+        const batch_matrix<T> & matrix = batch[order[x]];
+        run(matrix.W, matrix.n);
+    }
+}
+
+template class floyd_warshall_solver<int32_t>;
+template class floyd_warshall_solver<uint16_t>;
+template class floyd_warshall_solver<uint8_t>;
+template class floyd_warshall_solver<float>;
@@ -0,0 +1,111 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "autotune.h"
+#include "globals.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief The shared-memory kernels a `floyd_warshall_solver` can run (see kernels.h).
+ */
+enum class solver_kernel {
+    blocked,            // `blocked_floyd_warshall`
+    zero_copy,          // `inplace_blocked_floyd_warshall`
+    task,               // `task_blocked_floyd_warshall`
+    recursive,          // `recursive_floyd_warshall`
+};
+
+/**
+ * @brief Settings of a `floyd_warshall_solver`, fixed at construction.
+ */
+struct solver_options {
+    solver_kernel kernel = solver_kernel::zero_copy;
+    int block_length = 0;       // Tile size, or `0` to pick `heuristic_block_length` for each matrix size
+    int threads = 0;            // OpenMP threads of every call, or `0` for `omp_get_max_threads()` at construction
+    bool interleave = false;    // `solve_batch`: solve equal-size matrices one per SIMD lane (`interleaved_floyd_warshall`)
+};
+
+/**
+ * @brief One matrix of a batch: `n x n` distances in flattened form, solved in place.
+ */
+template <typename T>
+struct batch_matrix {
+    T * W;
+    int n;
+};
+
+/**
+ * @brief A reentrant all-pairs shortest path solver for distance type `T`, for library users of `fw_core`.
+ *
+ * The solver holds its kernel, block length and thread count, and reads the host cache sizes once, so calls do
+ * no per-call setup beyond what the kernel itself needs. It touches no global state: the thread count applies to
+ * the calling thread's own OpenMP regions only, and the per-thread tile scratch of the kernels (see
+ * `tile_scratch`) already belongs to each thread, so any number of host threads may share one solver.
+ *
+ * @tparam T The distance type: `int32_t`, `uint16_t`, `uint8_t` or `float` (see `distance_traits`).
+ *
+ * @example
+ * ```
+ * floyd_warshall_solver<float> solver({solver_kernel::zero_copy, 0, 16});
+ * std::vector<batch_matrix<float>> batch = ...;     // Thousands of n = 200 graphs
+ * solver.solve_batch(batch);
+ * ```
+ */
+template <typename T>
+class floyd_warshall_solver {
+public:
+    explicit floyd_warshall_solver(const solver_options & options = {});
+
+    /**
+     * @brief Solves one `n x n` matrix in place, with all of the solver's threads.
+     */
+    void solve(T * W, int n) const;
+
+    /**
+     * @brief Solves every matrix of `batch` in place; the matrices are independent and may differ in size.
+     *
+     * @details
+     * - With at least as many matrices as threads, each thread takes whole matrices (dynamic schedule, largest
+     *   first) and solves them with a single-threaded kernel: one parallel region for the whole batch instead of
+     *   one per phase and round of every matrix, and no barriers between matrices.
+     * - With fewer matrices than threads, they are solved one after the other with all threads each.
+     * - With `interleave`, matrices of equal size are grouped `interleave_lanes<T>()` at a time and each thread
+     *   solves whole groups with `interleaved_floyd_warshall`, in a scratch group buffer it allocates once per
+     *   call; the last group of each size may have unused lanes. `kernel` is not used.
+     */
+    void solve_batch(const std::vector<batch_matrix<T>> & batch) const;
+
+    /**
+     * @brief Returns the block length used for an `n x n` matrix: the configured one, capped at `n`, or the
+     *        heuristic choice for `n`.
+     */
+    int block_length(int n) const;
+
+    /**
+     * @brief Returns the number of OpenMP threads of every call.
+     */
+    int threads() const;
+
+    /**
+     * @brief Returns the tile size in cells of `interleaved_floyd_warshall` for `n x n` graphs: the configured
+     *        block length, or three tiles of 64-byte cells in half of L2, a multiple of 4; capped at `n`.
+     */
+    int interleaved_block_length(int n) const;
+
+private:
+    /**
+     * @brief Runs the configured kernel on one matrix with the calling thread's current OpenMP settings.
+     */
+    void run(T * W, int n) const;
+
+    /**
+     * @brief `solve_batch` with `interleave`: whole lane groups per thread.
+     */
+    void solve_interleaved(const std::vector<batch_matrix<T>> & batch) const;
+
+    solver_options options_;
+    cache_sizes caches_;
+};
+
+#endif
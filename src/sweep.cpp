@@ -0,0 +1,300 @@
+#include "graph.h"
+#include "tile.h"
+#include "autotune.h"
+#include "allocator.h"
+#include "numa.h"
+#include "globals.h"
+#include "scaling.h"
+#include "kernel_registry.h"
+#include "timestamps.h"
+#include "plf_nanotimer.h"
+#include <omp.h>
+#include <CLI/CLI.hpp>
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/basic_file_sink.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of a sweep, resolved and validated by `main`.
+ */
+struct sweep_config {
+    std::vector<std::string> kernels;
+    std::vector<int> strong;            // Fixed sizes, each run at every thread count
+    std::vector<int> weak;              // Sizes at the first thread count, grown with `weak_scaling_vertices`
+    std::vector<int> block_lengths;
+    std::vector<int> threads;           // Ascending
+    int edge_factor;                    // Edges per vertex of the generated graphs
+    uint64_t seed;
+    int iterations;
+    int warmup;
+    size_t stream_bytes;                // Size of each STREAM triad array
+};
+
+/**
+ * @brief Measures the rooflines, then times every kernel × size × block length × thread count of `config`.
+ *
+ * @tparam T The distance type selected with `--dtype`.
+ * @param config The validated settings.
+ * @param points Receives one point per run, with the derived fields filled by `compute_scaling`.
+ * @param rooflines Receives one roofline per thread count.
+ *
+ * @details Points are run grouped by size, so each graph (uniform weights, `edge_factor * n` edges from
+ *          `config.seed`) is generated once. Every iteration restores the input with `copy_matrix`, untimed.
+ */
+template <typename T>
+static void run_sweep(const sweep_config & config, std::vector<scaling_point> & points, std::vector<roofline> & rooflines)
+{
+    for (int t : config.threads) {
+        spdlog::info("Measuring the roofline with {} threads.", t);
+        rooflines.push_back(measure_roofline<T>(t, config.stream_bytes));
+    }
+
+    std::vector<registered_kernel<T>> kernels;
+    for (const registered_kernel<T> & kernel : registered_kernels<T>()) {
+        if (!kernel.sparse && std::find(config.kernels.begin(), config.kernels.end(), kernel.name) != config.kernels.end()) {
+            kernels.push_back(kernel);
+        }
+    }
+    for (bool weak : {false, true}) {
+        for (int size : weak ? config.weak : config.strong) {
+            for (int t : config.threads) {
+                int n = weak ? weak_scaling_vertices(size, config.threads.front(), t) : size;
+                for (const registered_kernel<T> & kernel : kernels) {
+                    std::vector<int> block_lengths = kernel.tiled ? config.block_lengths : std::vector<int>{0};
+                    for (int b : block_lengths) {
+                        if (b <= n) {
+                            scaling_point point{};
+                            point.kernel = kernel.name;
+                            point.weak = weak;
+                            point.vertices = n;
+                            point.block_length = b;
+                            point.threads = t;
+                            points.push_back(point);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    std::stable_sort(points.begin(), points.end(), [](const scaling_point & x, const scaling_point & y) {
+        return x.vertices < y.vertices;
+    });
+
+    aligned_buffer<T> input;
+    aligned_buffer<T> W;
+    int generated = 0;
+    graph_options options;
+    options.seed = config.seed;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 100;
+    for (scaling_point & point : points) {
+        const int n = point.vertices;
+        if (n != generated) {
+            spdlog::info("Generating graph with {} vertices.", n);
+            input = aligned_buffer<T>(static_cast<size_t>(n) * n);
+            W = aligned_buffer<T>(static_cast<size_t>(n) * n);
+            long long edges = std::min<long long>(static_cast<long long>(config.edge_factor) * n, static_cast<long long>(n) * (n - 1));
+            generate_linear_graph(input.data(), n, static_cast<int>(edges), options);
+            generated = n;
+        }
+        const registered_kernel<T> & kernel = *std::find_if(kernels.begin(), kernels.end(), [&](const registered_kernel<T> & k) {
+            return point.kernel == k.name;
+        });
+        omp_set_num_threads(point.threads);
+        std::vector<std::tuple<std::string, double>> timestamps;
+        for (int i = -config.warmup; i < config.iterations; i++) {
+            copy_matrix(W.data(), input.data(), n, point.block_length > 0 ? point.block_length : 64);
+            plf::nanotimer timer;
+            timer.start();
+            kernel.run(W.data(), n, point.block_length);
+            double time_result = timer.get_elapsed_ns();
+            if (i >= 0) {
+                mark_time(timestamps, time_result, "Sweep time, iteration: " + std::to_string(i));
+            }
+        }
+        timing_summary summary = summarize_timestamps(timestamps).front();
+        point.samples = summary.samples;
+        point.median_ns = summary.median;
+        point.bytes = matrix_traffic(n, point.block_length, sizeof(T));
+        spdlog::info("{} n {} b {} threads {}: median {:.0f} ns", point.kernel, n, point.block_length, point.threads, point.median_ns);
+    }
+    compute_scaling(points, rooflines);
+
+    // Report the strong series first, each in the order it ran.
+    std::stable_sort(points.begin(), points.end(), [](const scaling_point & x, const scaling_point & y) {
+        return !x.weak && y.weak;
+    });
+}
+
+/**
+ * @brief Entry point of the `scaling` target: strong- and weak-scaling sweeps with a roofline report.
+ *
+ * @details
+ * 1. **Parse Command-Line Arguments**:
+ *    - `-k, --kernels`: Kernels to sweep: `serial`, `naive`, `persistent-naive`, `blocked`, `persistent-blocked`,
+ *      `zero-copy`, `task`, `recursive` (default: blocked zero-copy).
+ *    - `-v, --vertices`: Sizes of the strong-scaling series, each run at every thread count.
+ *    - `-w, --weak`: Sizes at the first thread count of the weak-scaling series; at `t` threads the size is
+ *      `n * cbrt(t / t0)`, so `n^3 / t` stays constant.
+ *    - Without `-v` and `-w`, the strong series is 1000 and 2000 vertices and the weak series starts at 1000.
+ *    - `-l, --block-lengths`: Block lengths of the tiled kernels (default: 32 64).
+ *    - `-t, --threads`: Thread counts (default: 1, 2, 4, ... up to `omp_get_max_threads()`, and the maximum itself).
+ *    - `-e, --edge-factor`: Edges per vertex of the generated graphs (default: 8).
+ *    - `--seed`: Seed of the graph generator (default: 0).
+ *    - `-i, --iterations`: Timed iterations per point; the median is reported (default: 3).
+ *    - `--warmup`: Untimed iterations per point (default: 1).
+ *    - `--dtype`: Distance type: `int32`, `uint16`, `uint8` or `float` (default: int32).
+ *    - `--stream-size`: Megabytes of each STREAM triad array (default: four times the L3 size, at least 64).
+ *    - `--bind`: Pin OpenMP threads: `none`, `close` or `spread` (default: none).
+ *    - `--output`: File to write the rooflines and points to.
+ *    - `--format`: Format of `--output`: `csv` or `json` (default: json).
+ *
+ * 2. **Roofline**: For every thread count, the STREAM triad bandwidth and the rate of the min-plus tile kernel on
+ *    cache-resident tiles are measured (see `measure_roofline`).
+ *
+ * 3. **Sweep**: Every kernel × size × block length × thread count is timed; speedup, parallel efficiency,
+ *    achieved bandwidth of the traffic model, arithmetic intensity and the fraction of the roofline reached are
+ *    derived with `compute_scaling` and printed, and written to `--output`.
+ *
+ * @example
+ * The strong and weak scaling of the former `strong_scaling_test.sh` and `weak_scaling_test.sh`:
+ * ```
+ * ./scaling -k naive blocked -v 500 1000 2000 4000 -w 1000 -l 20 -t 1 2 4 8 16 32 --bind spread --output scaling.csv --format csv
+ * ```
+ */
+int main(const int argc, const char *const argv[])
+{
+    auto file_logger = spdlog::basic_logger_mt("file_logger", "logfile.txt");
+    spdlog::set_default_logger(file_logger);
+
+    std::vector<std::string> kernels{"blocked", "zero-copy"};
+    std::vector<int> strong;
+    std::vector<int> weak;
+    std::vector<int> block_lengths{32, 64};
+    std::vector<int> threads;
+    int edge_factor{8};
+    uint64_t seed{0};
+    int iterations{3};
+    int warmup{1};
+    std::string dtype{"int32"};
+    size_t stream_size{0};
+    std::string bind{"none"};
+    std::string output;
+    std::string format{"json"};
+
+    int max_threads = omp_get_max_threads();
+    for (int t = 1; t < max_threads; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(max_threads);
+
+    CLI::App app{"Floyd-Warshall scaling sweep"};
+    app.option_defaults()->always_capture_default(true);
+    app.add_option("-k, --kernels", kernels)
+        ->check(CLI::IsMember(registered_kernel_names(true)));
+    app.add_option("-v, --vertices", strong)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-w, --weak", weak)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-l, --block-lengths", block_lengths)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-t, --threads", threads)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("-e, --edge-factor", edge_factor)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--seed", seed);
+    app.add_option("-i, --iterations", iterations)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--warmup", warmup)
+        ->check(CLI::NonNegativeNumber.description(" >= 0"));
+    app.add_option("--dtype", dtype)
+        ->check(CLI::IsMember({"int32", "uint16", "uint8", "float"}));
+    app.add_option("--stream-size", stream_size)
+        ->check(CLI::PositiveNumber.description(" >= 1"));
+    app.add_option("--bind", bind)
+        ->check(CLI::IsMember({"none", "close", "spread"}));
+    app.add_option("--output", output);
+    app.add_option("--format", format)
+        ->check(CLI::IsMember({"csv", "json"}));
+    CLI11_PARSE(app, argc, argv);
+
+    // Default series, unless either one was given.
+    if (strong.empty() && weak.empty())
+    {
+        strong = {1000, 2000};
+        weak = {1000};
+    }
+
+    // Thread counts run in ascending order, so the first one is the base of every series.
+    for (int & t : threads) {
+        if (t > max_threads) {
+            spdlog::info("Argument threads {} is greater than max threads {}, using {}", t, max_threads, max_threads);
+            t = max_threads;
+        }
+    }
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    // The triad arrays must be well beyond the last-level cache to measure DRAM.
+    if (stream_size == 0)
+    {
+        cache_sizes caches = read_cache_sizes();
+        stream_size = std::max<size_t>(64, 4 * static_cast<size_t>(caches.l3) / (1024 * 1024));
+    }
+
+    // Pin the OpenMP threads, as the scaling scripts did with --bind spread.
+    numa_topology numa = read_numa_topology();
+    bind_policy binding = bind_policy::none;
+    parse_bind_policy(bind, binding);
+    if (binding != bind_policy::none && bind_threads(binding, numa) == -1)
+    {
+        spdlog::error("Failed to bind threads with policy {}", bind);
+        return 1;
+    }
+
+    sweep_config config{
+        kernels,
+        strong,
+        weak,
+        block_lengths,
+        threads,
+        edge_factor,
+        seed,
+        iterations,
+        warmup,
+        stream_size * 1024 * 1024
+    };
+    std::vector<scaling_point> points;
+    std::vector<roofline> rooflines;
+    if (dtype == "int32") {
+        run_sweep<int32_t>(config, points, rooflines);
+    }
+    else if (dtype == "uint16") {
+        run_sweep<uint16_t>(config, points, rooflines);
+    }
+    else if (dtype == "uint8") {
+        run_sweep<uint8_t>(config, points, rooflines);
+    }
+    else if (dtype == "float") {
+        run_sweep<float>(config, points, rooflines);
+    }
+
+    fmt::print(
+        "SIMD tile kernel: {}\nDistance type: {}\nThread binding: {}\n",
+        tile_isa_name(get_tile_isa()),
+        dtype,
+        bind_policy_name(binding)
+    );
+    print_scaling(points, rooflines);
+    if (!output.empty())
+    {
+        if (write_scaling(output, format, points, rooflines) == -1)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
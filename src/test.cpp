@@ -2,9 +2,38 @@
 #include <gtest/gtest.h>
 #include "graph.h"
 #include "kernels.h"
+#include "tile.h"
+#include "autotune.h"
+#include "matrix_io.h"
+#include "paths.h"
+#include "incremental.h"
+#include "numa.h"
+#include "allocator.h"
+#include "offload.h"
+#include "outofcore.h"
+#include "timestamps.h"
+#include "instrument.h"
+#include "solver.h"
+#include "closure.h"
+#include "semiring.h"
+#include "query.h"
+#include "scaling.h"
+#include "kernel_registry.h"
 #include "globals.h"
 #include <omp.h>
 #include <vector>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <fstream>
+#include <iterator>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 class FloydWarshallTest : public testing::Test {
     public:
@@ -25,9 +54,9 @@ class FloydWarshallTest : public testing::Test {
         int tile_length{20};
         int threads{2};
 
-        std::vector<int> graph_1;
-        std::vector<int> graph_2;
-        std::vector<int> graph_3;      
+        aligned_vector<int> graph_1;
+        aligned_vector<int> graph_2;
+        aligned_vector<int> graph_3;      
 };
 
 TEST_F(FloydWarshallTest, TestAll)
@@ -37,7 +66,7 @@ TEST_F(FloydWarshallTest, TestAll)
     graph_2.resize(vertices * vertices, INF);
     graph_3.resize(vertices * vertices, INF);
     // Populate graph 1 with generated data.
-    generate_linear_graph(graph_1, vertices, edges);
+    generate_linear_graph(graph_1.data(), vertices, edges);
     // Copy data from graph 1 into graphs 2 and 3.
     for (int i = 0; i < vertices; i++) {
         for (int j = 0; j < vertices; j++) {
@@ -48,11 +77,11 @@ TEST_F(FloydWarshallTest, TestAll)
     // Set threads
     omp_set_num_threads(threads);
     // Run serial on graph 1.
-    serial_floyd_warshall(graph_1, vertices);
+    serial_floyd_warshall(graph_1.data(), vertices);
     // Run naive parallel on graph 2.
-    naive_floyd_warshall(graph_2, vertices);
+    naive_floyd_warshall(graph_2.data(), vertices);
     // Run blocked parallel on graph 3.
-    blocked_floyd_warshall(graph_3, vertices, tile_length);
+    blocked_floyd_warshall(graph_3.data(), vertices, tile_length);
     // Compare results.
     for (int i = 0; i < vertices; i++) {
         for (int j = 0; j < vertices; j++) {
@@ -60,4 +89,1143 @@ TEST_F(FloydWarshallTest, TestAll)
             ASSERT_EQ(graph_2[i * vertices + j], graph_3[i * vertices + j]);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_F(FloydWarshallTest, TestZeroCopyBlocked)
+{
+    // Initialize graphs.
+    graph_1.resize(vertices * vertices, INF);
+    graph_2.resize(vertices * vertices, INF);
+    // Populate graph 1 with generated data and copy it into graph 2.
+    generate_linear_graph(graph_1.data(), vertices, edges);
+    graph_2 = graph_1;
+    // Set threads
+    omp_set_num_threads(threads);
+    // Run serial on graph 1.
+    serial_floyd_warshall(graph_1.data(), vertices);
+    // Run zero-copy blocked parallel on graph 2.
+    inplace_blocked_floyd_warshall(graph_2.data(), vertices, tile_length);
+    // Compare results.
+    for (int i = 0; i < vertices; i++) {
+        for (int j = 0; j < vertices; j++) {
+            ASSERT_EQ(graph_1[i * vertices + j], graph_2[i * vertices + j]);
+        }
+    }
+}
+
+TEST_F(FloydWarshallTest, TestClosure)
+{
+    // 64 and 65 put the last block row at a word boundary and one past it; 1000 has 16 rounds of blocks.
+    for (int n : {64, 65, 203, vertices}) {
+        for (int m : {n / 2, 2 * n}) {
+            graph_1.assign(n * n, INF);
+            generate_linear_graph(graph_1.data(), n, m);
+            bit_matrix R(n);
+            pack_reachability(graph_1.data(), 0, n, R);
+            bit_matrix generated(n);
+            ASSERT_EQ(generate_reachability(generated, m, graph_options{}, 17), 1);
+            ASSERT_TRUE(std::equal(R.bits.data(), R.bits.data() + R.bits.size(), generated.bits.data()));
+
+            serial_floyd_warshall(graph_1.data(), n);
+            omp_set_num_threads(threads);
+            transitive_closure(R);
+            long long pairs = 0;
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    ASSERT_EQ(R.test(i, j), graph_1[i * n + j] != INF) << "n " << n << ", m " << m << ", " << i << " -> " << j;
+                    pairs += graph_1[i * n + j] != INF;
+                }
+            }
+            ASSERT_EQ(count_reachable_pairs(R), pairs);
+        }
+    }
+}
+
+TEST_F(FloydWarshallTest, TestSparseTiles)
+{
+    // Two chains in the first and last thirds leave whole tile rows, columns and panels all INF, and the
+    // tiles between the chains fill in only in later rounds.
+    for (int n : {300, 301}) {
+        graph_1.assign(n * n, INF);
+        for (int i = 0; i < n; i++) {
+            graph_1[i * n + i] = 0;
+        }
+        for (int i = 0; i + 1 < n / 3; i++) {
+            graph_1[i * n + i + 1] = 1;
+            graph_1[(n - 1 - i) * n + n - 2 - i] = 2;
+        }
+        graph_1[(n / 3 - 1) * n + n - 1] = 5;
+        graph_2 = graph_1;
+        graph_3 = graph_1;
+        serial_floyd_warshall(graph_1.data(), n);
+        omp_set_num_threads(threads);
+        blocked_floyd_warshall(graph_2.data(), n, tile_length);
+        inplace_blocked_floyd_warshall(graph_3.data(), n, tile_length);
+        ASSERT_EQ(graph_1, graph_2) << "n " << n;
+        ASSERT_EQ(graph_1, graph_3) << "n " << n;
+    }
+}
+
+/**
+ * @brief Checks every supported vector path of `semiring_tile<S, T>` against the scalar path on random tiles.
+ */
+template <typename T, typename S = min_plus>
+static void check_tile_isa()
+{
+    // An odd tile size exercises the vector tails; the others are the fixed-size kernels, on strided views.
+    for (int b : {37, 16, 32, 64, 128}) {
+        int ld = b == 37 ? b : b + 3;
+        const T inf = S::template zero<T>();
+        std::vector<T> A(b * ld), B(b * ld), C(b * ld);
+        std::mt19937 rng(7);
+        for (int i = 0; i < b * ld; i++) {
+            // Every fifth column of A is INF, so some k are skipped for a whole strip of rows.
+            A[i] = (rng() % 4 == 0 || i % ld % 5 == 0) ? inf : static_cast<T>(rng() % 100);
+            B[i] = (rng() % 4 == 0) ? inf : static_cast<T>(rng() % 100);
+            C[i] = (rng() % 2 == 0) ? inf : static_cast<T>(rng() % 200);
+        }
+        // Reference result from the scalar path.
+        tile_isa detected = detect_tile_isa();
+        ASSERT_TRUE(set_tile_isa(tile_isa::scalar));
+        std::vector<T> expected = C;
+        semiring_tile<S>(expected.data(), A.data(), B.data(), b, b, b, ld);
+        // Every supported vector path must agree with it.
+        for (tile_isa isa : {tile_isa::avx2, tile_isa::avx512}) {
+            if (!set_tile_isa(isa)) {
+                continue;
+            }
+            std::vector<T> result = C;
+            semiring_tile<S>(result.data(), A.data(), B.data(), b, b, b, ld);
+            ASSERT_EQ(expected, result) << tile_isa_name(isa) << " " << distance_traits<T>::name() << " " << S::name() << " b " << b;
+        }
+        set_tile_isa(detected);
+    }
+}
+
+TEST_F(FloydWarshallTest, TestTileIsa)
+{
+    check_tile_isa<int32_t>();
+    check_tile_isa<uint16_t>();
+    check_tile_isa<uint8_t>();
+    check_tile_isa<float>();
+    check_tile_isa<uint8_t, max_min>();
+    check_tile_isa<float, max_min>();
+    check_tile_isa<int32_t, max_plus>();
+    check_tile_isa<float, max_plus>();
+}
+
+/**
+ * @brief Runs the semiring-generic blocked kernels with `S` and `T` on `graph` (min-plus convention) and checks
+ *        them against `serial_floyd_warshall<T, S>`. Returns the result.
+ */
+template <typename T, typename S>
+static std::vector<T> check_semiring(const aligned_vector<int> & graph, int n, int b)
+{
+    std::vector<T> expected(graph.begin(), graph.end());
+    for (T & x : expected) {
+        x = x == INF ? distance_traits<T>::inf() : x;
+    }
+    semiring_from_distances<S>(expected.data(), n);
+    std::vector<T> blocked = expected, inplace = expected, task = expected;
+    serial_floyd_warshall<T, S>(expected.data(), n);
+    blocked_floyd_warshall<T, S>(blocked.data(), n, b);
+    inplace_blocked_floyd_warshall<T, S>(inplace.data(), n, b);
+    task_blocked_floyd_warshall<T, S>(task.data(), n, b);
+    for (std::vector<T> * result : {&expected, &blocked, &inplace, &task}) {
+        semiring_canonicalize<S>(result->data(), n);
+    }
+    EXPECT_EQ(expected, blocked) << S::name() << " " << distance_traits<T>::name();
+    EXPECT_EQ(expected, inplace) << S::name() << " " << distance_traits<T>::name();
+    EXPECT_EQ(expected, task) << S::name() << " " << distance_traits<T>::name();
+    return expected;
+}
+
+TEST_F(FloydWarshallTest, TestSemiring)
+{
+    // Ragged tiles; b = 32 also runs the fixed-size kernels on the independent phase.
+    int n = 203, b = 32;
+    graph_options options;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 50;
+    graph_1.assign(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 1500, options);
+    omp_set_num_threads(threads);
+
+    // Boolean: reachable exactly where the shortest distance is finite.
+    graph_2 = graph_1;
+    serial_floyd_warshall(graph_2.data(), n);
+    std::vector<uint8_t> reachable = check_semiring<uint8_t, or_and>(graph_1, n, b);
+    for (int x = 0; x < n * n; x++) {
+        ASSERT_EQ(reachable[x], graph_2[x] != INF) << x;
+    }
+
+    // Widest paths: capacity at least w exactly where the edges of capacity at least w reach.
+    std::vector<int32_t> widest = check_semiring<int32_t, max_min>(graph_1, n, b);
+    check_semiring<float, max_min>(graph_1, n, b);
+    int w = 25;
+    graph_2 = graph_1;
+    for (int x = 0; x < n * n; x++) {
+        graph_2[x] = (x % (n + 1) != 0 && graph_2[x] < w) ? INF : graph_2[x];
+    }
+    serial_floyd_warshall(graph_2.data(), n);
+    for (int x = 0; x < n * n; x++) {
+        ASSERT_EQ(widest[x] >= w, graph_2[x] != INF) << x;
+    }
+
+    // Longest paths of the DAG of the edges i -> j with i < j, by dynamic programming from the last vertex.
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < i; j++) {
+            graph_1[i * n + j] = INF;
+        }
+    }
+    std::vector<int32_t> longest = check_semiring<int32_t, max_plus>(graph_1, n, b);
+    check_semiring<float, max_plus>(graph_1, n, b);
+    const int32_t none = max_plus::zero<int32_t>();
+    std::vector<int32_t> dp(n * n, none);
+    for (int i = n - 1; i >= 0; i--) {
+        dp[i * n + i] = 0;
+        for (int m = i + 1; m < n; m++) {
+            if (graph_1[i * n + m] == INF) {
+                continue;
+            }
+            for (int j = m; j < n; j++) {
+                if (dp[m * n + j] != none) {
+                    dp[i * n + j] = std::max(dp[i * n + j], graph_1[i * n + m] + dp[m * n + j]);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(longest, dp);
+}
+
+TEST_F(FloydWarshallTest, TestAutotune)
+{
+    cache_sizes caches{32 * 1024, 256 * 1024, 0};
+    // Candidates are SIMD multiples or divisors of the vertex count, and keep three tiles within L2.
+    std::vector<int> candidates = candidate_block_lengths(vertices, caches, sizeof(int32_t));
+    ASSERT_FALSE(candidates.empty());
+    for (int b : candidates) {
+        ASSERT_TRUE(b % 8 == 0 || vertices % b == 0);
+        ASSERT_LE(3L * b * b * static_cast<long>(sizeof(int32_t)), caches.l2);
+    }
+    // The heuristic and the calibration sweep both pick one of the candidates.
+    int heuristic = heuristic_block_length(vertices, caches, sizeof(int32_t));
+    ASSERT_NE(std::find(candidates.begin(), candidates.end(), heuristic), candidates.end());
+    // Byte distances fit larger tiles in the same L2.
+    std::vector<int> narrow = candidate_block_lengths(vertices, caches, sizeof(uint8_t));
+    ASSERT_GT(narrow.back(), candidates.back());
+    ASSERT_LE(3L * narrow.back() * narrow.back(), caches.l2);
+    ASSERT_GT(heuristic_block_length(vertices, caches, sizeof(uint8_t)), heuristic);
+    omp_set_num_threads(threads);
+    std::vector<int> sweep{20, 48};
+    int tuned = calibrate_block_length(inplace_blocked_floyd_warshall<int32_t>, vertices, edges, sweep);
+    ASSERT_TRUE(tuned == 20 || tuned == 48);
+    tuned = calibrate_block_length(inplace_blocked_floyd_warshall<uint16_t>, vertices, edges, sweep);
+    ASSERT_TRUE(tuned == 20 || tuned == 48);
+}
+
+TEST_F(FloydWarshallTest, TestPadding)
+{
+    // Vertex count is not a multiple of the tile length.
+    int n = 203;
+    graph_1.resize(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 400);
+    graph_2 = graph_1;
+    graph_3 = graph_1;
+    omp_set_num_threads(threads);
+    serial_floyd_warshall(graph_1.data(), n);
+    // Padded copy in the blocked kernel, ragged edge tiles in the zero-copy kernel.
+    blocked_floyd_warshall(graph_2.data(), n, tile_length);
+    inplace_blocked_floyd_warshall(graph_3.data(), n, tile_length);
+    ASSERT_EQ(graph_1, graph_2);
+    ASSERT_EQ(graph_1, graph_3);
+}
+
+TEST_F(FloydWarshallTest, TestTaskBlocked)
+{
+    graph_1.resize(vertices * vertices, INF);
+    generate_linear_graph(graph_1.data(), vertices, edges);
+    graph_2 = graph_1;
+    omp_set_num_threads(threads);
+    serial_floyd_warshall(graph_1.data(), vertices);
+    task_blocked_floyd_warshall(graph_2.data(), vertices, tile_length);
+    ASSERT_EQ(graph_1, graph_2);
+}
+
+TEST_F(FloydWarshallTest, TestPersistent)
+{
+    // Ragged sizes give an uneven last tile row and static chunks of different lengths.
+    for (int n : {vertices, 97}) {
+        graph_1.assign(n * n, INF);
+        generate_linear_graph(graph_1.data(), n, 4 * n);
+        graph_2 = graph_1;
+        graph_3 = graph_1;
+        serial_floyd_warshall(graph_1.data(), n);
+        for (int t : {1, threads, 3}) {
+            omp_set_num_threads(t);
+            aligned_vector<int> naive = graph_2;
+            persistent_naive_floyd_warshall(naive.data(), n);
+            ASSERT_EQ(graph_1, naive) << "n " << n << ", threads " << t;
+            aligned_vector<int> blocked = graph_3;
+            persistent_blocked_floyd_warshall(blocked.data(), n, tile_length);
+            ASSERT_EQ(graph_1, blocked) << "n " << n << ", threads " << t;
+        }
+    }
+}
+
+TEST_F(FloydWarshallTest, TestRecursive)
+{
+    // Ragged sizes leave an uneven last leaf in every dimension; leaf 1 recurses all the way down, so it runs on
+    // the small size only.
+    for (int n : {vertices, 97}) {
+        graph_3.assign(n * n, INF);
+        generate_linear_graph(graph_3.data(), n, 4 * n);
+        graph_1 = graph_3;
+        serial_floyd_warshall(graph_1.data(), n);
+        std::vector<int> leaves{7, tile_length, n};
+        if (n == 97) {
+            leaves.push_back(1);
+        }
+        for (int leaf : leaves) {
+            graph_2 = graph_3;
+            omp_set_num_threads(threads);
+            recursive_floyd_warshall(graph_2.data(), n, leaf);
+            ASSERT_EQ(graph_1, graph_2) << "n " << n << ", leaf " << leaf;
+        }
+    }
+}
+
+TEST_F(FloydWarshallTest, TestSolverBatch)
+{
+    // Enough matrices of mixed, ragged sizes for the one-matrix-per-thread path, and too few for it.
+    std::vector<std::vector<float>> inputs;
+    for (int m = 0; m < 37; m++) {
+        int n = 20 + (m * 7) % 45;
+        graph_options options;
+        options.seed = m;
+        options.weights = weight_distribution::uniform;
+        options.max_weight = 50;
+        inputs.emplace_back(n * n);
+        generate_linear_graph(inputs.back().data(), n, 4 * n, options);
+    }
+    std::vector<std::vector<float>> expected = inputs;
+    for (std::vector<float> & W : expected) {
+        serial_floyd_warshall(W.data(), static_cast<int>(std::sqrt(W.size())));
+    }
+
+    for (solver_kernel kernel : {solver_kernel::blocked, solver_kernel::zero_copy, solver_kernel::task, solver_kernel::recursive}) {
+        floyd_warshall_solver<float> solver({kernel, 16, 4});
+        ASSERT_EQ(solver.threads(), 4);
+        ASSERT_EQ(solver.block_length(10), 10);
+        for (size_t count : {inputs.size(), size_t{3}}) {
+            std::vector<std::vector<float>> results(inputs.begin(), inputs.begin() + count);
+            std::vector<batch_matrix<float>> batch;
+            for (std::vector<float> & W : results) {
+                batch.push_back({W.data(), static_cast<int>(std::sqrt(W.size()))});
+            }
+            solver.solve_batch(batch);
+            for (size_t m = 0; m < count; m++) {
+                ASSERT_EQ(results[m], expected[m]) << "matrix " << m << " of " << count;
+            }
+        }
+    }
+    for (int b : {0, 5}) {
+        floyd_warshall_solver<float> solver({solver_kernel::zero_copy, b, 4, true});
+        if (b > 0) {
+            ASSERT_EQ(solver.interleaved_block_length(37), b);
+        }
+        std::vector<std::vector<float>> results = inputs;
+        std::vector<batch_matrix<float>> batch;
+        for (std::vector<float> & W : results) {
+            batch.push_back({W.data(), static_cast<int>(std::sqrt(W.size()))});
+        }
+        solver.solve_batch(batch);
+        ASSERT_EQ(results, expected) << "interleaved";
+        if (b > 0) {
+            // Ragged tiles, and fewer graphs than lanes with saturating sums.
+            int n = 23;
+            std::vector<std::vector<uint16_t>> graphs(3, std::vector<uint16_t>(n * n));
+            std::vector<uint16_t *> lanes;
+            for (std::vector<uint16_t> & W : graphs) {
+                generate_linear_graph(W.data(), n, 3 * n);
+                lanes.push_back(W.data());
+            }
+            std::vector<std::vector<uint16_t>> solved = graphs;
+            for (std::vector<uint16_t> & W : solved) {
+                serial_floyd_warshall(W.data(), n);
+            }
+            std::vector<uint16_t> interleaved(n * n * interleave_lanes<uint16_t>());
+            interleave_matrices<uint16_t>(lanes.data(), 3, n, interleaved.data());
+            interleaved_floyd_warshall(interleaved.data(), n, b);
+            deinterleave_matrices<uint16_t>(interleaved.data(), 3, n, lanes.data());
+            ASSERT_EQ(graphs, solved);
+        }
+    }
+    floyd_warshall_solver<float> solver;
+    std::vector<float> W = inputs[0];
+    solver.solve(W.data(), static_cast<int>(std::sqrt(W.size())));
+    ASSERT_EQ(W, expected[0]);
+}
+
+#ifdef FW_OFFLOAD
+TEST_F(FloydWarshallTest, TestOffload)
+{
+    // Ragged last tile; runs on the host when no target device is present.
+    int n = 97;
+    graph_1.assign(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 4 * n);
+    graph_2 = graph_1;
+    serial_floyd_warshall(graph_1.data(), n);
+    ASSERT_EQ(offload_floyd_warshall(graph_2.data(), n, 16), 1);
+    ASSERT_EQ(graph_1, graph_2);
+}
+#endif
+
+#ifdef FW_INSTRUMENT
+TEST_F(FloydWarshallTest, TestInstrument)
+{
+    // Recording changes no result, and every thread of every phase and round lands in the trace.
+    int n = 100;
+    graph_1.assign(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 4 * n);
+    graph_2 = graph_1;
+    serial_floyd_warshall(graph_1.data(), n);
+    ASSERT_EQ(instrument_start(false), 1);
+    inplace_blocked_floyd_warshall(graph_2.data(), n, 16);
+    instrument_stop();
+    ASSERT_EQ(graph_1, graph_2);
+
+    std::string path = testing::TempDir() + "fw_test_trace.json";
+    ASSERT_EQ(write_chrome_trace(path), 1);
+    std::ifstream file(path);
+    std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_NE(trace.find("\"name\": \"independent\", \"cat\": \"region\""), std::string::npos);
+    ASSERT_NE(trace.find("\"name\": \"panels\", \"cat\": \"thread\""), std::string::npos);
+    ASSERT_NE(trace.find("\"k\": 6"), std::string::npos);
+    file.close();
+    std::remove(path.c_str());
+}
+#endif
+
+/**
+ * @brief Solves the fixture graph in distance type `T` with every kernel and checks it against the int32 result.
+ */
+template <typename T>
+static void check_distance_type(const aligned_vector<int> & graph, const aligned_vector<int> & expected, int vertices, int tile_length)
+{
+    std::vector<T> narrow(graph.size());
+    for (size_t i = 0; i < graph.size(); i++) {
+        narrow[i] = (graph[i] == INF) ? distance_traits<T>::inf() : static_cast<T>(graph[i]);
+    }
+    std::vector<std::vector<T>> results(6, narrow);
+    serial_floyd_warshall(results[0].data(), vertices);
+    naive_floyd_warshall(results[1].data(), vertices);
+    blocked_floyd_warshall(results[2].data(), vertices, tile_length);
+    inplace_blocked_floyd_warshall(results[3].data(), vertices, tile_length);
+    task_blocked_floyd_warshall(results[4].data(), vertices, tile_length);
+    recursive_floyd_warshall(results[5].data(), vertices, tile_length);
+    for (const std::vector<T> & result : results) {
+        for (size_t i = 0; i < expected.size(); i++) {
+            if (expected[i] == INF) {
+                ASSERT_EQ(result[i], distance_traits<T>::inf()) << distance_traits<T>::name();
+            }
+            else {
+                ASSERT_EQ(result[i], static_cast<T>(expected[i])) << distance_traits<T>::name();
+            }
+        }
+    }
+}
+
+TEST_F(FloydWarshallTest, TestDistanceTypes)
+{
+    // Smaller graph with ragged tiles; unit weights keep every distance well below the uint8 INF.
+    int n = 310;
+    graph_1.resize(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 600);
+    graph_2 = graph_1;
+    omp_set_num_threads(threads);
+    serial_floyd_warshall(graph_2.data(), n);
+    check_distance_type<uint16_t>(graph_1, graph_2, n, tile_length);
+    check_distance_type<uint8_t>(graph_1, graph_2, n, tile_length);
+    check_distance_type<float>(graph_1, graph_2, n, tile_length);
+}
+
+TEST_F(FloydWarshallTest, TestMatrixIO)
+{
+    int n = 150;
+    std::string path = testing::TempDir() + "fw_test_matrix.bin";
+    graph_1.resize(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 300);
+
+    // Write through a shared mapping.
+    mapped_matrix out;
+    ASSERT_EQ(create_matrix(path, dtype_of<int32_t>(), n, tile_length, out), 1);
+    std::copy(graph_1.begin(), graph_1.end(), static_cast<int *>(out.data));
+    unmap_matrix(out);
+
+    // The header round-trips and the matrix is page aligned.
+    matrix_header header;
+    ASSERT_EQ(read_matrix_header(path, header), 1);
+    ASSERT_EQ(header.vertices, static_cast<uint64_t>(n));
+    ASSERT_EQ(header.dtype, static_cast<uint32_t>(matrix_dtype::int32));
+    ASSERT_EQ(header.block_length, static_cast<uint32_t>(tile_length));
+
+    // Solving on a private mapping matches the in-memory result and leaves the file untouched.
+    mapped_matrix in;
+    ASSERT_EQ(map_matrix(path, in, false), 1);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(in.data) % 64, 0u);
+    int *mapped = static_cast<int *>(in.data);
+    inplace_blocked_floyd_warshall(mapped, n, tile_length);
+    graph_2 = graph_1;
+    serial_floyd_warshall(graph_2.data(), n);
+    ASSERT_TRUE(std::equal(graph_2.begin(), graph_2.end(), mapped));
+
+    // Reverting drops the private writes in place, and the mapping can be solved again.
+    ASSERT_EQ(revert_matrix(in), 1);
+    ASSERT_EQ(static_cast<int *>(in.data), mapped);
+    ASSERT_TRUE(std::equal(graph_1.begin(), graph_1.end(), mapped));
+    inplace_blocked_floyd_warshall(mapped, n, tile_length);
+    ASSERT_TRUE(std::equal(graph_2.begin(), graph_2.end(), mapped));
+    unmap_matrix(in);
+
+    ASSERT_EQ(map_matrix(path, in, false), 1);
+    ASSERT_TRUE(std::equal(graph_1.begin(), graph_1.end(), static_cast<int *>(in.data)));
+    unmap_matrix(in);
+    std::remove(path.c_str());
+}
+
+TEST_F(FloydWarshallTest, TestOutOfCore)
+{
+    // 150 vertices in strips of 40 rows: four strips, the last one ragged, and ragged tiles inside each.
+    int n = 150;
+    int b = 8;
+    std::string source = testing::TempDir() + "fw_test_source.bin";
+    std::string path = testing::TempDir() + "fw_test_out_of_core.bin";
+    graph_options options;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 20;
+    ASSERT_EQ(stream_generate_matrix<int32_t>(source, n, 600, options, b, 40), 1);
+    ASSERT_EQ(stream_copy_matrix<int32_t>(source, path, b, 16), 1);
+    ASSERT_EQ(out_of_core_floyd_warshall<int32_t>(path, b, 40), 1);
+    ASSERT_EQ(out_of_core_floyd_warshall<int32_t>(path, 7, 40), -1);
+    ASSERT_EQ(out_of_core_floyd_warshall<float>(path, b, 40), -1);
+
+    graph_1.assign(n * n, INF);
+    generate_linear_graph(graph_1.data(), n, 600, options);
+    serial_floyd_warshall(graph_1.data(), n);
+    mapped_matrix solved;
+    ASSERT_EQ(map_matrix(path, solved, false), 1);
+    ASSERT_TRUE(std::equal(graph_1.begin(), graph_1.end(), static_cast<int *>(solved.data)));
+    unmap_matrix(solved);
+    ASSERT_EQ(strip_rows_for_budget(n, sizeof(int32_t), b, 4 * 40 * n * sizeof(int32_t)), 40);
+    ASSERT_EQ(strip_rows_for_budget(n, sizeof(int32_t), b, 1), b);
+    std::remove(source.c_str());
+    std::remove(path.c_str());
+}
+
+TEST_F(FloydWarshallTest, TestTimestamps)
+{
+    // One outlier moves the mean and the maximum, not the median.
+    std::vector<std::tuple<std::string, double>> timestamps;
+    for (int i = 0; i < 10; i++) {
+        double ns = i == 0 ? 1000.0 : 100.0 + i;
+        mark_time(timestamps, ns, "Kernel time, iteration: " + std::to_string(i));
+    }
+    double once = 7.0;
+    mark_time(timestamps, once, "Generate time");
+    ASSERT_EQ(timestamp_phase("Kernel time, iteration: 12"), "Kernel time");
+    ASSERT_EQ(timestamp_phase("Average execution time"), "Average execution time");
+
+    std::vector<timing_summary> summaries = summarize_timestamps(timestamps);
+    ASSERT_EQ(summaries.size(), 2u);
+    const timing_summary & kernel = summaries[0];
+    ASSERT_EQ(kernel.phase, "Kernel time");
+    ASSERT_EQ(kernel.samples, 10);
+    ASSERT_DOUBLE_EQ(kernel.min, 101.0);
+    ASSERT_DOUBLE_EQ(kernel.max, 1000.0);
+    ASSERT_DOUBLE_EQ(kernel.median, 105.5);
+    ASSERT_DOUBLE_EQ(kernel.mean, (1000.0 + 9 * 100.0 + 45.0) / 10);
+    ASSERT_GT(kernel.p95, 109.0);
+    ASSERT_LT(kernel.ci_low, kernel.mean);
+    ASSERT_GT(kernel.ci_high, kernel.mean);
+    ASSERT_EQ(summaries[1].samples, 1);
+    ASSERT_DOUBLE_EQ(summaries[1].stddev, 0.0);
+
+    std::string path = testing::TempDir() + "fw_test_timings.csv";
+    ASSERT_EQ(write_timestamps(path, "csv", timestamps, summaries), 1);
+    ASSERT_EQ(write_timestamps(path, "xml", timestamps, summaries), -1);
+    std::remove(path.c_str());
+}
+
+TEST_F(FloydWarshallTest, TestGenerator)
+{
+    int n = 300;
+    auto count_edges = [n](const aligned_vector<int> & graph) {
+        long count = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (i != j && graph[i * n + j] != INF) {
+                    count++;
+                }
+            }
+        }
+        return count;
+    };
+
+    graph_options options;
+    options.seed = 42;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 50;
+    for (graph_topology topology : {graph_topology::erdos_renyi, graph_topology::power_law}) {
+        options.topology = topology;
+
+        // The same seed gives the same graph regardless of the thread count.
+        graph_1.resize(n * n);
+        graph_2.resize(n * n);
+        omp_set_num_threads(1);
+        ASSERT_EQ(generate_linear_graph(graph_1.data(), n, 5000, options), 1);
+        omp_set_num_threads(4);
+        ASSERT_EQ(generate_linear_graph(graph_2.data(), n, 5000, options), 1);
+        ASSERT_EQ(graph_1, graph_2);
+        ASSERT_EQ(count_edges(graph_1), 5000);
+        for (int i = 0; i < n; i++) {
+            ASSERT_EQ(graph_1[i * n + i], 0);
+        }
+        ASSERT_TRUE(std::all_of(graph_1.begin(), graph_1.end(), [](int w) { return w == INF || (w >= 0 && w <= 50); }));
+
+        // Any row range reproduces the same rows of the full graph.
+        std::vector<int> rows(37 * n);
+        ASSERT_EQ(generate_graph_rows(rows.data(), n, 5000, 101, 37, options), 1);
+        ASSERT_TRUE(std::equal(rows.begin(), rows.end(), graph_1.begin() + 101 * n));
+
+        // Dense requests take the fill-and-thin path and still hit the exact count.
+        ASSERT_EQ(generate_linear_graph(graph_1.data(), n, n * (n - 1) - 10, options), 1);
+        ASSERT_EQ(count_edges(graph_1), n * (n - 1) - 10);
+    }
+
+    // Another seed gives another graph.
+    options.topology = graph_topology::erdos_renyi;
+    generate_linear_graph(graph_1.data(), n, 5000, options);
+    options.seed = 43;
+    generate_linear_graph(graph_2.data(), n, 5000, options);
+    ASSERT_NE(graph_1, graph_2);
+
+    // A 10x10 grid has 2 * 2 * 10 * 9 directed lattice edges.
+    options.topology = graph_topology::grid;
+    options.weights = weight_distribution::unit;
+    std::vector<int> grid(100 * 100);
+    ASSERT_EQ(generate_linear_graph(grid.data(), 100, 0, options), 1);
+    ASSERT_EQ(std::count(grid.begin(), grid.end(), 1), 360);
+    serial_floyd_warshall(grid.data(), 100);
+    ASSERT_EQ(grid[0 * 100 + 99], 18);
+
+    ASSERT_EQ(generate_linear_graph(graph_1.data(), n, n * n, options), 1);
+    options.topology = graph_topology::erdos_renyi;
+    ASSERT_EQ(generate_linear_graph(graph_1.data(), n, n * n, options), -1);
+    omp_set_num_threads(threads);
+}
+
+template <typename T>
+static void check_sparse(int n, int edges, weight_distribution weights)
+{
+    graph_options options;
+    options.seed = 9;
+    options.weights = weights;
+    options.max_weight = 20;
+    std::vector<T> graph(n * n);
+    generate_linear_graph(graph.data(), n, edges, options);
+    std::vector<T> reference = graph;
+    serial_floyd_warshall(reference.data(), n);
+    sparse_shortest_paths(graph.data(), n);
+    ASSERT_EQ(graph, reference) << distance_traits<T>::name();
+}
+
+TEST_F(FloydWarshallTest, TestSparse)
+{
+    omp_set_num_threads(4);
+    // BFS path (unit weights) and Dijkstra path, including saturation in the narrow types.
+    for (weight_distribution weights : {weight_distribution::unit, weight_distribution::uniform}) {
+        check_sparse<int32_t>(257, 700, weights);
+        check_sparse<uint16_t>(257, 700, weights);
+        check_sparse<uint8_t>(257, 400, weights);
+        check_sparse<float>(257, 700, weights);
+    }
+
+    std::vector<int> graph(6 * 6, INF);
+    for (int i = 0; i < 6; i++) {
+        graph[i * 6 + i] = 0;
+    }
+    graph[0 * 6 + 1] = 4;
+    graph[1 * 6 + 2] = 3;
+    csr_graph<int> csr = build_csr(graph.data(), 6);
+    ASSERT_EQ(csr.offsets.back(), 2);
+    ASSERT_FALSE(csr.unit_weights);
+    omp_set_num_threads(threads);
+}
+
+/**
+ * Checks that every route in `next` walks real edges of `original` and adds up to the solved distance.
+ */
+template <typename T, typename I>
+static void check_routes(const std::vector<T> & original, const std::vector<T> & solved, const std::vector<I> & next, int n)
+{
+    const T inf = distance_traits<T>::inf();
+    for (int u = 0; u < n; u += 7) {
+        for (int v = 0; v < n; v++) {
+            std::vector<int> path = reconstruct_path(next.data(), n, u, v);
+            if (solved[u * n + v] == inf) {
+                ASSERT_TRUE(path.empty());
+                continue;
+            }
+            ASSERT_FALSE(path.empty());
+            ASSERT_EQ(path.front(), u);
+            ASSERT_EQ(path.back(), v);
+            T length = 0;
+            for (size_t h = 1; h < path.size(); h++) {
+                T edge = original[path[h - 1] * n + path[h]];
+                ASSERT_NE(edge, inf);
+                length = distance_traits<T>::add(length, edge);
+            }
+            ASSERT_EQ(length, solved[u * n + v]);
+        }
+    }
+}
+
+template <typename T, typename I>
+static void check_paths(int n, int b)
+{
+    graph_options options;
+    options.seed = 3;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 9;
+    std::vector<T> original(n * n);
+    generate_linear_graph(original.data(), n, 4 * n, options);
+    std::vector<T> reference = original;
+    serial_floyd_warshall(reference.data(), n);
+
+    std::vector<I> next(n * n);
+    std::vector<T> graph = original;
+    serial_floyd_warshall(graph.data(), next.data(), n);
+    ASSERT_EQ(graph, reference);
+    check_routes(original, graph, next, n);
+
+    graph = original;
+    naive_floyd_warshall(graph.data(), next.data(), n);
+    ASSERT_EQ(graph, reference);
+    check_routes(original, graph, next, n);
+
+    tile_isa best = detect_tile_isa();
+    for (tile_isa isa : {tile_isa::scalar, tile_isa::avx2, tile_isa::avx512}) {
+        if (!set_tile_isa(isa)) {
+            continue;
+        }
+        graph = original;
+        blocked_floyd_warshall(graph.data(), next.data(), n, b);
+        ASSERT_EQ(graph, reference) << tile_isa_name(isa);
+        check_routes(original, graph, next, n);
+    }
+    set_tile_isa(best);
+}
+
+TEST_F(FloydWarshallTest, TestPaths)
+{
+    ASSERT_EQ(next_hop_bytes(254), 1);
+    ASSERT_EQ(next_hop_bytes(255), 2);
+    ASSERT_EQ(next_hop_bytes(70000), 4);
+
+    check_paths<int32_t, uint8_t>(203, 32);
+    check_paths<int32_t, uint16_t>(300, 64);
+    check_paths<uint8_t, uint16_t>(300, 40);
+    check_paths<uint16_t, uint32_t>(150, 37);
+    check_paths<float, uint8_t>(100, 16);
+}
+
+template <typename T>
+static void check_query(int n)
+{
+    std::vector<T> W(n * n);
+    generate_linear_graph(W.data(), n, 4 * n);
+    inplace_blocked_floyd_warshall(W.data(), n, 32);
+    query_engine<T> engine(W.data(), n);
+
+    // Batched lookups match single ones, including the tail after the last full gather and every ISA.
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> vertex(0, n - 1);
+    std::vector<int> sources(1001), targets(1001);
+    for (size_t x = 0; x < sources.size(); ++x) {
+        sources[x] = vertex(rng);
+        targets[x] = vertex(rng);
+    }
+    sources.back() = n - 1;
+    targets.back() = n - 1;
+    for (tile_isa isa : {tile_isa::scalar, tile_isa::avx2, tile_isa::avx512}) {
+        if (!set_tile_isa(isa)) {
+            continue;
+        }
+        std::vector<T> out(sources.size());
+        engine.distances(sources.data(), targets.data(), static_cast<int>(sources.size()), out.data());
+        for (size_t x = 0; x < sources.size(); ++x) {
+            ASSERT_EQ(out[x], W[sources[x] * n + targets[x]]) << distance_traits<T>::name() << " " << tile_isa_name(isa);
+        }
+    }
+    set_tile_isa(detect_tile_isa());
+    ASSERT_EQ(engine.row(5), W.data() + 5 * n);
+    ASSERT_FALSE(engine.has_paths());
+    ASSERT_TRUE(engine.path(0, 1).empty());
+}
+
+/**
+ * @brief Sends `request` to the query server on `path` and returns the response up to the newline.
+ */
+static std::string query_server(const std::string & path, const std::string & request)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return "connect failed";
+    }
+    std::string line = request + "\n";
+    send(fd, line.data(), line.size(), 0);
+    std::string response;
+    char c;
+    while (read(fd, &c, 1) == 1 && c != '\n') {
+        response.push_back(c);
+    }
+    close(fd);
+    return response;
+}
+
+TEST_F(FloydWarshallTest, TestQuery)
+{
+    check_query<int32_t>(203);
+    check_query<uint16_t>(150);
+    check_query<uint8_t>(97);
+    check_query<float>(64);
+
+    // Serve a solve with next hops and compare the answers with the matrix.
+    int n = 60;
+    std::vector<int32_t> W(n * n);
+    generate_linear_graph(W.data(), n, 3 * n);
+    std::vector<uint8_t> next(n * n);
+    serial_floyd_warshall(W.data(), next.data(), n);
+    query_engine<int32_t> engine(W.data(), n);
+    engine.set_next_hops(next.data());
+    ASSERT_TRUE(engine.has_paths());
+
+    std::string path = testing::TempDir() + "fw_test_query.sock";
+    std::atomic<bool> stop{false}, ready{false};
+    int status = 0;
+    std::thread server([&] { status = serve_queries(engine, path, 2, &stop, &ready); });
+    while (!ready.load()) {
+        std::this_thread::yield();
+    }
+    auto text = [](int32_t w) { return w == INF ? std::string("INF") : std::to_string(w); };
+    ASSERT_EQ(query_server(path, "dist 3 7"), text(W[3 * n + 7]));
+    ASSERT_EQ(query_server(path, "dists 0 1 2 3 59 0"), text(W[1]) + " " + text(W[2 * n + 3]) + " " + text(W[59 * n]));
+    std::string row = query_server(path, "row 4");
+    ASSERT_EQ(std::count(row.begin(), row.end(), ' '), n - 1);
+    std::vector<int> route = reconstruct_path(next.data(), n, 2, 9);
+    ASSERT_EQ(query_server(path, "path 2 9"), route.empty() ? "unreachable" : fmt::format("{}", fmt::join(route, " ")));
+    ASSERT_EQ(query_server(path, "info"), "vertices 60 dtype int32 paths 1");
+    ASSERT_EQ(query_server(path, "dist 3 60").substr(0, 3), "ERR");
+    ASSERT_EQ(query_server(path, "dists 1").substr(0, 3), "ERR");
+    ASSERT_EQ(query_server(path, "bogus").substr(0, 3), "ERR");
+    // A line past the cap is refused, and the server keeps serving.
+    ASSERT_EQ(query_server(path, std::string(3 << 20, '7')).substr(0, 3), "ERR");
+    ASSERT_EQ(query_server(path, "dist 3 7"), text(W[3 * n + 7]));
+    // Both workers tokenize at once.
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> clients;
+    for (int c = 0; c < 2; ++c) {
+        clients.emplace_back([&, c] {
+            for (int q = 0; q < 50; ++q) {
+                int i = (c * 50 + q) % n, j = (q * 7) % n;
+                if (query_server(path, fmt::format("dists {} {} {} {}", i, j, j, i)) != text(W[i * n + j]) + " " + text(W[j * n + i])) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+    for (std::thread & client : clients) {
+        client.join();
+    }
+    ASSERT_EQ(mismatches.load(), 0);
+    ASSERT_EQ(query_server(path, "shutdown"), "OK");
+    server.join();
+    ASSERT_EQ(status, 1);
+    ASSERT_NE(access(path.c_str(), F_OK), 0);
+
+    // The stop flag ends a server too.
+    ready = false;
+    std::thread stopped([&] { status = serve_queries(engine, path, 1, &stop, &ready); });
+    while (!ready.load()) {
+        std::this_thread::yield();
+    }
+    stop = true;
+    stopped.join();
+    ASSERT_EQ(status, 1);
+}
+
+template <typename T>
+static void check_incremental(int n)
+{
+    graph_options options;
+    options.seed = 5;
+    options.weights = weight_distribution::uniform;
+    options.max_weight = 30;
+    std::vector<T> original(n * n);
+    generate_linear_graph(original.data(), n, 3 * n, options);
+    std::vector<T> solved = original;
+    inplace_blocked_floyd_warshall(solved.data(), n, 32);
+
+    // Insertions and decreases, checked against solving the changed graph from scratch.
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> vertex(0, n - 1);
+    std::uniform_int_distribution<int> weight(0, 10);
+    std::vector<edge_update<T>> updates;
+    for (int e = 0; e < 40; e++) {
+        edge_update<T> update{vertex(rng), vertex(rng), static_cast<T>(weight(rng))};
+        if (update.u == update.v) {
+            continue;
+        }
+        updates.push_back(update);
+        original[update.u * n + update.v] = std::min(original[update.u * n + update.v], update.w);
+    }
+    std::vector<T> reference = original;
+    serial_floyd_warshall(reference.data(), n);
+
+    std::vector<T> single = solved;
+    for (const edge_update<T> & update : updates) {
+        ASSERT_NE(apply_edge_decrease(single.data(), n, update.u, update.v, update.w), -1);
+    }
+    ASSERT_EQ(single, reference) << distance_traits<T>::name();
+
+    std::vector<T> batched = solved;
+    ASSERT_GT(apply_edge_decreases(batched.data(), n, updates), 0);
+    ASSERT_EQ(batched, reference) << distance_traits<T>::name();
+}
+
+TEST_F(FloydWarshallTest, TestIncremental)
+{
+    omp_set_num_threads(4);
+    check_incremental<int32_t>(230);
+    check_incremental<uint16_t>(230);
+    check_incremental<uint8_t>(230);
+    check_incremental<float>(230);
+
+    // The next-hop variant keeps routes valid.
+    int n = 120;
+    std::vector<int> original(n * n);
+    generate_linear_graph(original.data(), n, 2 * n);
+    std::vector<int> solved = original;
+    std::vector<uint8_t> next(n * n);
+    serial_floyd_warshall(solved.data(), next.data(), n);
+    ASSERT_EQ(apply_edge_decrease(solved.data(), next.data(), n, 3, 97, 0), 1);
+    original[3 * n + 97] = 0;
+    std::vector<int> reference = original;
+    serial_floyd_warshall(reference.data(), n);
+    ASSERT_EQ(solved, reference);
+    check_routes(original, solved, next, n);
+
+    // Batches alternating between non-improving and improving updates, on more threads than the host has CPUs:
+    // every thread must agree on every decision. Checked against applying the updates one at a time.
+    for (int round = 0; round < 20; round++) {
+        std::vector<edge_update<int>> alternating;
+        for (int e = 0; e < 30; e++) {
+            int u = (7 * e + round) % n;
+            int v = (13 * e + 5 * round + 1) % n;
+            if (u != v) {
+                // Never below the solved distance, so never an improvement; or a zero-weight shortcut.
+                alternating.push_back({u, v, e % 2 == 0 ? reference[u * n + v] : 0});
+            }
+        }
+        omp_set_num_threads(1);
+        std::vector<int> expected = reference;
+        int improving = 0;
+        for (const edge_update<int> & update : alternating) {
+            improving += apply_edge_decrease(expected.data(), n, update.u, update.v, update.w);
+        }
+        omp_set_num_threads(8);
+        std::vector<int> batched = reference;
+        ASSERT_EQ(apply_edge_decreases(batched.data(), n, alternating), improving);
+        ASSERT_EQ(batched, expected);
+    }
+    omp_set_num_threads(4);
+
+    // No improvement and invalid edges.
+    ASSERT_EQ(apply_edge_decrease(solved.data(), n, 3, 97, 5), 0);
+    ASSERT_EQ(apply_edge_decrease(solved.data(), n, 3, n, 1), -1);
+    std::vector<edge_update<int>> invalid{{0, 1, 1}, {-1, 2, 1}};
+    ASSERT_EQ(apply_edge_decreases(solved.data(), n, invalid), -1);
+    omp_set_num_threads(threads);
+}
+
+TEST_F(FloydWarshallTest, TestNuma)
+{
+    omp_set_num_threads(4);
+    int n = 203;
+    std::unique_ptr<int[]> matrix(new int[n * n]);
+    first_touch(matrix.get(), n, 32, INF);
+    ASSERT_TRUE(std::all_of(matrix.get(), matrix.get() + n * n, [](int w) { return w == INF; }));
+
+    graph_1.resize(n * n);
+    generate_linear_graph(graph_1.data(), n, 500);
+    copy_matrix(matrix.get(), graph_1.data(), n, 32);
+    ASSERT_TRUE(std::equal(graph_1.begin(), graph_1.end(), matrix.get()));
+
+    numa_topology topology = read_numa_topology();
+    ASSERT_FALSE(topology.node_cpus.empty());
+    ASSERT_FALSE(topology.allowed_cpus.empty());
+
+    // Pinned threads run on allowed CPUs; 'none' restores the process affinity afterwards.
+    for (bind_policy policy : {bind_policy::close, bind_policy::spread, bind_policy::none}) {
+        ASSERT_EQ(bind_threads(policy, topology), 1) << bind_policy_name(policy);
+        for (const thread_placement & placement : thread_placements(topology)) {
+            ASSERT_NE(std::find(topology.allowed_cpus.begin(), topology.allowed_cpus.end(), placement.cpu), topology.allowed_cpus.end());
+        }
+    }
+
+    std::vector<long> pages = page_nodes(matrix.get(), n * n * sizeof(int), topology.node_cpus.size());
+    ASSERT_EQ(pages.size(), topology.node_cpus.size());
+
+    bind_policy policy = bind_policy::none;
+    ASSERT_TRUE(parse_bind_policy("spread", policy));
+    ASSERT_EQ(policy, bind_policy::spread);
+    ASSERT_FALSE(parse_bind_policy("scatter", policy));
+    omp_set_num_threads(threads);
+}
+
+TEST_F(FloydWarshallTest, TestAllocator)
+{
+    // Every mode hands out aligned memory; large blocks fall back rather than fail.
+    for (hugepage_mode mode : {hugepage_mode::none, hugepage_mode::transparent, hugepage_mode::explicit_pages}) {
+        aligned_buffer<int> small(1000, mode);
+        aligned_buffer<int> large(3 * hugepage_size / sizeof(int) + 5, mode);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(small.data()) % matrix_alignment, 0u);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(large.data()) % matrix_alignment, 0u);
+        ASSERT_EQ(small.backing(), memory_backing::heap);
+        ASSERT_NE(large.backing(), memory_backing::none);
+        if (mode == hugepage_mode::none) {
+            ASSERT_EQ(large.backing(), memory_backing::heap);
+        }
+        std::fill(large.data(), large.data() + large.size(), 7);
+        aligned_buffer<int> moved = std::move(large);
+        ASSERT_EQ(moved[moved.size() - 1], 7);
+        ASSERT_EQ(large.data(), nullptr);
+    }
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(graph_1.data()) % matrix_alignment, 0u);
+
+    // Scratch is per thread and only grows.
+    int * scratch = tile_scratch<int>(256);
+    ASSERT_EQ(tile_scratch<int>(128), scratch);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(tile_scratch<int>(1 << 16)) % matrix_alignment, 0u);
+    std::vector<int *> per_thread(4);
+    #pragma omp parallel num_threads(4)
+    per_thread[omp_get_thread_num()] = tile_scratch<int>(64);
+    std::sort(per_thread.begin(), per_thread.end());
+    ASSERT_EQ(std::unique(per_thread.begin(), per_thread.end()), per_thread.end());
+
+    // The blocked kernel on scratch tiles still matches the serial result, with and without padding.
+    for (int n : {240, 203}) {
+        graph_1.assign(n * n, INF);
+        generate_linear_graph(graph_1.data(), n, 3 * n);
+        graph_2 = graph_1;
+        serial_floyd_warshall(graph_1.data(), n);
+        blocked_floyd_warshall(graph_2.data(), n, 24);
+        ASSERT_EQ(graph_1, graph_2);
+    }
+}
+
+TEST_F(FloydWarshallTest, TestScaling)
+{
+    // Weak-scaling sizes keep n^3 / threads constant: the sizes the weak scaling script hard-coded.
+    ASSERT_EQ(weak_scaling_vertices(1000, 1, 1), 1000);
+    ASSERT_EQ(weak_scaling_vertices(1000, 1, 2), 1260);
+    ASSERT_EQ(weak_scaling_vertices(1000, 1, 32), 3175);
+    ASSERT_EQ(weak_scaling_vertices(1000, 2, 16), 2000);
+
+    // n rounds untiled, ceil(n / b) tiled, each reading and writing the matrix.
+    ASSERT_DOUBLE_EQ(matrix_traffic(100, 0, 4), 100 * 2.0 * 100 * 100 * 4);
+    ASSERT_DOUBLE_EQ(matrix_traffic(100, 32, 2), 4 * 2.0 * 100 * 100 * 2);
+
+    roofline roof = measure_roofline<int32_t>(2, 1 << 20);
+    ASSERT_EQ(roof.threads, 2);
+    ASSERT_GT(roof.bandwidth, 0.0);
+    ASSERT_GT(roof.compute, 0.0);
+
+    // Strong: the base is the 1-thread run of the same size. Weak: the 1-thread run of the series.
+    auto measured = [](const char * kernel, bool weak, int n, int b, int threads, double median_ns) {
+        scaling_point point{};
+        point.kernel = kernel;
+        point.weak = weak;
+        point.vertices = n;
+        point.block_length = b;
+        point.threads = threads;
+        point.samples = 1;
+        point.median_ns = median_ns;
+        return point;
+    };
+    std::vector<scaling_point> points{
+        measured("blocked", false, 1000, 64, 1, 8e9),
+        measured("blocked", false, 1000, 64, 4, 2.5e9),
+        measured("blocked", false, 2000, 64, 4, 16e9),
+        measured("naive", true, 1000, 0, 1, 4e9),
+        measured("naive", true, 1587, 0, 4, 5e9),
+    };
+    for (scaling_point & point : points) {
+        point.bytes = matrix_traffic(point.vertices, point.block_length, sizeof(int32_t));
+    }
+    std::vector<roofline> rooflines{{1, 10e9, 40e9}, {4, 20e9, 160e9}};
+    compute_scaling(points, rooflines);
+    ASSERT_DOUBLE_EQ(points[1].speedup, 3.2);
+    ASSERT_DOUBLE_EQ(points[1].efficiency, 0.8);
+    ASSERT_DOUBLE_EQ(points[2].speedup, 1.0);
+    ASSERT_DOUBLE_EQ(points[4].efficiency, 0.8);
+    ASSERT_DOUBLE_EQ(points[4].speedup, 3.2);
+    ASSERT_DOUBLE_EQ(points[0].operations, 2e9 / 8);
+    ASSERT_DOUBLE_EQ(points[0].intensity, 2e9 / points[0].bytes);
+
+    // Naive has 1/4 op per int32 byte: below the ridge, so memory-bound; blocked with b = 64 is far above it.
+    ASSERT_TRUE(points[3].memory_bound);
+    ASSERT_DOUBLE_EQ(points[3].roof, 0.25 * 10e9);
+    ASSERT_FALSE(points[1].memory_bound);
+    ASSERT_DOUBLE_EQ(points[1].roof, 160e9);
+    ASSERT_DOUBLE_EQ(points[1].roof_fraction, points[1].operations / 160e9);
+
+    for (std::string format : {"csv", "json"}) {
+        std::string path = testing::TempDir() + "fw_test_scaling." + format;
+        ASSERT_EQ(write_scaling(path, format, points, rooflines), 1);
+        std::ifstream file(path);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        ASSERT_NE(text.find("memory"), std::string::npos);
+        ASSERT_NE(text.find("compute"), std::string::npos);
+        ASSERT_EQ(std::count(text.begin(), text.end(), '\n'), format == "csv" ? 10 : 13);
+        std::remove(path.c_str());
+    }
+    ASSERT_EQ(write_scaling(testing::TempDir() + "fw_test_scaling.xml", "xml", points, rooflines), -1);
+    omp_set_num_threads(threads);
+}
+
+TEST_F(FloydWarshallTest, TestKernelRegistry)
+{
+    // Every registered kernel solves a ragged graph like the serial one; the dense names leave out `sparse`.
+    int n = 45;
+    graph_3.assign(n * n, INF);
+    generate_linear_graph(graph_3.data(), n, 4 * n);
+    graph_1 = graph_3;
+    serial_floyd_warshall(graph_1.data(), n);
+    omp_set_num_threads(threads);
+    for (const registered_kernel<int32_t> & kernel : registered_kernels<int32_t>()) {
+        graph_2 = graph_3;
+        kernel.run(graph_2.data(), n, kernel.tiled ? tile_length : 0);
+        ASSERT_EQ(graph_1, graph_2) << kernel.name;
+    }
+    std::vector<std::string> names = registered_kernel_names(false);
+    std::vector<std::string> dense = registered_kernel_names(true);
+    ASSERT_EQ(names.size(), registered_kernels<float>().size());
+    ASSERT_EQ(dense.size() + 1, names.size());
+    ASSERT_EQ(std::find(dense.begin(), dense.end(), "sparse"), dense.end());
+}
@@ -0,0 +1,875 @@
+#include "tile.h"
+#include "globals.h"
+#include "semiring.h"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TILE_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief `C ⊕ (a ⊗ b)` for one element of semiring `S`.
+ */
+template <typename S, typename T>
+static inline T semiring_update(T c, T a, T b) {
+    return semiring_apply<S::plus>(c, semiring_apply<S::times>(a, b));
+}
+
+/**
+ * @brief Portable semiring tile kernel (see `semiring_tile`).
+ */
+template <typename S, typename T>
+static void semiring_tile_scalar(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    const T zero = S::template zero<T>();
+    for (int k = 0; k < depth; ++k) {
+        const T *B_row = B + k * ld;
+        for (int i = 0; i < rows; ++i) {
+            T a_ik = A[i * ld + k];
+            if (a_ik == zero) {
+                continue;
+            }
+            T *C_row = C + i * ld;
+            for (int j = 0; j < cols; ++j) {
+                C_row[j] = semiring_update<S>(C_row[j], a_ik, B_row[j]);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Portable min-plus tile kernel that also records next hops. Also used for the tails of the AVX2 path.
+ */
+template <typename T, typename I>
+static void minplus_tile_next_scalar(T *C, I *Cn, const T *A, const I *An, const T *B, int rows, int cols, int depth, int ld) {
+    const T inf = distance_traits<T>::inf();
+    for (int k = 0; k < depth; ++k) {
+        const T *B_row = B + k * ld;
+        for (int i = 0; i < rows; ++i) {
+            T a_ik = A[i * ld + k];
+            if (a_ik == inf) {
+                continue;
+            }
+            I hop = An[i * ld + k];
+            T *C_row = C + i * ld;
+            I *Cn_row = Cn + i * ld;
+            for (int j = 0; j < cols; ++j) {
+                T candidate = distance_traits<T>::add(a_ik, B_row[j]);
+                if (candidate < C_row[j]) {
+                    C_row[j] = candidate;
+                    Cn_row[j] = hop;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Portable interleaved tile update, in `k`, `i`, `j` order (see `minplus_interleaved_tile`).
+ */
+template <typename T>
+static void minplus_interleaved_scalar(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    constexpr int L = interleave_lanes<T>();
+    for (int k = 0; k < depth; ++k) {
+        for (int i = 0; i < rows; ++i) {
+            const T *a = A + (static_cast<size_t>(i) * ld + k) * L;
+            for (int j = 0; j < cols; ++j) {
+                T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+                const T *b = B + (static_cast<size_t>(k) * ld + j) * L;
+                for (int g = 0; g < L; ++g) {
+                    c[g] = std::min(c[g], distance_traits<T>::add(a[g], b[g]));
+                }
+            }
+        }
+    }
+}
+
+#ifdef TILE_X86
+#define TILE_AVX2 __attribute__((target("avx2"), always_inline)) static inline
+#define TILE_AVX512 __attribute__((target("avx512f,avx512bw"), always_inline)) static inline
+
+/**
+ * @brief AVX2 vector operations per distance type: broadcast, unaligned load/store, (saturating) add, min, max and
+ *        bitwise OR/AND.
+ * 
+ * `changed(a, b)` returns a byte mask of the lanes where `a != b`, with only the lowest bit of each lane set,
+ * so lane `l` of a set bit `x` is `x / sizeof(T)`.
+ */
+template <typename T>
+struct avx2_ops;
+
+template <>
+struct avx2_ops<int32_t> {
+    using vec = __m256i;
+    static constexpr int lanes = 8;
+    TILE_AVX2 vec set1(int32_t x) { return _mm256_set1_epi32(x); }
+    TILE_AVX2 vec load(const int32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    TILE_AVX2 void store(int32_t *p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    TILE_AVX2 vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+    TILE_AVX2 vec min(vec a, vec b) { return _mm256_min_epi32(a, b); }
+    TILE_AVX2 vec max(vec a, vec b) { return _mm256_max_epi32(a, b); }
+    TILE_AVX2 vec bit_or(vec a, vec b) { return _mm256_or_si256(a, b); }
+    TILE_AVX2 vec bit_and(vec a, vec b) { return _mm256_and_si256(a, b); }
+    TILE_AVX2 unsigned changed(vec a, vec b) { return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b))) & 0x11111111u; }
+};
+
+template <>
+struct avx2_ops<uint16_t> {
+    using vec = __m256i;
+    static constexpr int lanes = 16;
+    TILE_AVX2 vec set1(uint16_t x) { return _mm256_set1_epi16(static_cast<short>(x)); }
+    TILE_AVX2 vec load(const uint16_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    TILE_AVX2 void store(uint16_t *p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    TILE_AVX2 vec add(vec a, vec b) { return _mm256_adds_epu16(a, b); }
+    TILE_AVX2 vec min(vec a, vec b) { return _mm256_min_epu16(a, b); }
+    TILE_AVX2 vec max(vec a, vec b) { return _mm256_max_epu16(a, b); }
+    TILE_AVX2 vec bit_or(vec a, vec b) { return _mm256_or_si256(a, b); }
+    TILE_AVX2 vec bit_and(vec a, vec b) { return _mm256_and_si256(a, b); }
+    TILE_AVX2 unsigned changed(vec a, vec b) { return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b))) & 0x55555555u; }
+};
+
+template <>
+struct avx2_ops<uint8_t> {
+    using vec = __m256i;
+    static constexpr int lanes = 32;
+    TILE_AVX2 vec set1(uint8_t x) { return _mm256_set1_epi8(static_cast<char>(x)); }
+    TILE_AVX2 vec load(const uint8_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    TILE_AVX2 void store(uint8_t *p, vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    TILE_AVX2 vec add(vec a, vec b) { return _mm256_adds_epu8(a, b); }
+    TILE_AVX2 vec min(vec a, vec b) { return _mm256_min_epu8(a, b); }
+    TILE_AVX2 vec max(vec a, vec b) { return _mm256_max_epu8(a, b); }
+    TILE_AVX2 vec bit_or(vec a, vec b) { return _mm256_or_si256(a, b); }
+    TILE_AVX2 vec bit_and(vec a, vec b) { return _mm256_and_si256(a, b); }
+    TILE_AVX2 unsigned changed(vec a, vec b) { return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))) & 0xffffffffu; }
+};
+
+template <>
+struct avx2_ops<float> {
+    using vec = __m256;
+    static constexpr int lanes = 8;
+    TILE_AVX2 vec set1(float x) { return _mm256_set1_ps(x); }
+    TILE_AVX2 vec load(const float *p) { return _mm256_loadu_ps(p); }
+    TILE_AVX2 void store(float *p, vec v) { _mm256_storeu_ps(p, v); }
+    TILE_AVX2 vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+    TILE_AVX2 vec min(vec a, vec b) { return _mm256_min_ps(a, b); }
+    TILE_AVX2 vec max(vec a, vec b) { return _mm256_max_ps(a, b); }
+    TILE_AVX2 vec bit_or(vec a, vec b) { return _mm256_or_ps(a, b); }
+    TILE_AVX2 vec bit_and(vec a, vec b) { return _mm256_and_ps(a, b); }
+    TILE_AVX2 unsigned changed(vec a, vec b) { return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)))) & 0x11111111u; }
+};
+
+/**
+ * @brief AVX-512 vector operations per distance type, including masked loads/stores for the row tail.
+ * 
+ * `changed(a, b)` returns the mask of the lanes where `a != b`.
+ */
+template <typename T>
+struct avx512_ops;
+
+template <>
+struct avx512_ops<int32_t> {
+    using vec = __m512i;
+    using mask = __mmask16;
+    static constexpr int lanes = 16;
+    TILE_AVX512 vec set1(int32_t x) { return _mm512_set1_epi32(x); }
+    TILE_AVX512 vec load(const int32_t *p) { return _mm512_loadu_si512(p); }
+    TILE_AVX512 void store(int32_t *p, vec v) { _mm512_storeu_si512(p, v); }
+    TILE_AVX512 vec load(mask m, const int32_t *p) { return _mm512_maskz_loadu_epi32(m, p); }
+    TILE_AVX512 void store(int32_t *p, mask m, vec v) { _mm512_mask_storeu_epi32(p, m, v); }
+    TILE_AVX512 vec add(vec a, vec b) { return _mm512_add_epi32(a, b); }
+    TILE_AVX512 vec min(vec a, vec b) { return _mm512_min_epi32(a, b); }
+    TILE_AVX512 vec max(vec a, vec b) { return _mm512_max_epi32(a, b); }
+    TILE_AVX512 vec bit_or(vec a, vec b) { return _mm512_or_si512(a, b); }
+    TILE_AVX512 vec bit_and(vec a, vec b) { return _mm512_and_si512(a, b); }
+    TILE_AVX512 mask changed(vec a, vec b) { return _mm512_cmpneq_epi32_mask(a, b); }
+};
+
+template <>
+struct avx512_ops<uint16_t> {
+    using vec = __m512i;
+    using mask = __mmask32;
+    static constexpr int lanes = 32;
+    TILE_AVX512 vec set1(uint16_t x) { return _mm512_set1_epi16(static_cast<short>(x)); }
+    TILE_AVX512 vec load(const uint16_t *p) { return _mm512_loadu_si512(p); }
+    TILE_AVX512 void store(uint16_t *p, vec v) { _mm512_storeu_si512(p, v); }
+    TILE_AVX512 vec load(mask m, const uint16_t *p) { return _mm512_maskz_loadu_epi16(m, p); }
+    TILE_AVX512 void store(uint16_t *p, mask m, vec v) { _mm512_mask_storeu_epi16(p, m, v); }
+    TILE_AVX512 vec add(vec a, vec b) { return _mm512_adds_epu16(a, b); }
+    TILE_AVX512 vec min(vec a, vec b) { return _mm512_min_epu16(a, b); }
+    TILE_AVX512 vec max(vec a, vec b) { return _mm512_max_epu16(a, b); }
+    TILE_AVX512 vec bit_or(vec a, vec b) { return _mm512_or_si512(a, b); }
+    TILE_AVX512 vec bit_and(vec a, vec b) { return _mm512_and_si512(a, b); }
+    TILE_AVX512 mask changed(vec a, vec b) { return _mm512_cmpneq_epu16_mask(a, b); }
+};
+
+template <>
+struct avx512_ops<uint8_t> {
+    using vec = __m512i;
+    using mask = __mmask64;
+    static constexpr int lanes = 64;
+    TILE_AVX512 vec set1(uint8_t x) { return _mm512_set1_epi8(static_cast<char>(x)); }
+    TILE_AVX512 vec load(const uint8_t *p) { return _mm512_loadu_si512(p); }
+    TILE_AVX512 void store(uint8_t *p, vec v) { _mm512_storeu_si512(p, v); }
+    TILE_AVX512 vec load(mask m, const uint8_t *p) { return _mm512_maskz_loadu_epi8(m, p); }
+    TILE_AVX512 void store(uint8_t *p, mask m, vec v) { _mm512_mask_storeu_epi8(p, m, v); }
+    TILE_AVX512 vec add(vec a, vec b) { return _mm512_adds_epu8(a, b); }
+    TILE_AVX512 vec min(vec a, vec b) { return _mm512_min_epu8(a, b); }
+    TILE_AVX512 vec max(vec a, vec b) { return _mm512_max_epu8(a, b); }
+    TILE_AVX512 vec bit_or(vec a, vec b) { return _mm512_or_si512(a, b); }
+    TILE_AVX512 vec bit_and(vec a, vec b) { return _mm512_and_si512(a, b); }
+    TILE_AVX512 mask changed(vec a, vec b) { return _mm512_cmpneq_epu8_mask(a, b); }
+};
+
+template <>
+struct avx512_ops<float> {
+    using vec = __m512;
+    using mask = __mmask16;
+    static constexpr int lanes = 16;
+    TILE_AVX512 vec set1(float x) { return _mm512_set1_ps(x); }
+    TILE_AVX512 vec load(const float *p) { return _mm512_loadu_ps(p); }
+    TILE_AVX512 void store(float *p, vec v) { _mm512_storeu_ps(p, v); }
+    TILE_AVX512 vec load(mask m, const float *p) { return _mm512_maskz_loadu_ps(m, p); }
+    TILE_AVX512 void store(float *p, mask m, vec v) { _mm512_mask_storeu_ps(p, m, v); }
+    TILE_AVX512 vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+    TILE_AVX512 vec min(vec a, vec b) { return _mm512_min_ps(a, b); }
+    TILE_AVX512 vec max(vec a, vec b) { return _mm512_max_ps(a, b); }
+    // _mm512_or_ps and _mm512_and_ps need AVX-512DQ; the integer forms are the same bits.
+    TILE_AVX512 vec bit_or(vec a, vec b) { return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+    TILE_AVX512 vec bit_and(vec a, vec b) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_castps_si512(b))); }
+    TILE_AVX512 mask changed(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ); }
+};
+
+/**
+ * @brief Applies `O` to two AVX2 vectors of `ops` (see `semiring_apply`).
+ */
+template <semiring_op O, typename ops>
+TILE_AVX2 typename ops::vec avx2_apply(typename ops::vec a, typename ops::vec b) {
+    if constexpr (O == semiring_op::min) {
+        return ops::min(a, b);
+    }
+    else if constexpr (O == semiring_op::max) {
+        return ops::max(a, b);
+    }
+    else if constexpr (O == semiring_op::bit_or) {
+        return ops::bit_or(a, b);
+    }
+    else if constexpr (O == semiring_op::bit_and) {
+        return ops::bit_and(a, b);
+    }
+    else {
+        return ops::add(a, b);
+    }
+}
+
+/**
+ * @brief Applies `O` to two AVX-512 vectors of `ops` (see `semiring_apply`).
+ */
+template <semiring_op O, typename ops>
+TILE_AVX512 typename ops::vec avx512_apply(typename ops::vec a, typename ops::vec b) {
+    if constexpr (O == semiring_op::min) {
+        return ops::min(a, b);
+    }
+    else if constexpr (O == semiring_op::max) {
+        return ops::max(a, b);
+    }
+    else if constexpr (O == semiring_op::bit_or) {
+        return ops::bit_or(a, b);
+    }
+    else if constexpr (O == semiring_op::bit_and) {
+        return ops::bit_and(a, b);
+    }
+    else {
+        return ops::add(a, b);
+    }
+}
+
+/**
+ * @brief `c ⊕ (a ⊗ b)` on AVX2 vectors of semiring `S`.
+ */
+template <typename S, typename ops>
+TILE_AVX2 typename ops::vec avx2_update(typename ops::vec c, typename ops::vec a, typename ops::vec b) {
+    return avx2_apply<S::plus, ops>(c, avx2_apply<S::times, ops>(a, b));
+}
+
+/**
+ * @brief `c ⊕ (a ⊗ b)` on AVX-512 vectors of semiring `S`.
+ */
+template <typename S, typename ops>
+TILE_AVX512 typename ops::vec avx512_update(typename ops::vec c, typename ops::vec a, typename ops::vec b) {
+    return avx512_apply<S::plus, ops>(c, avx512_apply<S::times, ops>(a, b));
+}
+
+template <typename S, typename T>
+__attribute__((target("avx2")))
+static void semiring_tile_avx2(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    using ops = avx2_ops<T>;
+    const T zero = S::template zero<T>();
+    for (int k = 0; k < depth; ++k) {
+        const T *B_row = B + k * ld;
+        for (int i = 0; i < rows; ++i) {
+            T a_ik = A[i * ld + k];
+            if (a_ik == zero) {
+                continue;
+            }
+            T *C_row = C + i * ld;
+            typename ops::vec a = ops::set1(a_ik);
+            int j = 0;
+            for (; j + ops::lanes <= cols; j += ops::lanes) {
+                ops::store(C_row + j, avx2_update<S, ops>(ops::load(C_row + j), a, ops::load(B_row + j)));
+            }
+            for (; j < cols; ++j) {
+                C_row[j] = semiring_update<S>(C_row[j], a_ik, B_row[j]);
+            }
+        }
+    }
+}
+
+template <typename S, typename T>
+__attribute__((target("avx512f,avx512bw")))
+static void semiring_tile_avx512(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    using ops = avx512_ops<T>;
+    const T zero = S::template zero<T>();
+    for (int k = 0; k < depth; ++k) {
+        const T *B_row = B + k * ld;
+        for (int i = 0; i < rows; ++i) {
+            T a_ik = A[i * ld + k];
+            if (a_ik == zero) {
+                continue;
+            }
+            T *C_row = C + i * ld;
+            typename ops::vec a = ops::set1(a_ik);
+            int j = 0;
+            for (; j + ops::lanes <= cols; j += ops::lanes) {
+                ops::store(C_row + j, avx512_update<S, ops>(ops::load(C_row + j), a, ops::load(B_row + j)));
+            }
+            // Masked tail instead of a scalar loop
+            if (j < cols) {
+                typename ops::mask m = static_cast<typename ops::mask>((1ull << (cols - j)) - 1);
+                ops::store(C_row + j, m, avx512_update<S, ops>(ops::load(m, C_row + j), a, ops::load(m, B_row + j)));
+            }
+        }
+    }
+}
+
+/**
+ * @brief AVX2 update of an `N x N` tile of semiring `S` that aliases neither input, register-blocked: a strip
+ *        of 4 rows by 2 vectors of `C` (4 x 16 for `int32_t`) stays in 8 registers for all `N` values of `k`.
+ * 
+ * `N` is a compile-time constant and a multiple of 2 vectors, so the strip loops unroll completely and there
+ * are no tails. Each `k` loads 2 vectors of `B` and broadcasts 4 elements of `A`; a `k` whose 4 elements of
+ * `A` are all `S::zero()` is skipped.
+ */
+template <typename S, typename T, int N>
+__attribute__((target("avx2")))
+static void semiring_fixed_avx2(T *C, const T *A, const T *B, int ld) {
+    using ops = avx2_ops<T>;
+    using vec = typename ops::vec;
+    constexpr int L = ops::lanes;
+    constexpr int MR = 4;
+    constexpr int NV = 2;
+    static_assert(N % (NV * L) == 0 && N % MR == 0, "whole strips");
+    const T zero = S::template zero<T>();
+    for (int i0 = 0; i0 < N; i0 += MR) {
+        for (int j0 = 0; j0 < N; j0 += NV * L) {
+            vec c[MR][NV];
+            #pragma GCC unroll 8
+            for (int r = 0; r < MR; ++r) {
+                #pragma GCC unroll 8
+                for (int v = 0; v < NV; ++v) {
+                    c[r][v] = ops::load(C + (i0 + r) * ld + j0 + v * L);
+                }
+            }
+            for (int k = 0; k < N; ++k) {
+                T a[MR];
+                bool all_zero = true;
+                #pragma GCC unroll 8
+                for (int r = 0; r < MR; ++r) {
+                    a[r] = A[(i0 + r) * ld + k];
+                    all_zero = all_zero && a[r] == zero;
+                }
+                if (all_zero) {
+                    continue;
+                }
+                vec b[NV];
+                #pragma GCC unroll 8
+                for (int v = 0; v < NV; ++v) {
+                    b[v] = ops::load(B + k * ld + j0 + v * L);
+                }
+                #pragma GCC unroll 8
+                for (int r = 0; r < MR; ++r) {
+                    vec a_r = ops::set1(a[r]);
+                    #pragma GCC unroll 8
+                    for (int v = 0; v < NV; ++v) {
+                        c[r][v] = avx2_update<S, ops>(c[r][v], a_r, b[v]);
+                    }
+                }
+            }
+            #pragma GCC unroll 8
+            for (int r = 0; r < MR; ++r) {
+                #pragma GCC unroll 8
+                for (int v = 0; v < NV; ++v) {
+                    ops::store(C + (i0 + r) * ld + j0 + v * L, c[r][v]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief AVX-512 counterpart of `semiring_fixed_avx2`: a strip of 4 rows by up to 4 vectors of `C` (4 x 64 for
+ *        `int32_t` once `N >= 64`) stays in up to 16 of the 32 registers for all `N` values of `k`.
+ */
+template <typename S, typename T, int N>
+__attribute__((target("avx512f,avx512bw")))
+static void semiring_fixed_avx512(T *C, const T *A, const T *B, int ld) {
+    using ops = avx512_ops<T>;
+    using vec = typename ops::vec;
+    constexpr int L = ops::lanes;
+    constexpr int MR = 4;
+    constexpr int NV = N / L < 4 ? N / L : 4;
+    static_assert(NV > 0 && N % (NV * L) == 0 && N % MR == 0, "whole strips");
+    const T zero = S::template zero<T>();
+    for (int i0 = 0; i0 < N; i0 += MR) {
+        for (int j0 = 0; j0 < N; j0 += NV * L) {
+            vec c[MR][NV];
+            #pragma GCC unroll 8
+            for (int r = 0; r < MR; ++r) {
+                #pragma GCC unroll 8
+                for (int v = 0; v < NV; ++v) {
+                    c[r][v] = ops::load(C + (i0 + r) * ld + j0 + v * L);
+                }
+            }
+            for (int k = 0; k < N; ++k) {
+                T a[MR];
+                bool all_zero = true;
+                #pragma GCC unroll 8
+                for (int r = 0; r < MR; ++r) {
+                    a[r] = A[(i0 + r) * ld + k];
+                    all_zero = all_zero && a[r] == zero;
+                }
+                if (all_zero) {
+                    continue;
+                }
+                vec b[NV];
+                #pragma GCC unroll 8
+                for (int v = 0; v < NV; ++v) {
+                    b[v] = ops::load(B + k * ld + j0 + v * L);
+                }
+                #pragma GCC unroll 8
+                for (int r = 0; r < MR; ++r) {
+                    vec a_r = ops::set1(a[r]);
+                    #pragma GCC unroll 8
+                    for (int v = 0; v < NV; ++v) {
+                        c[r][v] = avx512_update<S, ops>(c[r][v], a_r, b[v]);
+                    }
+                }
+            }
+            #pragma GCC unroll 8
+            for (int r = 0; r < MR; ++r) {
+                #pragma GCC unroll 8
+                for (int v = 0; v < NV; ++v) {
+                    ops::store(C + (i0 + r) * ld + j0 + v * L, c[r][v]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs the fixed-size kernel for `N` on `isa` if one exists: for a vector width that divides `N`.
+ * 
+ * @return bool `false` if there is none (scalar, or `N` narrower than two AVX2 or one AVX-512 vector of `T`),
+ *         so the caller falls back to the generic kernel.
+ */
+template <typename S, typename T, int N>
+static bool semiring_fixed(tile_isa isa, T *C, const T *A, const T *B, int ld) {
+    if constexpr (N % avx512_ops<T>::lanes == 0) {
+        if (isa == tile_isa::avx512) {
+            semiring_fixed_avx512<S, T, N>(C, A, B, ld);
+            return true;
+        }
+    }
+    if constexpr (N % (2 * avx2_ops<T>::lanes) == 0) {
+        if (isa == tile_isa::avx2 || isa == tile_isa::avx512) {
+            semiring_fixed_avx2<S, T, N>(C, A, B, ld);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Writes `hop` to the next-hop lanes selected by `m`, in as many 512-bit masked stores as `lanes` indices span.
+ * 
+ * Masked-off lanes are not touched, so the stores never run past the end of a row, and an empty
+ * mask costs a store slot rather than a mispredicted branch.
+ */
+template <typename I>
+TILE_AVX512 void store_next_hop(I *p, uint64_t m, int lanes, I hop) {
+    constexpr int per_store = 64 / sizeof(I);
+    for (int c = 0; c < lanes; c += per_store) {
+        uint64_t bits = per_store == 64 ? m : (m >> c) & ((1ull << per_store) - 1);
+        if constexpr (sizeof(I) == 1) {
+            _mm512_mask_storeu_epi8(p + c, static_cast<__mmask64>(bits), _mm512_set1_epi8(static_cast<char>(hop)));
+        }
+        else if constexpr (sizeof(I) == 2) {
+            _mm512_mask_storeu_epi16(p + c, static_cast<__mmask32>(bits), _mm512_set1_epi16(static_cast<short>(hop)));
+        }
+        else {
+            _mm512_mask_storeu_epi32(p + c, static_cast<__mmask16>(bits), _mm512_set1_epi32(static_cast<int>(hop)));
+        }
+    }
+}
+
+/**
+ * @brief AVX2 min-plus tile kernel that also records next hops. Lanes whose distance changed are
+ *        found with one compare per vector, and only those get the next hop of `A[i][k]`.
+ */
+template <typename T, typename I>
+__attribute__((target("avx2")))
+static void minplus_tile_next_avx2(T *C, I *Cn, const T *A, const I *An, const T *B, int rows, int cols, int depth, int ld) {
+    using ops = avx2_ops<T>;
+    const T inf = distance_traits<T>::inf();
+    for (int k = 0; k < depth; ++k) {
+        const T *B_row = B + k * ld;
+        for (int i = 0; i < rows; ++i) {
+            T a_ik = A[i * ld + k];
+            if (a_ik == inf) {
+                continue;
+            }
+            I hop = An[i * ld + k];
+            T *C_row = C + i * ld;
+            I *Cn_row = Cn + i * ld;
+            typename ops::vec a = ops::set1(a_ik);
+            int j = 0;
+            for (; j + ops::lanes <= cols; j += ops::lanes) {
+                typename ops::vec before = ops::load(C_row + j);
+                typename ops::vec after = ops::min(before, ops::add(a, ops::load(B_row + j)));
+                unsigned m = ops::changed(before, after);
+                if (m == 0) {
+                    continue;
+                }
+                ops::store(C_row + j, after);
+                while (m != 0) {
+                    Cn_row[j + __builtin_ctz(m) / static_cast<int>(sizeof(T))] = hop;
+                    m &= m - 1;
+                }
+            }
+            for (; j < cols; ++j) {
+                T candidate = distance_traits<T>::add(a_ik, B_row[j]);
+                if (candidate < C_row[j]) {
+                    C_row[j] = candidate;
+                    Cn_row[j] = hop;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief AVX-512 min-plus tile kernel that also records next hops, using the compare mask of each
+ *        vector directly as the write mask of the next-hop stores.
+ */
+template <typename T, typename I>
+__attribute__((target("avx512f,avx512bw")))
+static void minplus_tile_next_avx512(T *C, I *Cn, const T *A, const I *An, const T *B, int rows, int cols, int depth, int ld) {
+    using ops = avx512_ops<T>;
+    const T inf = distance_traits<T>::inf();
+    for (int k = 0; k < depth; ++k) {
+        const T *B_row = B + k * ld;
+        for (int i = 0; i < rows; ++i) {
+            T a_ik = A[i * ld + k];
+            if (a_ik == inf) {
+                continue;
+            }
+            I hop = An[i * ld + k];
+            T *C_row = C + i * ld;
+            I *Cn_row = Cn + i * ld;
+            typename ops::vec a = ops::set1(a_ik);
+            int j = 0;
+            for (; j + ops::lanes <= cols; j += ops::lanes) {
+                typename ops::vec before = ops::load(C_row + j);
+                typename ops::vec after = ops::min(before, ops::add(a, ops::load(B_row + j)));
+                ops::store(C_row + j, after);
+                store_next_hop(Cn_row + j, ops::changed(before, after), ops::lanes, hop);
+            }
+            if (j < cols) {
+                typename ops::mask tail = static_cast<typename ops::mask>((1ull << (cols - j)) - 1);
+                typename ops::vec before = ops::load(tail, C_row + j);
+                typename ops::vec after = ops::min(before, ops::add(a, ops::load(tail, B_row + j)));
+                typename ops::mask m = ops::changed(before, after) & tail;
+                ops::store(C_row + j, m, after);
+                store_next_hop(Cn_row + j, m, ops::lanes, hop);
+            }
+        }
+    }
+}
+/**
+ * @brief Interleaved tile update with one AVX-512 vector per cell (see `minplus_interleaved_tile`).
+ */
+template <typename T>
+__attribute__((target("avx512f,avx512bw")))
+static void minplus_interleaved_avx512(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    using ops = avx512_ops<T>;
+    constexpr int L = interleave_lanes<T>();
+    static_assert(ops::lanes == L, "one vector per cell");
+    auto cell = [&](const T *M, int i, int j) { return M + (static_cast<size_t>(i) * ld + j) * L; };
+    if (C == A || C == B) {
+        for (int k = 0; k < depth; ++k) {
+            for (int i = 0; i < rows; ++i) {
+                typename ops::vec a = ops::load(cell(A, i, k));
+                for (int j = 0; j < cols; ++j) {
+                    T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+                    ops::store(c, ops::min(ops::load(c), ops::add(a, ops::load(cell(B, k, j)))));
+                }
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < rows; ++i) {
+        int j = 0;
+        for (; j + 4 <= cols; j += 4) {
+            T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+            typename ops::vec c0 = ops::load(c), c1 = ops::load(c + L), c2 = ops::load(c + 2 * L), c3 = ops::load(c + 3 * L);
+            for (int k = 0; k < depth; ++k) {
+                typename ops::vec a = ops::load(cell(A, i, k));
+                const T *b = cell(B, k, j);
+                c0 = ops::min(c0, ops::add(a, ops::load(b)));
+                c1 = ops::min(c1, ops::add(a, ops::load(b + L)));
+                c2 = ops::min(c2, ops::add(a, ops::load(b + 2 * L)));
+                c3 = ops::min(c3, ops::add(a, ops::load(b + 3 * L)));
+            }
+            ops::store(c, c0);
+            ops::store(c + L, c1);
+            ops::store(c + 2 * L, c2);
+            ops::store(c + 3 * L, c3);
+        }
+        for (; j < cols; ++j) {
+            T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+            typename ops::vec c0 = ops::load(c);
+            for (int k = 0; k < depth; ++k) {
+                c0 = ops::min(c0, ops::add(ops::load(cell(A, i, k)), ops::load(cell(B, k, j))));
+            }
+            ops::store(c, c0);
+        }
+    }
+}
+
+/**
+ * @brief Interleaved tile update with two AVX2 vectors per cell (see `minplus_interleaved_tile`).
+ */
+template <typename T>
+__attribute__((target("avx2")))
+static void minplus_interleaved_avx2(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    using ops = avx2_ops<T>;
+    constexpr int L = interleave_lanes<T>();
+    constexpr int H = ops::lanes;
+    static_assert(2 * H == L, "two vectors per cell");
+    auto cell = [&](const T *M, int i, int j) { return M + (static_cast<size_t>(i) * ld + j) * L; };
+    if (C == A || C == B) {
+        for (int k = 0; k < depth; ++k) {
+            for (int i = 0; i < rows; ++i) {
+                const T *a = cell(A, i, k);
+                typename ops::vec a0 = ops::load(a), a1 = ops::load(a + H);
+                for (int j = 0; j < cols; ++j) {
+                    T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+                    const T *b = cell(B, k, j);
+                    ops::store(c, ops::min(ops::load(c), ops::add(a0, ops::load(b))));
+                    ops::store(c + H, ops::min(ops::load(c + H), ops::add(a1, ops::load(b + H))));
+                }
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < rows; ++i) {
+        int j = 0;
+        for (; j + 2 <= cols; j += 2) {
+            T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+            typename ops::vec c0 = ops::load(c), c1 = ops::load(c + H), c2 = ops::load(c + L), c3 = ops::load(c + L + H);
+            for (int k = 0; k < depth; ++k) {
+                const T *a = cell(A, i, k);
+                typename ops::vec a0 = ops::load(a), a1 = ops::load(a + H);
+                const T *b = cell(B, k, j);
+                c0 = ops::min(c0, ops::add(a0, ops::load(b)));
+                c1 = ops::min(c1, ops::add(a1, ops::load(b + H)));
+                c2 = ops::min(c2, ops::add(a0, ops::load(b + L)));
+                c3 = ops::min(c3, ops::add(a1, ops::load(b + L + H)));
+            }
+            ops::store(c, c0);
+            ops::store(c + H, c1);
+            ops::store(c + L, c2);
+            ops::store(c + L + H, c3);
+        }
+        if (j < cols) {
+            T *c = C + (static_cast<size_t>(i) * ld + j) * L;
+            typename ops::vec c0 = ops::load(c), c1 = ops::load(c + H);
+            for (int k = 0; k < depth; ++k) {
+                const T *a = cell(A, i, k);
+                const T *b = cell(B, k, j);
+                c0 = ops::min(c0, ops::add(ops::load(a), ops::load(b)));
+                c1 = ops::min(c1, ops::add(ops::load(a + H), ops::load(b + H)));
+            }
+            ops::store(c, c0);
+            ops::store(c + H, c1);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Holds the instruction set selected for the tile kernels, initialized from CPUID on first use.
+ */
+static tile_isa & active_tile_isa() {
+    static tile_isa isa = detect_tile_isa();
+    return isa;
+}
+
+/**
+ * @brief Dispatches a square, unaliased `b x b` update to the fixed-size kernel for `b`, if `b` is one of the
+ *        specialized block lengths 16, 32, 64 or 128 and the active instruction set has a kernel for it.
+ * 
+ * @return bool `false` if the generic kernel has to run instead.
+ */
+template <typename S, typename T>
+static bool semiring_tile_fixed(T *C, const T *A, const T *B, int b, int ld) {
+#ifdef TILE_X86
+    tile_isa isa = active_tile_isa();
+    switch (b) {
+        case 16:
+            return semiring_fixed<S, T, 16>(isa, C, A, B, ld);
+        case 32:
+            return semiring_fixed<S, T, 32>(isa, C, A, B, ld);
+        case 64:
+            return semiring_fixed<S, T, 64>(isa, C, A, B, ld);
+        case 128:
+            return semiring_fixed<S, T, 128>(isa, C, A, B, ld);
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
+
+template <typename S, typename T>
+void semiring_tile(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    // Aliased updates (dependent and panel phases) need the k-outer order of the generic kernels.
+    if (rows == cols && cols == depth && C != A && C != B && semiring_tile_fixed<S>(C, A, B, rows, ld)) {
+        return;
+    }
+    switch (active_tile_isa()) {
+#ifdef TILE_X86
+        case tile_isa::avx512:
+            semiring_tile_avx512<S>(C, A, B, rows, cols, depth, ld);
+            break;
+        case tile_isa::avx2:
+            semiring_tile_avx2<S>(C, A, B, rows, cols, depth, ld);
+            break;
+#endif
+        default:
+            semiring_tile_scalar<S>(C, A, B, rows, cols, depth, ld);
+            break;
+    }
+}
+
+template <typename T>
+void minplus_tile(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    semiring_tile<min_plus>(C, A, B, rows, cols, depth, ld);
+}
+
+template <typename T>
+void minplus_interleaved_tile(T *C, const T *A, const T *B, int rows, int cols, int depth, int ld) {
+    switch (active_tile_isa()) {
+#ifdef TILE_X86
+        case tile_isa::avx512:
+            minplus_interleaved_avx512(C, A, B, rows, cols, depth, ld);
+            break;
+        case tile_isa::avx2:
+            minplus_interleaved_avx2(C, A, B, rows, cols, depth, ld);
+            break;
+#endif
+        default:
+            minplus_interleaved_scalar(C, A, B, rows, cols, depth, ld);
+            break;
+    }
+}
+
+template <typename T, typename I>
+void minplus_tile_next(T *C, I *Cn, const T *A, const I *An, const T *B, int rows, int cols, int depth, int ld) {
+    switch (active_tile_isa()) {
+#ifdef TILE_X86
+        case tile_isa::avx512:
+            minplus_tile_next_avx512(C, Cn, A, An, B, rows, cols, depth, ld);
+            break;
+        case tile_isa::avx2:
+            minplus_tile_next_avx2(C, Cn, A, An, B, rows, cols, depth, ld);
+            break;
+#endif
+        default:
+            minplus_tile_next_scalar(C, Cn, A, An, B, rows, cols, depth, ld);
+            break;
+    }
+}
+
+template <typename T>
+void minplus_tile(T *C, const T *A, const T *B, int b, int ld) {
+    minplus_tile(C, A, B, b, b, b, ld);
+}
+
+tile_isa detect_tile_isa() {
+#ifdef TILE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return tile_isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return tile_isa::avx2;
+    }
+#endif
+    return tile_isa::scalar;
+}
+
+tile_isa get_tile_isa() {
+    return active_tile_isa();
+}
+
+bool set_tile_isa(tile_isa isa) {
+    if (static_cast<int>(isa) > static_cast<int>(detect_tile_isa())) {
+        return false;
+    }
+    active_tile_isa() = isa;
+    return true;
+}
+
+const char * tile_isa_name(tile_isa isa) {
+    switch (isa) {
+        case tile_isa::avx512:
+            return "avx512";
+        case tile_isa::avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+#define INSTANTIATE_SEMIRING_TILE(S, T) \
+    template void semiring_tile<S, T>(T *, const T *, const T *, int, int, int, int);
+
+#define INSTANTIATE_TILE(T) \
+    INSTANTIATE_SEMIRING_TILE(min_plus, T) \
+    INSTANTIATE_SEMIRING_TILE(max_min, T) \
+    INSTANTIATE_SEMIRING_TILE(or_and, T) \
+    template void minplus_tile<T>(T *, const T *, const T *, int, int, int, int); \
+    template void minplus_tile<T>(T *, const T *, const T *, int, int); \
+    template void minplus_interleaved_tile<T>(T *, const T *, const T *, int, int, int, int); \
+    template void minplus_tile_next<T, uint8_t>(T *, uint8_t *, const T *, const uint8_t *, const T *, int, int, int, int); \
+    template void minplus_tile_next<T, uint16_t>(T *, uint16_t *, const T *, const uint16_t *, const T *, int, int, int, int); \
+    template void minplus_tile_next<T, uint32_t>(T *, uint32_t *, const T *, const uint32_t *, const T *, int, int, int, int);
+
+INSTANTIATE_TILE(int32_t)
+INSTANTIATE_TILE(uint16_t)
+INSTANTIATE_TILE(uint8_t)
+INSTANTIATE_TILE(float)
+INSTANTIATE_SEMIRING_TILE(max_plus, int32_t)
+INSTANTIATE_SEMIRING_TILE(max_plus, float)
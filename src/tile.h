@@ -0,0 +1,208 @@
+#ifndef TILE_H
+#define TILE_H
+
+/**
+ * @brief Instruction set used by the min-plus tile kernel.
+ * 
+ * - `scalar`: Portable C++ loop, always available.
+ * - `avx2`: 256-bit vectors (8 x int32/float, 16 x uint16, 32 x uint8).
+ * - `avx512`: 512-bit vectors with masked tails. Requires AVX-512F and AVX-512BW (for the 8/16-bit types).
+ */
+enum class tile_isa {
+    scalar,
+    avx2,
+    avx512
+};
+
+/**
+ * @brief Computes one min-plus tile update, `C[i][j] = min(C[i][j], A[i][k] + B[k][j])`, for all `k`.
+ * 
+ * This is the inner kernel of every blocked Floyd-Warshall variant. `C`, `A` and `B` point at the
+ * top-left element of `b x b` blocks whose rows are `ld` elements apart, so the same kernel serves
+ * packed `b x b` buffers (`ld == b`) and strided views into an `n x n` matrix (`ld == n`).
+ * 
+ * @param C A pointer to the first element of the output block.
+ * @param A A pointer to the first element of the first input block.
+ * @param B A pointer to the first element of the second input block.
+ * @param b The size (dimensions) of the blocks.
+ * @param ld The leading dimension (row stride) shared by all three blocks.
+ * 
+ * @details
+ * - The loops run `k`, `i`, `j` with `j` innermost, so the vector lanes walk contiguous rows of `B` and `C`.
+ * - There is no per-element `INF` branch. `distance_traits<T>::inf()` is a saturating sentinel: `INF + INF`
+ *   does not overflow an `int32_t`, `uint16_t`/`uint8_t` use saturating adds, and `float` infinity is absorbing,
+ *   so any sum involving it is `>= inf()` and `min` leaves `C` unchanged. Only whole rows with
+ *   `A[i][k] == inf()` are skipped.
+ * - Instantiated for `int32_t`, `uint16_t`, `uint8_t` and `float`. Narrower types fill more lanes per vector.
+ * - The instruction set is picked at runtime from CPUID the first time the kernel is used, and can be
+ *   overridden with `set_tile_isa`.
+ * - Block lengths 16, 32, 64 and 128 have compile-time specialized kernels, used when `C` aliases neither
+ *   `A` nor `B` (every independent-phase update): the loops are unrolled for the constant size, and a
+ *   4-row strip of `C` is kept in registers for all `k`, as in a GEMM micro-kernel. Other sizes, narrow
+ *   tiles of `uint8_t`/`uint16_t` that do not fill whole vectors, and aliased updates use the generic loop.
+ * 
+ * @note `A` and `B` may alias `C` (dependent and panel phases). This is safe because, for non-negative
+ *       weights, `C[i][k] + B[k][k]` and `A[k][k] + C[k][j]` never improve the element they were read from.
+ */
+template <typename T>
+void minplus_tile(
+    T * C,
+    const T * A,
+    const T * B,
+    int b,
+    int ld
+);
+
+/**
+ * @brief Computes one rectangular tile update of semiring `S`, `C[i][j] = C[i][j] ⊕ (A[i][k] ⊗ B[k][j])`, for all `k`.
+ * 
+ * The semiring-generic form of `minplus_tile`, which is `semiring_tile<min_plus>`. `⊕`, `⊗` and the identities
+ * are compile-time constants of the policy (see semiring.h), so each semiring gets its own copy of every kernel
+ * below: the scalar, AVX2 and AVX-512 loops, and the fixed-size register-blocked kernels.
+ * 
+ * @tparam S The semiring policy: `min_plus`, `max_min`, `max_plus` or `or_and`.
+ * @tparam T The distance type. `max_plus` is instantiated for `int32_t` and `float` only.
+ * @param C A pointer to the first element of the output block.
+ * @param A A pointer to the first element of the first input block.
+ * @param B A pointer to the first element of the second input block.
+ * @param rows The number of rows of `C` and `A`.
+ * @param cols The number of columns of `C` and `B`.
+ * @param depth The number of columns of `A` and rows of `B`.
+ * @param ld The leading dimension (row stride) shared by all three blocks.
+ * 
+ * @details Rows with `A[i][k] == S::zero()` are skipped, as `zero()` annihilates `⊗`. `A` and `B` may alias `C`
+ *          under the same condition as in `minplus_tile`: no cycle improves a path (see semiring.h).
+ */
+template <typename S, typename T>
+void semiring_tile(
+    T * C,
+    const T * A,
+    const T * B,
+    int rows,
+    int cols,
+    int depth,
+    int ld
+);
+
+/**
+ * @brief Computes one rectangular min-plus tile update, used for the ragged tiles on the matrix edge.
+ * 
+ * Same as the square `minplus_tile`, but `C` is `rows x cols`, `A` is `rows x depth` and `B` is
+ * `depth x cols`. Blocked kernels use it when `n` is not a multiple of the block length.
+ * 
+ * @param C A pointer to the first element of the output block.
+ * @param A A pointer to the first element of the first input block.
+ * @param B A pointer to the first element of the second input block.
+ * @param rows The number of rows of `C` and `A`.
+ * @param cols The number of columns of `C` and `B`.
+ * @param depth The number of columns of `A` and rows of `B`.
+ * @param ld The leading dimension (row stride) shared by all three blocks.
+ */
+template <typename T>
+void minplus_tile(
+    T * C,
+    const T * A,
+    const T * B,
+    int rows,
+    int cols,
+    int depth,
+    int ld
+);
+
+/**
+ * @brief Rectangular min-plus tile update that also maintains the matching tile of a next-hop matrix.
+ * 
+ * Same as the rectangular `minplus_tile`, and wherever `C[i][j]` strictly improves through `k`, `Cn[i][j]`
+ * is set to `An[i][k]`, the first hop on the way to `k`. The next hops are written in the same pass as
+ * the distances: the SIMD paths derive a lane mask from each vector compare and store only those lanes.
+ * 
+ * @tparam T The distance type.
+ * @tparam I The next-hop index type: `uint8_t`, `uint16_t` or `uint32_t` (see paths.h).
+ * @param C A pointer to the first element of the output block.
+ * @param Cn A pointer to the next-hop block matching `C`, with the same leading dimension.
+ * @param A A pointer to the first element of the first input block.
+ * @param An A pointer to the next-hop block matching `A`.
+ * @param B A pointer to the first element of the second input block.
+ * @param rows The number of rows of `C` and `A`.
+ * @param cols The number of columns of `C` and `B`.
+ * @param depth The number of columns of `A` and rows of `B`.
+ * @param ld The leading dimension (row stride) shared by all blocks, distances and next hops alike.
+ */
+template <typename T, typename I>
+void minplus_tile_next(
+    T * C,
+    I * Cn,
+    const T * A,
+    const I * An,
+    const T * B,
+    int rows,
+    int cols,
+    int depth,
+    int ld
+);
+
+/**
+ * @brief Returns the number of graphs interleaved by `interleave_matrices` (see kernels.h): one 64-byte cache
+ *        line of `T` per cell, i.e. 16 for `int32_t` and `float`, 32 for `uint16_t` and 64 for `uint8_t`.
+ */
+template <typename T>
+constexpr int interleave_lanes() {
+    return static_cast<int>(64 / sizeof(T));
+}
+
+/**
+ * @brief Computes one rectangular min-plus tile update on interleaved matrices, where every element is a 64-byte
+ *        cell holding the same element of `interleave_lanes<T>()` independent graphs.
+ * 
+ * Same as the rectangular `minplus_tile`, lane by lane: cell `(i, j)` of a block starts at element
+ * `(i * ld + j) * interleave_lanes<T>()`, and `ld` counts cells.
+ * 
+ * @details
+ * - A cell is one AVX-512 vector or two AVX2 vectors, so every update is whole vectors: no tails, no
+ *   broadcasts and no per-graph branches. There is no `INF` row skipping, since the lanes are different graphs.
+ * - When `C` aliases neither `A` nor `B`, the minimum over `k` is order-free, so four cells of `C` stay in
+ *   registers for the whole `depth` loop and share each load of `A`. Otherwise the loops run `k`, `i`, `j` as
+ *   in `minplus_tile`, with the same aliasing guarantee.
+ */
+template <typename T>
+void minplus_interleaved_tile(
+    T * C,
+    const T * A,
+    const T * B,
+    int rows,
+    int cols,
+    int depth,
+    int ld
+);
+
+/**
+ * @brief Returns the best instruction set supported by the executing CPU.
+ */
+tile_isa detect_tile_isa();
+
+/**
+ * @brief Returns the instruction set currently used by `minplus_tile`.
+ */
+tile_isa get_tile_isa();
+
+/**
+ * @brief Forces `minplus_tile` to use a given instruction set.
+ * 
+ * @param isa The instruction set to use.
+ * @return bool Returns `true` if the CPU supports `isa` and it was selected, `false` otherwise
+ *              (the current selection is left unchanged).
+ * 
+ * @note Not thread-safe with respect to kernels that are running; call it before starting a solve.
+ */
+bool set_tile_isa(
+    tile_isa isa
+);
+
+/**
+ * @brief Returns a printable name (`"scalar"`, `"avx2"`, `"avx512"`) for an instruction set.
+ */
+const char * tile_isa_name(
+    tile_isa isa
+);
+
+#endif
@@ -1,7 +1,13 @@
 #include "timestamps.h"
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <numeric>
+#include <utility>
 #include <fmt/format.h>
+#include <spdlog/spdlog.h>
 
 void mark_time(std::vector<std::tuple<std::string, double>> & timestamps, double & timestamp, const std::string_view label)
 {
@@ -35,4 +41,201 @@ double compute_average(std::vector<std::tuple<std::string, double>> & timestamps
         count++;
     });
     return (double)(sum/count);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Splits a label into its phase and iteration, `-1` if the label has no `, iteration: N` suffix.
+ */
+static std::pair<std::string, int> split_label(std::string_view label)
+{
+    static constexpr std::string_view suffix = ", iteration: ";
+    size_t at = label.rfind(suffix);
+    if (at == std::string_view::npos) {
+        return {std::string(label), -1};
+    }
+    std::string_view digits = label.substr(at + suffix.size());
+    if (digits.empty() || !std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return {std::string(label), -1};
+    }
+    return {std::string(label.substr(0, at)), std::stoi(std::string(digits))};
+}
+
+std::string timestamp_phase(std::string_view label)
+{
+    return split_label(label).first;
+}
+
+/**
+ * @brief Returns the `q` quantile of sorted samples, interpolating linearly between the nearest ranks.
+ */
+static double quantile(const std::vector<double> & sorted, double q)
+{
+    double position = q * (sorted.size() - 1);
+    size_t below = static_cast<size_t>(position);
+    size_t above = std::min(below + 1, sorted.size() - 1);
+    return sorted[below] + (position - below) * (sorted[above] - sorted[below]);
+}
+
+/**
+ * @brief Returns the two-sided 95% quantile of Student's t distribution with `df` degrees of freedom.
+ */
+static double t_quantile_95(int df)
+{
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df <= 30) {
+        return table[df - 1];
+    }
+    return df <= 60 ? 2.000 : (df <= 120 ? 1.980 : 1.960);
+}
+
+std::vector<timing_summary> summarize_timestamps(const std::vector<std::tuple<std::string, double>> & timestamps)
+{
+    std::vector<std::string> phases;
+    std::map<std::string, std::vector<double>> samples;
+    for (const auto & [label, ns] : timestamps) {
+        std::string phase = timestamp_phase(label);
+        if (samples.find(phase) == samples.end()) {
+            phases.push_back(phase);
+        }
+        samples[phase].push_back(ns);
+    }
+
+    std::vector<timing_summary> summaries;
+    for (const std::string & phase : phases) {
+        std::vector<double> & times = samples[phase];
+        std::sort(times.begin(), times.end());
+        timing_summary summary{};
+        summary.phase = phase;
+        summary.samples = static_cast<int>(times.size());
+        summary.min = times.front();
+        summary.max = times.back();
+        summary.mean = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+        summary.median = quantile(times, 0.5);
+        summary.p95 = quantile(times, 0.95);
+        double squares = 0.0;
+        for (double t : times) {
+            squares += (t - summary.mean) * (t - summary.mean);
+        }
+        summary.stddev = times.size() > 1 ? std::sqrt(squares / (times.size() - 1)) : 0.0;
+        double half = times.size() > 1 ? t_quantile_95(summary.samples - 1) * summary.stddev / std::sqrt(static_cast<double>(times.size())) : 0.0;
+        summary.ci_low = summary.mean - half;
+        summary.ci_high = summary.mean + half;
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+void print_summaries(const std::vector<timing_summary> & summaries)
+{
+    for (const timing_summary & s : summaries) {
+        fmt::print(
+            "{} over {} samples: min {:.0f} ns, median {:.0f} ns, p95 {:.0f} ns, max {:.0f} ns, mean {:.0f} ns, stddev {:.0f} ns, 95% CI [{:.0f}, {:.0f}] ns\n",
+            s.phase,
+            s.samples,
+            s.min,
+            s.median,
+            s.p95,
+            s.max,
+            s.mean,
+            s.stddev,
+            s.ci_low,
+            s.ci_high
+        );
+    }
+}
+
+/**
+ * @brief Quotes a string for JSON (labels are plain text, so only quotes, backslashes and control characters matter).
+ */
+static std::string json_string(std::string_view text)
+{
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            quoted += fmt::format("\\u{:04x}", c);
+        }
+        else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+/**
+ * @brief Quotes a string for CSV when it holds a separator or a quote.
+ */
+static std::string csv_field(std::string_view text)
+{
+    if (text.find_first_of(",\"\n") == std::string_view::npos) {
+        return std::string(text);
+    }
+    std::string quoted = "\"";
+    for (char c : text) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+int write_timestamps(
+    const std::string & path,
+    const std::string & format,
+    const std::vector<std::tuple<std::string, double>> & timestamps,
+    const std::vector<timing_summary> & summaries
+)
+{
+    if (format != "csv" && format != "json") {
+        spdlog::error("Unknown timing format {}", format);
+        return -1;
+    }
+    std::FILE * file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        spdlog::error("Cannot write timings to {}", path);
+        return -1;
+    }
+
+    if (format == "csv") {
+        fmt::print(file, "phase,iteration,ns\n");
+        for (const auto & [label, ns] : timestamps) {
+            auto [phase, iteration] = split_label(label);
+            fmt::print(file, "{},{},{:.0f}\n", csv_field(phase), iteration < 0 ? "" : std::to_string(iteration), ns);
+        }
+        fmt::print(file, "\nphase,samples,min,max,mean,median,p95,stddev,ci_low,ci_high\n");
+        for (const timing_summary & s : summaries) {
+            fmt::print(file, "{},{},{:.0f},{:.0f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f}\n",
+                csv_field(s.phase), s.samples, s.min, s.max, s.mean, s.median, s.p95, s.stddev, s.ci_low, s.ci_high);
+        }
+    }
+    else {
+        fmt::print(file, "{{\n  \"samples\": [");
+        for (size_t i = 0; i < timestamps.size(); ++i) {
+            auto [phase, iteration] = split_label(std::get<0>(timestamps[i]));
+            fmt::print(file, "{}\n    {{\"phase\": {}, \"iteration\": {}, \"ns\": {:.0f}}}",
+                i == 0 ? "" : ",", json_string(phase), iteration < 0 ? "null" : std::to_string(iteration), std::get<1>(timestamps[i]));
+        }
+        fmt::print(file, "\n  ],\n  \"summaries\": [");
+        for (size_t i = 0; i < summaries.size(); ++i) {
+            const timing_summary & s = summaries[i];
+            fmt::print(file,
+                "{}\n    {{\"phase\": {}, \"samples\": {}, \"min\": {:.0f}, \"max\": {:.0f}, \"mean\": {:.1f}, \"median\": {:.1f}, "
+                "\"p95\": {:.1f}, \"stddev\": {:.1f}, \"ci_low\": {:.1f}, \"ci_high\": {:.1f}}}",
+                i == 0 ? "" : ",", json_string(s.phase), s.samples, s.min, s.max, s.mean, s.median, s.p95, s.stddev, s.ci_low, s.ci_high);
+        }
+        fmt::print(file, "\n  ]\n}}\n");
+    }
+    int status = std::fclose(file) == 0 ? 1 : -1;
+    if (status == -1) {
+        spdlog::error("Cannot write timings to {}", path);
+    }
+    return status;
+}
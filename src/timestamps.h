@@ -3,6 +3,24 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <tuple>
+
+/**
+ * @brief Order statistics of the samples of one phase, as computed by `summarize_timestamps`. All times in ns.
+ */
+struct timing_summary {
+    std::string phase;      // Label without the ", iteration: N" suffix
+    int samples;
+    double min;
+    double max;
+    double mean;
+    double median;
+    double p95;             // 95th percentile, linearly interpolated between the nearest ranks
+    double stddev;          // Sample standard deviation, `0` for a single sample
+    double ci_low;          // 95% confidence interval of the mean (Student's t), equal to `mean` for one sample
+    double ci_high;
+};
 
 /**
  * @brief Records a labeled timestamp into a collection of timestamps.
@@ -60,4 +78,55 @@ double compute_average(
     std::vector<std::tuple<std::string, double>> & timestamps
 );
 
+/**
+ * @brief Returns the phase of a timestamp label: the label without a trailing `, iteration: N`.
+ * 
+ * @param label A label passed to `mark_time`, e.g. "Zero-copy block time, iteration: 3".
+ * @return std::string The phase, e.g. "Zero-copy block time". Labels without the suffix are their own phase.
+ */
+std::string timestamp_phase(
+    std::string_view label
+);
+
+/**
+ * @brief Groups labeled timestamps by phase and computes the statistics of each phase.
+ * 
+ * @param timestamps Labeled times in ns, as recorded by `mark_time`.
+ * @return std::vector<timing_summary> One summary per phase, in order of the first sample of each phase.
+ * 
+ * @details Unlike `compute_average`, the median and the 95th percentile are robust against a single
+ *          outlier, such as a cold first run or a neighbour on a shared host.
+ */
+std::vector<timing_summary> summarize_timestamps(
+    const std::vector<std::tuple<std::string, double>> & timestamps
+);
+
+/**
+ * @brief Outputs one line of statistics per phase to the console, in ns.
+ */
+void print_summaries(
+    const std::vector<timing_summary> & summaries
+);
+
+/**
+ * @brief Writes the raw timestamps and their per-phase statistics to a file.
+ * 
+ * @param path The file to write; it is replaced.
+ * @param format `csv` or `json`.
+ * @param timestamps Labeled times in ns, as recorded by `mark_time`.
+ * @param summaries The statistics from `summarize_timestamps`.
+ * @return int Returns `1` on success, or `-1` if the file cannot be written or the format is unknown.
+ * 
+ * @details
+ * - **CSV**: A `phase,iteration,ns` row per sample (iteration empty for labels without one), then a blank line
+ *   and a `phase,samples,min,max,mean,median,p95,stddev,ci_low,ci_high` row per phase.
+ * - **JSON**: `{"samples": [{"phase", "iteration", "ns"}...], "summaries": [{"phase", "samples", "min", ...}...]}`.
+ */
+int write_timestamps(
+    const std::string & path,
+    const std::string & format,
+    const std::vector<std::tuple<std::string, double>> & timestamps,
+    const std::vector<timing_summary> & summaries
+);
+
 #endif
\ No newline at end of file
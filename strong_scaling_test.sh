@@ -1,48 +1,27 @@
 #!/bin/bash
 
-# Note: Test for strong scaling.
-# Number of vertices: 1k, 2k, 4k, 8k
-# Number of threads: 1, 2, 4, 8, 16, 32
+# Note: Test for strong scaling, run by the scaling sweep target (src/sweep.cpp).
+# Number of vertices: 500, 1k, 2k, 4k
+# Number of threads: 1, 2, 4, 8, 16, 32 (capped at the threads available)
 #
-# 1. Run 1k w/ 1, 2, 4, 8, 16, and 32 threads.
-# 2. Increment vertices.
+# Every size runs at every thread count; the sweep reports speedup, parallel efficiency and
+# achieved bandwidth against the STREAM triad roofline of each thread count.
 
 # Variables
 # Replace with relative path to executable.
-EXECUTABLE="./build-release/bin/floyd_warshall"						# Path to executable
-OUTPUT_FILE="strong_n_results.txt"								# File to store the output
-VERTICE_ITERS=4											# Vertices are incremented in outter loop. 
-THREAD_ITERS=6											# Threads are incremented in inner loop.
-STEPS=1
+EXECUTABLE="./build-release/bin/scaling"							# Path to executable
+OUTPUT_FILE="strong_n_results.csv"								# File to store the output (csv or json)
+FORMAT="csv"
 
-MODE="-n"											# -s: sequential, -n: naive, -b: blocked
-THREADS=1											# Starting thread count
-MAX_THREADS=32											# Maximum number of threads available on system.
-VERTICES=500											# Starting number of vertices
-MAX_VERTICES=4000										# Maximum number of vertices
-EDGES=500											# Number of edges
+STEPS=1
+KERNELS="naive"											# Any of: serial naive blocked zero-copy task recursive ...
+THREADS="1 2 4 8 16 32"										# Thread counts
+VERTICES="500 1000 2000 4000"									# Vertex counts
+EDGE_FACTOR=1											# Edges per vertex
 LENGTH=20											# Tile length
+BIND="spread"											# Thread pinning: none, close, spread (spread uses every socket's bandwidth)
 
-
-# Clear the output file if it exists
->"$OUTPUT_FILE"
-
-# Loop to run the executable
-for ((i=0; i < VERTICE_ITERS; i++)); do
-	for ((j=0; j < THREAD_ITERS; j++)); do
-		echo "Run with $VERTICES Vertices and $THREADS Threads"
-		echo "Run with $VERTICES Vertices and $THREADS Threads" >> "$OUTPUT_FILE"
-		$EXECUTABLE $MODE -t $THREADS -e $EDGES -v $VERTICES -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-		echo "" >> "$OUTPUT_FILE"
-
-		if ((THREADS < MAX_THREADS)); then
-			THREADS=$((THREADS * 2))
-		else
-			THREADS=1
-		fi
-	done
-	VERTICES=$((VERTICES * 2))
-done
+$EXECUTABLE -k $KERNELS -v $VERTICES -t $THREADS -l $LENGTH -e $EDGE_FACTOR -i $STEPS --bind $BIND --output "$OUTPUT_FILE" --format $FORMAT
 
 # Output message
-echo "Finished running $EXECUTABLE $OUTTER_ITERS times, Output saved to $OUTPUT_FILE."
+echo "Finished running $EXECUTABLE, Output saved to $OUTPUT_FILE."
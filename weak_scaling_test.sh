@@ -1,66 +1,25 @@
 #!/bin/bash
 
-# Note: Test for strong scaling.
-# Number of vertices: 1k, 2k, 4k, 8k
-# Number of threads: 1, 2, 4, 8, 16, 32
+# Note: Test for weak scaling, run by the scaling sweep target (src/sweep.cpp).
+# Number of threads: 1, 2, 4, 8, 16, 32 (capped at the threads available)
 #
-# 1. Run 1k w/ 1, 2, 4, 8, 16, and 32 threads.
-# 2. Increment vertices.
+# The sweep sizes every run as n = 1000 * cbrt(threads), so n^3 / threads stays constant
+# (1000, 1260, 1587, 2000, 2520, 3175 vertices), and reports the weak-scaling efficiency.
 
 # Variables
 # Replace with path to executable.
-EXECUTABLE="./build-release/bin/floyd_warshall"						# Path to executable
-OUTPUT_FILE="weak_b_results.txt"								# File to store the output
+EXECUTABLE="./build-release/bin/scaling"							# Path to executable
+OUTPUT_FILE="weak_b_results.csv"								# File to store the output (csv or json)
+FORMAT="csv"
 
 STEPS=5
-
-MODE="-b"											# -s: sequential, -n: naive, -b: blocked
-
-# Hard coding threads b/c vertices must be hard coded.
-THREAD0=1												
-THREAD1=2
-THREAD2=4
-THREAD3=8
-THREAD4=16
-THREAD5=32
-# Hard coding the vertices sizes b/c the number of vertices must be divisible by block length.
-VERTICE0=1000											# #Vertices for 1 thread.
-VERTICE1=1200											# #Vertices for 2 threads.
-VERTICE2=1600											# #Vertices for 4 threads.
-VERTICE3=2000											# #Vertices for 8 threads.
-VERTICE4=2600											# #Vertices for 16 threads.
-VERTICE5=3000											# #Vertices for 32 threads.
-
-EDGES=1000											# Number of edges
+KERNELS="blocked"										# Any of: serial naive blocked zero-copy task recursive ...
+THREADS="1 2 4 8 16 32"										# Thread counts
+VERTICES=1000											# Vertices at the first thread count
+EDGE_FACTOR=1											# Edges per vertex
 LENGTH=20											# Block length
 
-
-# Clear the output file if it exists
->"$OUTPUT_FILE"
-
-echo "Run with $VERTICE0 Vertices and $THREAD0 Threads" >> "$OUTPUT_FILE"
-$EXECUTABLE $MODE -t $THREAD0 -e $EDGES -v $VERTICE0 -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
-
-echo "Run with $VERTICE1 Vertices and $THREAD1 Threads" >> "$OUTPUT_FILE"
-$EXECUTABLE $MODE -t $THREAD1 -e $EDGES -v $VERTICE1 -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
-
-echo "Run with $VERTICE2 Vertices and $THREAD2 Threads" >> "$OUTPUT_FILE"
-$EXECUTABLE $MODE -t $THREAD2 -e $EDGES -v $VERTICE2 -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
-
-echo "Run with $VERTICE3 Vertices and $THREAD3 Threads" >> "$OUTPUT_FILE"
-$EXECUTABLE $MODE -t $THREAD3 -e $EDGES -v $VERTICE3 -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
-
-echo "Run with $VERTICE4 Vertices and $THREAD4 Threads" >> "$OUTPUT_FILE"
-$EXECUTABLE $MODE -t $THREAD4 -e $EDGES -v $VERTICE4 -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
-
-echo "Run with $VERTICE5 Vertices and $THREAD5 Threads" >> "$OUTPUT_FILE"
-$EXECUTABLE $MODE -t $THREAD5 -e $EDGES -v $VERTICE5 -l $LENGTH -i $STEPS>> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
+$EXECUTABLE -k $KERNELS -w $VERTICES -t $THREADS -l $LENGTH -e $EDGE_FACTOR -i $STEPS --output "$OUTPUT_FILE" --format $FORMAT
 
 # Output message
-echo "Finished running $EXECUTABLE $OUTTER_ITERS times, Output saved to $OUTPUT_FILE."
+echo "Finished running $EXECUTABLE, Output saved to $OUTPUT_FILE."